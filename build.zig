@@ -60,6 +60,43 @@ const EXAMPLES = [_]Example{
             .glm = true,
         },
     },
+    .{
+        .name = "brdflut",
+        .files = &.{
+            "example/brdflut/main.cpp",
+        },
+        .using = .{
+            .imgui = false,
+        },
+    },
+    .{
+        .name = "meshopt",
+        .files = &.{
+            "example/meshopt/main.cpp",
+        },
+        .using = .{
+            .imgui = false,
+        },
+    },
+    .{
+        .name = "drawbench",
+        .files = &.{
+            "example/drawbench/main.cpp",
+        },
+        .using = .{
+            .imgui = false,
+        },
+    },
+    .{
+        .name = "texconv",
+        .files = &.{
+            "example/texconv/main.cpp",
+        },
+        .using = .{
+            .imgui = false,
+            .stb = true,
+        },
+    },
     // .{
     //     .name = "dx11",
     //     .files = &.{
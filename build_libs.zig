@@ -166,8 +166,18 @@ pub fn make_grapho(
         .root = dep.path(""),
         .files = &.{
             "grapho/vars.cpp",
+            "grapho/bcencoder.cpp",
             "grapho/camera/camera.cpp",
             "grapho/camera/ray.cpp",
+            "grapho/ibl/baker.cpp",
+            "grapho/ibl/cache.cpp",
+            "grapho/ibl/sh.cpp",
+            "grapho/mappedfile.cpp",
+            "grapho/meshgenerator.cpp",
+            "grapho/meshoptimizer.cpp",
+            "grapho/meshquantizer.cpp",
+            "grapho/mipchain.cpp",
+            "grapho/texturefile.cpp",
         },
         .flags = &CFLAGS,
     });
@@ -181,6 +191,16 @@ pub fn make_grapho(
             "grapho/gl3/cuberenderer.cpp",
             "grapho/gl3/fbo.cpp",
             "grapho/gl3/error_check.cpp",
+            "grapho/gl3/ringbuffer.cpp",
+            "grapho/gl3/statecache.cpp",
+            "grapho/gl3/commandqueue.cpp",
+            "grapho/gl3/geometryarena.cpp",
+            "grapho/gl3/meshbuffer.cpp",
+            "grapho/gl3/texturestreamer.cpp",
+            "grapho/gl3/sampler.cpp",
+            "grapho/gl3/programcache.cpp",
+            "grapho/gl3/shaderbatch.cpp",
+            "grapho/gl3/uniformblock.cpp",
         },
         .flags = &CFLAGS,
     });
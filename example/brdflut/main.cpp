@@ -0,0 +1,66 @@
+// writes the split sum BRDF LUT as a c++ header.
+// src/grapho/ibl/brdflut_table.h is generated by
+//
+// brdflut src/grapho/ibl/brdflut_table.h
+#include <fstream>
+#include <grapho/half.h>
+#include <grapho/ibl/baker.h>
+#include <iostream>
+#include <stdio.h>
+#include <string>
+
+int
+main(int argc, char** argv)
+{
+  if (argc < 2) {
+    std::cout << "usage: " << argv[0] << " {output.h} [size] [sample count]"
+              << std::endl;
+    return 1;
+  }
+  int size = 64;
+  if (argc >= 3) {
+    size = std::stoi(argv[2]);
+  }
+  uint32_t sampleCount = 1024;
+  if (argc >= 4) {
+    sampleCount = std::stoi(argv[3]);
+  }
+
+  auto lut = grapho::ibl::BakeBrdfLUT(size, sampleCount);
+
+  std::ofstream os(argv[1]);
+  if (!os) {
+    std::cout << "fail to open: " << argv[1] << std::endl;
+    return 2;
+  }
+  os << "#pragma once" << std::endl;
+  os << "#include <stdint.h>" << std::endl << std::endl;
+  os << "// generated by example/brdflut. do not edit." << std::endl;
+  os << "// " << sampleCount << " samples per texel." << std::endl
+     << std::endl;
+  os << "namespace grapho {" << std::endl;
+  os << "namespace ibl {" << std::endl << std::endl;
+  os << "inline constexpr int BRDF_LUT_SIZE = " << size << ";" << std::endl
+     << std::endl;
+  os << "// rg half float, row 0 first. x: NdotV, y: roughness" << std::endl;
+  os << "inline constexpr uint16_t BRDF_LUT[] = {" << std::endl;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      auto p = lut.Texel(x, y);
+      char buf[32];
+      snprintf(buf,
+               sizeof(buf),
+               "0x%04x,0x%04x,",
+               grapho::FloatToHalf(p[0]),
+               grapho::FloatToHalf(p[1]));
+      // 6 texels per line
+      os << (x % 6 == 0 ? "  " : "") << buf
+         << (x % 6 == 5 || x == size - 1 ? "\n" : "");
+    }
+  }
+  os << "};" << std::endl << std::endl;
+  os << "}" << std::endl;
+  os << "}" << std::endl;
+
+  return 0;
+}
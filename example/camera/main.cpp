@@ -7,6 +7,7 @@
 #include <grapho/gl3/error_check.h>
 #include <grapho/gl3/fbo.h>
 #include <grapho/gl3/shader.h>
+#include <grapho/gl3/statecache.h>
 #include <grapho/gl3/vao.h>
 #include <grapho/imgui/dockspace.h>
 #include <grapho/imgui/widgets.h>
@@ -227,6 +228,8 @@ public:
   {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // the imgui backend binds with raw GL calls
+    grapho::gl3::StateCache::Current().Invalidate();
   }
 };
 
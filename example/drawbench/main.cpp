@@ -0,0 +1,373 @@
+// cpu cost of submitting many small draws.
+//
+// per object ubo: Ubo::Upload and SetBindingPoint before each draw. the
+//                 same as the original pbr Drawable.
+// batch:          all objects in one UniformBatch, glBindBufferRange per draw.
+// queue:          the batch recorded to a CommandQueue, sorted and executed.
+// instanced:      LocalVars as instance attributes of the queue. one draw.
+// multi draw:     the quads in a MeshBuffer, object data from a texture
+//                 buffer by draw id. indirect and the GL 3.3 fallback.
+//
+// usage: drawbench [object count]
+#include "glfw_platform.h"
+#include <GL/glew.h>
+#include <chrono>
+#include <functional>
+#include <grapho/gl3/commandqueue.h>
+#include <grapho/gl3/meshbuffer.h>
+#include <grapho/gl3/shader.h>
+#include <grapho/gl3/statecache.h>
+#include <grapho/gl3/ubo.h>
+#include <grapho/gl3/uniformbatch.h>
+#include <grapho/gl3/vao.h>
+#include <grapho/meshgenerator.h>
+#include <grapho/vars.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const auto FRAMES = 60;
+
+static const auto vs = u8R"(#version 330
+layout(location = 0) in vec3 aPos;
+layout(std140) uniform ModelVars
+{
+  mat4 model;
+  vec4 color;
+  vec4 cutoff;
+  mat4 normalMatrix;
+}
+Model;
+out vec4 vColor;
+void main()
+{
+  gl_Position = Model.model * vec4(aPos, 1.0);
+  vColor = Model.color;
+}
+)";
+
+static const auto vs_instanced = u8R"(#version 330
+layout(location = 0) in vec3 aPos;
+layout(location = 4) in mat4 iModel;
+layout(location = 8) in vec4 iColor;
+out vec4 vColor;
+void main()
+{
+  gl_Position = iModel * vec4(aPos, 1.0);
+  vColor = iColor;
+}
+)";
+
+// model columns and color, 5 texels per object
+static const auto vs_drawid = u8R"(#version 330
+layout(location = 0) in vec3 aPos;
+layout(location = 15) in float aDrawId;
+uniform samplerBuffer uObjects;
+out vec4 vColor;
+void main()
+{
+  int base = int(aDrawId) * 5;
+  mat4 model = mat4(texelFetch(uObjects, base),
+                    texelFetch(uObjects, base + 1),
+                    texelFetch(uObjects, base + 2),
+                    texelFetch(uObjects, base + 3));
+  gl_Position = model * vec4(aPos, 1.0);
+  vColor = texelFetch(uObjects, base + 4);
+}
+)";
+
+static const auto fs = u8R"(#version 330
+in vec4 vColor;
+out vec4 FragColor;
+void main()
+{
+  FragColor = vColor;
+}
+)";
+
+struct Scene
+{
+  std::shared_ptr<grapho::gl3::ShaderProgram> Shader;
+  std::shared_ptr<grapho::gl3::Vao> Quad;
+  uint32_t QuadDrawCount = 0;
+  uint32_t QuadDrawMode = 0;
+  std::vector<grapho::LocalVars> Objects;
+};
+
+struct Result
+{
+  // submission only
+  double CpuMs = 0;
+  // including glFinish
+  double FrameMs = 0;
+  // StateCache binds per frame
+  uint32_t Binds = 0;
+  uint32_t Filtered = 0;
+};
+
+static Result
+Measure(Scene& scene,
+        const std::function<void()>& begin,
+        const std::function<void(uint32_t)>& draw,
+        const std::function<void()>& end)
+{
+  Result result;
+  auto& state = grapho::gl3::StateCache::Current();
+  state.TakeCounters();
+  for (int frame = 0; frame < FRAMES; ++frame) {
+    glClear(GL_COLOR_BUFFER_BIT);
+    auto start = std::chrono::steady_clock::now();
+    scene.Shader->Use();
+    begin();
+    for (uint32_t i = 0; i < scene.Objects.size(); ++i) {
+      draw(i);
+    }
+    end();
+    auto submitted = std::chrono::steady_clock::now();
+    glFinish();
+    auto finished = std::chrono::steady_clock::now();
+    result.CpuMs +=
+      std::chrono::duration<double, std::milli>(submitted - start).count();
+    result.FrameMs +=
+      std::chrono::duration<double, std::milli>(finished - start).count();
+  }
+  auto counters = state.TakeCounters();
+  result.Binds = counters.Calls() / FRAMES;
+  result.Filtered = counters.Filtered() / FRAMES;
+  result.CpuMs /= FRAMES;
+  result.FrameMs /= FRAMES;
+  return result;
+}
+
+static void
+Report(const char* name, const Result& result, uint32_t count)
+{
+  printf("%-24s: submit %7.3fms (%.3fus/draw), frame %7.3fms, binds %u "
+         "(%u filtered)\n",
+         name,
+         result.CpuMs,
+         result.CpuMs * 1000.0 / count,
+         result.FrameMs,
+         result.Binds,
+         result.Filtered);
+}
+
+int
+main(int argc, char** argv)
+{
+  uint32_t count = 10000;
+  if (argc >= 2) {
+    count = atoi(argv[1]);
+  }
+
+  GlfwPlatform platform;
+  if (!platform.CreateWindow("drawbench", 640, 480)) {
+    return 1;
+  }
+  if (glewInit() != GLEW_OK) {
+    return 2;
+  }
+  printf("GL_RENDERER: %s\n", glGetString(GL_RENDERER));
+  printf("GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: %u\n",
+         grapho::gl3::UniformBufferOffsetAlignment());
+
+  Scene scene;
+  scene.Shader = grapho::gl3::ShaderProgram::Create(vs, fs);
+  if (!scene.Shader) {
+    return 3;
+  }
+  auto blockIndex = scene.Shader->UboBlockIndex("ModelVars");
+  if (!blockIndex) {
+    return 4;
+  }
+  scene.Shader->UboBind(*blockIndex, 1);
+
+  auto quad = grapho::mesh::Generate(grapho::mesh::PlaneShape{ 0.02f, 0.02f });
+  scene.Quad = grapho::gl3::Vao::Create(quad);
+  scene.QuadDrawCount = quad->DrawCount();
+  scene.QuadDrawMode = *grapho::gl3::GLMode(quad->Mode);
+
+  // a grid of quads over the viewport
+  uint32_t side = 1;
+  while (side * side < count) {
+    ++side;
+  }
+  scene.Objects.resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto& vars = scene.Objects[i];
+    vars = {};
+    vars.model = {
+      1, 0, 0, 0, //
+      0, 1, 0, 0, //
+      0, 0, 1, 0, //
+      (i % side + 0.5f) / side * 2 - 1,
+      (i / side + 0.5f) / side * 2 - 1,
+      0,
+      1,
+    };
+    vars.color = { (i % 7) / 7.0f, (i % 11) / 11.0f, (i % 13) / 13.0f, 1 };
+    vars.CalcNormalMatrix();
+  }
+  printf("objects: %u, frames: %d\n", count, FRAMES);
+
+  {
+    std::vector<std::shared_ptr<grapho::gl3::Ubo>> ubos;
+    for (uint32_t i = 0; i < count; ++i) {
+      ubos.push_back(
+        grapho::gl3::Ubo::Create(sizeof(grapho::LocalVars), nullptr));
+    }
+    auto result = Measure(
+      scene,
+      []() {},
+      [&scene, &ubos](uint32_t i) {
+        ubos[i]->Upload(scene.Objects[i]);
+        ubos[i]->Bind();
+        ubos[i]->SetBindingPoint(1);
+        scene.Quad->Draw(scene.QuadDrawMode, scene.QuadDrawCount);
+      },
+      []() {});
+    Report("per object ubo", result, count);
+  }
+
+  for (auto persistent : { true, false }) {
+    auto batch = grapho::gl3::UniformBatch<grapho::LocalVars>::Create(
+      count, 3, persistent);
+    auto result = Measure(
+      scene,
+      [&scene, &batch]() {
+        if (!batch->Begin(scene.Objects.size())) {
+          return;
+        }
+        for (uint32_t i = 0; i < scene.Objects.size(); ++i) {
+          batch->Set(i, scene.Objects[i]);
+        }
+        batch->Flush();
+      },
+      [&scene, &batch](uint32_t i) {
+        batch->BindRange(1, i);
+        scene.Quad->Draw(scene.QuadDrawMode, scene.QuadDrawCount);
+      },
+      [&batch]() { batch->EndFrame(); });
+    Report(batch->Ring()->IsPersistent() ? "batch (persistent)"
+                                         : "batch (orphaning)",
+           result,
+           count);
+  }
+
+  {
+    auto batch = grapho::gl3::UniformBatch<grapho::LocalVars>::Create(count);
+    grapho::gl3::CommandQueue queue;
+    auto result = Measure(
+      scene,
+      [&scene, &batch]() {
+        if (!batch->Begin(scene.Objects.size())) {
+          return;
+        }
+        for (uint32_t i = 0; i < scene.Objects.size(); ++i) {
+          batch->Set(i, scene.Objects[i]);
+        }
+        batch->Flush();
+      },
+      [&scene, &batch, &queue](uint32_t i) {
+        queue.Push({
+          .Depth = static_cast<float>(i) / scene.Objects.size(),
+          .Program = scene.Shader.get(),
+          .Vao = scene.Quad.get(),
+          .Mode = scene.QuadDrawMode,
+          .Count = scene.QuadDrawCount,
+          .ObjectBuffer = batch->Buffer(),
+          .ObjectOffset = batch->Offset(i),
+          .ObjectSize = batch->Stride(),
+        });
+      },
+      [&batch, &queue]() {
+        queue.Execute();
+        batch->EndFrame();
+      });
+    Report("queue", result, count);
+  }
+
+  {
+    auto shader = grapho::gl3::ShaderProgram::Create(vs_instanced, fs);
+    if (!shader) {
+      return 5;
+    }
+    grapho::gl3::CommandQueue queue;
+    queue.EnableInstancing(grapho::LocalVarsInstanceLayouts(),
+                           sizeof(grapho::LocalVars));
+    grapho::gl3::CommandQueueStatistics stats;
+    auto result = Measure(
+      scene,
+      []() {},
+      [&scene, &shader, &queue](uint32_t i) {
+        queue.Push({
+          .Depth = static_cast<float>(i) / scene.Objects.size(),
+          .Program = shader.get(),
+          .Vao = scene.Quad.get(),
+          .Mode = scene.QuadDrawMode,
+          .Count = scene.QuadDrawCount,
+          .Instance = &scene.Objects[i],
+        });
+      },
+      [&queue, &stats]() { stats = queue.Execute(); });
+    Report("instanced", result, count);
+    printf("  %u draws for %u instances\n", stats.Draws, stats.Instances);
+  }
+
+  {
+    auto shader = grapho::gl3::ShaderProgram::Create(vs_drawid, fs);
+    if (!shader) {
+      return 6;
+    }
+    std::vector<grapho::XMFLOAT4> texels;
+    for (auto& vars : scene.Objects) {
+      auto model = reinterpret_cast<const grapho::XMFLOAT4*>(&vars.model);
+      texels.insert(texels.end(), model, model + 4);
+      texels.push_back(vars.color);
+    }
+    auto& state = grapho::gl3::StateCache::Current();
+    GLuint objects;
+    glGenBuffers(1, &objects);
+    state.BindBuffer(GL_TEXTURE_BUFFER, objects);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 texels.size() * sizeof(grapho::XMFLOAT4),
+                 texels.data(),
+                 GL_STATIC_DRAW);
+    GLuint objectTexture;
+    glGenTextures(1, &objectTexture);
+    state.BindTexture(0, GL_TEXTURE_BUFFER, objectTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, objects);
+
+    for (auto indirect : { true, false }) {
+      auto buffer = grapho::gl3::MeshBuffer::Create(quad->Layouts,
+                                                    quad->Mode,
+                                                    quad->Vertices.Count,
+                                                    quad->DrawCount(),
+                                                    count,
+                                                    15,
+                                                    indirect);
+      auto mesh = buffer->Add(*quad);
+      if (!mesh) {
+        return 7;
+      }
+      auto result = Measure(
+        scene,
+        [&shader, &state, objectTexture]() {
+          shader->Use();
+          state.BindTexture(0, GL_TEXTURE_BUFFER, objectTexture);
+        },
+        [&buffer, &mesh](uint32_t i) { buffer->Push(*mesh); },
+        [&buffer]() { buffer->Draw(); });
+      Report(buffer->IsIndirect() ? "multi draw (indirect)"
+                                  : "multi draw (fallback)",
+             result,
+             count);
+    }
+
+    glDeleteTextures(1, &objectTexture);
+    state.DeletedTexture(objectTexture);
+    glDeleteBuffers(1, &objects);
+    state.DeletedBuffer(objects);
+  }
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+// reports the vertex cache efficiency before and after mesh::Optimize.
+//
+// ACMR: transformed vertices per triangle. lower is better.
+// ATVR: transformed vertices per vertex. 1.0 is optimal.
+#include <algorithm>
+#include <chrono>
+#include <grapho/mesh.h>
+#include <grapho/meshoptimizer.h>
+#include <grapho/meshquantizer.h>
+#include <random>
+#include <stdio.h>
+
+static void
+Report(const char* name, const grapho::Mesh& mesh)
+{
+  auto before = grapho::mesh::AnalyzeVertexCache(
+    grapho::mesh::TriangleIndices(mesh), mesh.Vertices.Count);
+
+  auto start = std::chrono::steady_clock::now();
+  auto optimized = grapho::mesh::Optimize(mesh);
+  auto end = std::chrono::steady_clock::now();
+  if (!optimized) {
+    printf("%-10s: not supported\n", name);
+    return;
+  }
+  auto after = grapho::mesh::AnalyzeVertexCache(
+    grapho::mesh::TriangleIndices(*optimized), optimized->Vertices.Count);
+
+  printf("%-10s: vertices %6u => %6u, ACMR %.3f => %.3f, ATVR %.3f => "
+         "%.3f, index bytes %7u => %7u, %.2fms\n",
+         name,
+         mesh.Vertices.Count,
+         optimized->Vertices.Count,
+         before.Acmr,
+         after.Acmr,
+         before.Atvr,
+         after.Atvr,
+         mesh.Indices.Size(),
+         optimized->Indices.Size(),
+         std::chrono::duration<double, std::milli>(end - start).count());
+
+  if (auto quantized = grapho::mesh::Quantize(*optimized)) {
+    printf("%-10s: vertex bytes %7u => %7u quantized\n",
+           "",
+           optimized->Vertices.Size(),
+           quantized->Mesh->Vertices.Size());
+  }
+}
+
+// triangle list in random order. typical of a mesh from a naive exporter.
+static std::shared_ptr<grapho::Mesh>
+Shuffle(const grapho::Mesh& mesh)
+{
+  auto indices = grapho::mesh::TriangleIndices(mesh);
+  std::vector<uint32_t> order(indices.size() / 3);
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(0));
+  std::vector<uint32_t> shuffled;
+  shuffled.reserve(indices.size());
+  for (auto t : order) {
+    shuffled.insert(shuffled.end(),
+                    indices.begin() + t * 3,
+                    indices.begin() + t * 3 + 3);
+  }
+  auto ptr = std::make_shared<grapho::Mesh>(mesh);
+  ptr->Mode = grapho::DrawMode::Triangles;
+  ptr->Indices.Assign(shuffled);
+  return ptr;
+}
+
+int
+main(int argc, char** argv)
+{
+  Report("cube", *grapho::mesh::Cube());
+  auto sphere = grapho::mesh::Sphere();
+  Report("sphere", *sphere);
+  Report("shuffled", *Shuffle(*sphere));
+  return 0;
+}
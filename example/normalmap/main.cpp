@@ -14,6 +14,7 @@
 #include <grapho/gl3/fbo.h>
 #include <grapho/gl3/shader.h>
 #include <grapho/gl3/shadergenerator.h>
+#include <grapho/gl3/statecache.h>
 #include <grapho/imgui/dockspace.h>
 #include <grapho/imgui/widgets.h>
 #include <grapho/shadersnippet.h>
@@ -96,6 +97,8 @@ public:
 
   void ShowGui()
   {
+    ImGui::Checkbox("normal map", &m_scene.UseNormalMap);
+
     // get and update fbo size
     auto size = ImGui::GetContentRegionAvail();
     auto texture = m_fbo.Bind(
@@ -148,6 +151,8 @@ public:
   {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // the imgui backend binds with raw GL calls
+    grapho::gl3::StateCache::Current().Invalidate();
   }
 };
 
@@ -2,5 +2,3 @@
 
 unsigned int
 loadTexture(const char* path);
-void
-renderQuad();
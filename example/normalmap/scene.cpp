@@ -5,6 +5,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <grapho/gl3/shader.h>
 #include <grapho/gl3/shadergenerator.h>
+#include <grapho/gl3/shadervariants.h>
+#include <grapho/gl3/statecache.h>
+#include <grapho/gl3/vao.h>
+#include <grapho/meshgenerator.h>
 #include <grapho/shadersnippet.h>
 #include <iostream>
 
@@ -12,11 +16,11 @@ bool
 Scene::Initialize(const std::string& dir)
 {
   grapho::VertexAndFragment snippet;
+  NormalMapFeature = snippet.Feature("NORMAL_MAP");
   snippet.Attribute(grapho::ShaderTypes::vec3, "aPos");
   snippet.Attribute(grapho::ShaderTypes::vec3, "aNormal");
   snippet.Attribute(grapho::ShaderTypes::vec2, "aTexCoords");
-  snippet.Attribute(grapho::ShaderTypes::vec3, "aTangent");
-  snippet.Attribute(grapho::ShaderTypes::vec3, "aBitangent");
+  snippet.Attribute(grapho::ShaderTypes::vec4, "aTangent");
   snippet.VsToFs(grapho::ShaderTypes::vec3, "FragPos");
   snippet.VsToFs(grapho::ShaderTypes::vec2, "TexCoords");
   snippet.VsToFs(grapho::ShaderTypes::vec3, "TangentLightPos");
@@ -34,10 +38,10 @@ void main()
     vs_out.TexCoords = aTexCoords;
     
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
     vec3 N = normalize(normalMatrix * aNormal);
     T = normalize(T - dot(T, N) * N);
-    vec3 B = cross(N, T);
+    vec3 B = cross(N, T) * aTangent.w;
     
     mat3 TBN = transpose(mat3(T, B, N));    
     vs_out.TangentLightPos = TBN * lightPos;
@@ -47,21 +51,23 @@ void main()
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
 )");
-  auto vs = grapho::gl3::GenerateVS(snippet);
-  std::cout << "####################" << std::endl
-            << vs << std::endl
-            << "####################" << std::endl;
 
   snippet.Out(grapho::ShaderTypes::vec4, "FragColor");
   snippet.Uniform(grapho::ShaderTypes::sampler2D, "diffuseMap");
-  snippet.Uniform(grapho::ShaderTypes::sampler2D, "normalMap");
+  snippet.Uniform(
+    grapho::ShaderTypes::sampler2D, "normalMap", NormalMapFeature);
   snippet.FsEntry(R"(
 void main()
 {           
+#ifdef NORMAL_MAP
     // obtain normal from normal map in range [0,1]
     vec3 normal = texture(normalMap, fs_in.TexCoords).rgb;
     // transform normal vector to range [-1,1]
     normal = normalize(normal * 2.0 - 1.0);  // this normal is in tangent space
+#else
+    // the surface normal in tangent space
+    vec3 normal = vec3(0.0, 0.0, 1.0);
+#endif
    
     // get diffuse color
     vec3 color = texture(diffuseMap, fs_in.TexCoords).rgb;
@@ -82,20 +88,38 @@ void main()
     // FragColor = vec4(vec3(diff), 1.0);
     // FragColor = texture(normalMap, fs_in.TexCoords);
 })");
-  auto fs = grapho::gl3::GenerateFS(snippet);
-
   std::cout << "####################" << std::endl
-            << fs << std::endl
+            << grapho::gl3::GenerateVS(snippet, NormalMapFeature) << std::endl
+            << "####################" << std::endl
+            << grapho::gl3::GenerateFS(snippet, NormalMapFeature) << std::endl
             << "####################" << std::endl;
 
   // build and compile shaders
   // -------------------------
-  Shader = grapho::gl3::ShaderProgram::Create(vs, fs);
-  if (!Shader) {
-    // std::cout << result.error() << std::endl;
-    return false;
+  Shaders = grapho::gl3::ShaderVariants::Create(snippet);
+  uint32_t variants[] = { 0, NormalMapFeature };
+  Shaders->Prepare(variants);
+  for (auto features : variants) {
+    auto shader = Shaders->Get(features);
+    if (!shader) {
+      // std::cout << result.error() << std::endl;
+      return false;
+    }
+    // shader configuration
+    // --------------------
+    shader->Use();
+    shader->SetUniform("diffuseMap", 0);
+    if (features & NormalMapFeature) {
+      shader->SetUniform("normalMap", 1);
+    }
   }
 
+  // 1x1 quad with MikkTSpace tangents
+  auto quad = grapho::mesh::Generate(grapho::mesh::PlaneShape{},
+                                     { .Tangents = true });
+  Quad = grapho::gl3::Vao::Create(quad);
+  QuadDrawCount = quad->DrawCount();
+
   // load textures
   // -------------
   DiffuseMap = loadTexture(
@@ -103,15 +127,16 @@ void main()
   NormalMap = loadTexture(
     grapho::join_path(dir, "resources/textures/brickwall_normal.jpg").c_str());
 
-  // shader configuration
-  // --------------------
-  Shader->Use();
-  Shader->SetUniform("diffuseMap", 0);
-  Shader->SetUniform("normalMap", 1);
-
   return true;
 }
 
+// hashed at compile time
+constexpr grapho::gl3::UniformName PROJECTION("projection");
+constexpr grapho::gl3::UniformName VIEW("view");
+constexpr grapho::gl3::UniformName VIEW_POS("viewPos");
+constexpr grapho::gl3::UniformName LIGHT_POS("lightPos");
+constexpr grapho::gl3::UniformName MODEL("model");
+
 void
 Scene::Render(float deltaTime,
               const grapho::XMFLOAT4X4& projection,
@@ -119,11 +144,12 @@ Scene::Render(float deltaTime,
               const grapho::XMFLOAT3& cameraPosition)
 {
   glEnable(GL_DEPTH_TEST);
-  Shader->Use();
-  Shader->SetUniform("projection", projection);
-  Shader->SetUniform("view", view);
-  Shader->SetUniform("viewPos", cameraPosition);
-  Shader->SetUniform("lightPos", LightPos);
+  auto shader = Shaders->Get(UseNormalMap ? NormalMapFeature : 0);
+  shader->Use();
+  shader->SetUniform(PROJECTION, projection);
+  shader->SetUniform(VIEW, view);
+  shader->SetUniform(VIEW_POS, cameraPosition);
+  shader->SetUniform(LIGHT_POS, LightPos);
 
   {
     Time += deltaTime;
@@ -135,12 +161,11 @@ Scene::Render(float deltaTime,
                           1.0, 0.0, 1.0))); // rotate the quad to show normal
                                             // mapping from multiple directions
 
-    Shader->SetUniform("model", model);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, DiffuseMap);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, NormalMap);
-    renderQuad();
+    shader->SetUniform(MODEL, model);
+    auto& state = grapho::gl3::StateCache::Current();
+    state.BindTexture(0, GL_TEXTURE_2D, DiffuseMap);
+    state.BindTexture(1, GL_TEXTURE_2D, NormalMap);
+    Quad->Draw(GL_TRIANGLES, QuadDrawCount);
   }
 
   {
@@ -149,7 +174,7 @@ Scene::Render(float deltaTime,
     auto model = glm::mat4(1.0f);
     model = glm::translate(model, LightPos);
     model = glm::scale(model, glm::vec3(0.1f));
-    Shader->SetUniform("model", model);
-    renderQuad();
+    shader->SetUniform(MODEL, model);
+    Quad->Draw(GL_TRIANGLES, QuadDrawCount);
   }
 }
@@ -6,12 +6,18 @@
 namespace grapho {
 namespace gl3 {
 class ShaderProgram;
+class ShaderVariants;
+struct Vao;
 }
 }
 
 class Scene
 {
-  std::shared_ptr<grapho::gl3::ShaderProgram> Shader;
+  // with and without NormalMapFeature
+  std::shared_ptr<grapho::gl3::ShaderVariants> Shaders;
+  uint32_t NormalMapFeature = 0;
+  std::shared_ptr<grapho::gl3::Vao> Quad;
+  uint32_t QuadDrawCount = 0;
   unsigned int DiffuseMap = 0;
   unsigned int NormalMap = 0;
 
@@ -21,6 +27,8 @@ class Scene
   glm::vec3 LightPos{ 0.5f, 1.0f, 0.3f };
 
 public:
+  bool UseNormalMap = true;
+
   bool Initialize(const std::string& dir);
 
   void Render(float deltaTime,
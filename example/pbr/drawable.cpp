@@ -3,76 +3,128 @@
 
 #include "drawable.h"
 #include "imageloader.h"
+#include <grapho/gl3/commandqueue.h>
 #include <grapho/gl3/pbr.h>
-#include <grapho/gl3/ubo.h>
+#include <grapho/gl3/texturestreamer.h>
+#include <grapho/gl3/uniformbatch.h>
 #include <grapho/gl3/vao.h>
 #include <grapho/mesh.h>
+#include <grapho/meshoptimizer.h>
+#include <grapho/texturefile.h>
 
 Drawable::Drawable()
 {
-  auto sphere = grapho::mesh::Sphere();
+  auto sphere = grapho::mesh::Optimize(*grapho::mesh::Sphere());
   Mesh = grapho::gl3::Vao::Create(sphere);
   MeshDrawCount = sphere->DrawCount();
   MeshDrawMode = *grapho::gl3::GLMode(sphere->Mode);
-  Ubo = grapho::gl3::Ubo::Create(sizeof(Vars), nullptr);
 }
 
 void
-Drawable::Draw(uint32_t world_ubo_binding)
+Drawable::Update()
 {
   DirectX::XMStoreFloat4x4(
     (DirectX::XMFLOAT4X4*)&Vars.model,
     DirectX::XMMatrixTranslation(Position.x, Position.y, Position.z));
   Vars.CalcNormalMatrix();
-  Ubo->Upload(Vars);
-  Ubo->Bind();
-  Ubo->SetBindingPoint(1);
-  Shader->Use();
-  Shader->UboBind(0, world_ubo_binding);
-  Shader->UboBind(1, 1);
-  for (uint32_t i = 0; i < Textures.size(); ++i) {
-    Textures[i]->Activate(i + 3);
+}
+
+void
+Drawable::Record(grapho::gl3::CommandQueue& queue,
+                 const grapho::gl3::UniformBatch<grapho::LocalVars>& batch,
+                 uint32_t index,
+                 float depth)
+{
+  if (!Material) {
+    std::vector<grapho::gl3::TextureBinding> textures;
+    for (uint32_t i = 0; i < Textures.size(); ++i) {
+      if (Textures[i]) {
+        textures.push_back(
+          { i + 3, GL_TEXTURE_2D, Textures[i]->Handle(), Sampler });
+      }
+    }
+    Material = queue.AddMaterial(textures);
   }
-  Mesh->Draw(MeshDrawMode, MeshDrawCount);
+  queue.Push({
+    .Depth = depth,
+    .Program = Shader.get(),
+    .Vao = Mesh.get(),
+    .Material = *Material,
+    .Mode = MeshDrawMode,
+    .Count = MeshDrawCount,
+    .ObjectBuffer = batch.Buffer(),
+    .ObjectOffset = batch.Offset(index),
+    .ObjectSize = batch.Stride(),
+  });
 }
 
-// utility function for loading a 2D texture from file
+// a 2D texture decoded from file on a worker. the placeholder until then.
+// a .gtex beside the image, from texconv, is read instead of decoding if
+// it has the same colorspace. filter and wrap come from the Drawable::Sampler
 // ---------------------------------------------------
 static std::shared_ptr<grapho::gl3::Texture>
-loadTexture(const std::string& path, grapho::ColorSpace colorspace)
+loadTexture(grapho::gl3::TextureStreamer& streamer,
+            const std::string& path,
+            grapho::ColorSpace colorspace,
+            const grapho::gl3::TextureStreamOptions& options)
 {
-  ImageLoader loader;
-  if (!loader.Load(path)) {
-    return {};
-  }
-  loader.Image.ColorSpace = colorspace;
-
-  auto texture = grapho::gl3::Texture::Create(loader.Image);
-  texture->SamplingLinear(true);
-  texture->WrapRepeat();
-  return texture;
+  return streamer.Load(
+    [path, colorspace]() -> std::optional<grapho::MipChain> {
+      auto packed = path.substr(0, path.rfind('.')) + ".gtex";
+      if (auto file = grapho::OpenTextureFile(packed)) {
+        // the mips of an sRGB file are filtered in linear light, relabeling
+        // it would not give the same levels. decode the source instead
+        if (file->Header->ColorSpace == colorspace) {
+          return file->ToMipChain();
+        }
+      }
+      ImageLoader loader;
+      if (!loader.Load(path)) {
+        return std::nullopt;
+      }
+      loader.Image.ColorSpace = colorspace;
+      return grapho::MipChain::FromImage(loader.Image);
+    },
+    options);
 }
 
 std::shared_ptr<Drawable>
-Drawable::Load(const std::string& baseDir, const grapho::XMFLOAT3& position)
+Drawable::Load(grapho::gl3::TextureStreamer& streamer,
+               const std::shared_ptr<grapho::gl3::ShaderProgram>& shader,
+               const std::string& baseDir,
+               const grapho::XMFLOAT3& position)
 {
-  auto drawable = std::make_shared<Drawable>();
-  drawable->Shader = grapho::gl3::CreatePbrShader();
-  if (!drawable->Shader) {
+  if (!shader) {
     return {};
   }
+  auto drawable = std::make_shared<Drawable>();
+  drawable->Shader = shader;
+  // WorldVars and LocalVars
+  drawable->Shader->UboBind(0, 0);
+  drawable->Shader->UboBind(1, 1);
   drawable->Position = position;
+  // placeholders: grey, flat normal, dielectric, rough, no occlusion
   drawable->Textures = {
-    loadTexture(grapho::join_path(baseDir, "albedo.png"),
-                grapho::ColorSpace::Linear),
-    loadTexture(grapho::join_path(baseDir, "normal.png"),
-                grapho::ColorSpace::Linear),
-    loadTexture(grapho::join_path(baseDir, "metallic.png"),
-                grapho::ColorSpace::Linear),
-    loadTexture(grapho::join_path(baseDir, "roughness.png"),
-                grapho::ColorSpace::Linear),
-    loadTexture(grapho::join_path(baseDir, "ao.png"),
-                grapho::ColorSpace::Linear),
+    loadTexture(streamer,
+                grapho::join_path(baseDir, "albedo.png"),
+                grapho::ColorSpace::Linear,
+                { .Placeholder = { 128, 128, 128, 255 } }),
+    loadTexture(streamer,
+                grapho::join_path(baseDir, "normal.png"),
+                grapho::ColorSpace::Linear,
+                { .Placeholder = { 128, 128, 255, 255 } }),
+    loadTexture(streamer,
+                grapho::join_path(baseDir, "metallic.png"),
+                grapho::ColorSpace::Linear,
+                { .Placeholder = { 0, 0, 0, 255 } }),
+    loadTexture(streamer,
+                grapho::join_path(baseDir, "roughness.png"),
+                grapho::ColorSpace::Linear,
+                { .Placeholder = { 255, 255, 255, 255 } }),
+    loadTexture(streamer,
+                grapho::join_path(baseDir, "ao.png"),
+                grapho::ColorSpace::Linear,
+                { .Placeholder = { 255, 255, 255, 255 } }),
   };
   return drawable;
 }
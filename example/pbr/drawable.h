@@ -2,14 +2,18 @@
 #include <grapho/vars.h>
 #include <grapho/vertexlayout.h>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace grapho {
 namespace gl3 {
 struct Vao;
-struct Ubo;
+template<typename T>
+class UniformBatch;
+class CommandQueue;
 class ShaderProgram;
 class Texture;
+class TextureStreamer;
 }
 }
 
@@ -21,13 +25,26 @@ struct Drawable
   std::shared_ptr<grapho::gl3::ShaderProgram> Shader;
   grapho::XMFLOAT3 Position = {};
   grapho::LocalVars Vars;
-  std::shared_ptr<grapho::gl3::Ubo> Ubo;
   std::vector<std::shared_ptr<grapho::gl3::Texture>> Textures;
+  // a gl3::Sampler of a SamplerPool for the Textures
+  uint32_t Sampler = 0;
+  // Textures registered to the queue on the first Record
+  std::optional<uint32_t> Material;
 
   Drawable();
   ~Drawable() {}
-  void Draw(uint32_t world_ubo_binding);
+  // model and normal matrix from Position
+  void Update();
+  // Vars of this drawable at index of the batch. depth is [0, 1]
+  void Record(grapho::gl3::CommandQueue& queue,
+              const grapho::gl3::UniformBatch<grapho::LocalVars>& batch,
+              uint32_t index,
+              float depth);
 
-  static std::shared_ptr<Drawable> Load(const std::string& baseDir,
-                                        const grapho::XMFLOAT3& position);
+  // textures are streamed. shader is a CreatePbrShader, shared by drawables
+  static std::shared_ptr<Drawable> Load(
+    grapho::gl3::TextureStreamer& streamer,
+    const std::shared_ptr<grapho::gl3::ShaderProgram>& shader,
+    const std::string& baseDir,
+    const grapho::XMFLOAT3& position);
 };
@@ -1,6 +1,7 @@
 #include <GL/glew.h>
 
 #define IMGUI_DEFINE_MATH_OPERATORS
+#include <cmath>
 #include <functional>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -11,10 +12,16 @@
 #include "glfw_platform.h"
 #include "imageloader.h"
 #include <grapho/camera/camera.h>
+#include <grapho/gl3/commandqueue.h>
 #include <grapho/gl3/error_check.h>
 #include <grapho/gl3/glsl_type_name.h>
 #include <grapho/gl3/pbr.h>
+#include <grapho/gl3/sampler.h>
+#include <grapho/gl3/statecache.h>
+#include <grapho/gl3/texturestreamer.h>
 #include <grapho/gl3/ubo.h>
+#include <grapho/gl3/uniformblock.h>
+#include <grapho/gl3/uniformbatch.h>
 #include <grapho/imgui/dockspace.h>
 #include <grapho/imgui/widgets.h>
 #include <iostream>
@@ -81,10 +88,20 @@ public:
   grapho::XMFLOAT4 m_clearColor{ 0.1f, 0.1f, 0.1f, 1 };
   std::vector<std::shared_ptr<Drawable>> m_drawables;
   std::shared_ptr<grapho::gl3::PbrEnv> m_pbrEnv;
-  std::shared_ptr<grapho::gl3::Ubo> m_worldUbo;
-  grapho::WorldVars m_world;
-
-  bool InitializeScene(const std::string& dir)
+  // camera every frame, lights once
+  std::shared_ptr<grapho::gl3::ShadowUbo<grapho::WorldVars>> m_world;
+  // LocalVars of all drawables. one upload per frame
+  std::shared_ptr<grapho::gl3::UniformBatch<grapho::LocalVars>> m_objects;
+  // draws sorted by program, textures and vao
+  grapho::gl3::CommandQueue m_queue;
+  // binds of the last frame
+  grapho::gl3::StateCounters m_stateCounters;
+  // drawable textures decoded in the background
+  std::shared_ptr<grapho::gl3::TextureStreamer> m_streamer;
+  std::shared_ptr<grapho::gl3::SamplerPool> m_samplers;
+  grapho::gl3::TextureStreamStatistics m_streamStats;
+
+  bool InitializeScene(const std::string& dir, const std::string& cacheDir)
   {
     m_camera.Translation.z = 10;
 
@@ -98,16 +115,30 @@ public:
       return false;
     }
 
-    auto hdrTexture = grapho::gl3::Texture::Create(hdr.Image, true);
-    if (!hdrTexture) {
-      return false;
+    if (cacheDir.size()) {
+      m_pbrEnv = std::make_shared<grapho::gl3::PbrEnv>(hdr.Image, cacheDir);
+    } else {
+      auto hdrTexture = grapho::gl3::Texture::Create(hdr.Image, true);
+      if (!hdrTexture) {
+        return false;
+      }
+      m_pbrEnv = std::make_shared<grapho::gl3::PbrEnv>(hdrTexture);
     }
-    m_pbrEnv = std::make_shared<grapho::gl3::PbrEnv>(hdrTexture);
     grapho::gl3::CheckAndPrintError(
       [](const char* msg) { std::cerr << "PbrEnv: " << msg << std::endl; });
 
-    m_world = 
-    {
+    // the blocks of the pbr shaders against the structs
+    auto& shader = m_pbrEnv->PbrShader;
+    if (!shader ||
+        !grapho::gl3::MatchUniformBlock<grapho::WorldVars>(shader->Handle(),
+                                                           "EnvVars") ||
+        !grapho::gl3::MatchUniformBlock<grapho::LocalVars>(shader->Handle(),
+                                                           "ModelVars")) {
+      std::cout << "pbr shader: " << grapho::GetErrorString() << std::endl;
+      return false;
+    }
+
+    m_world = grapho::gl3::ShadowUbo<grapho::WorldVars>::Create({
       .lightPositions = {
         { -10.0f, 10.0f, 10.0f, 0 },
         { 10.0f, 10.0f, 10.0f, 0 },
@@ -119,34 +150,39 @@ public:
         { 300.0f, 300.0f, 300.0f, 0 },
         { 300.0f, 300.0f, 300.0f, 0 },
         { 300.0f, 300.0f, 300.0f, 0 },
-      }
-    };
-    m_worldUbo = grapho::gl3::Ubo::Create(sizeof(m_world), nullptr);
+      },
+    });
+    m_objects = grapho::gl3::UniformBatch<grapho::LocalVars>::Create(256);
+    m_streamer = grapho::gl3::TextureStreamer::Create();
+    m_samplers = grapho::gl3::SamplerPool::Create();
+    auto& sampler = m_samplers->Get({
+      .Filter = grapho::gl3::SamplerFilter::Trilinear,
+      .Wrap = grapho::gl3::SamplerWrap::Repeat,
+      .Anisotropy = 8,
+    });
 
-    if (auto drawable = Drawable::Load(
-          grapho::join_path(dir, "resources/textures/pbr/rusted_iron"),
-          { -4.0, 0.0, 2.0 })) {
-      m_drawables.push_back(drawable);
-    }
-    if (auto drawable =
-          Drawable::Load(grapho::join_path(dir, "resources/textures/pbr/gold"),
-                         { -2.0, 0.0, 2.0 })) {
-      m_drawables.push_back(drawable);
-    }
-    if (auto drawable =
-          Drawable::Load(grapho::join_path(dir, "resources/textures/pbr/grass"),
-                         { -0.0, 0.0, 2.0 })) {
-      m_drawables.push_back(drawable);
-    }
-    if (auto drawable = Drawable::Load(
-          grapho::join_path(dir, "resources/textures/pbr/plastic"),
-          { 2.0, 0.0, 2.0 })) {
-      m_drawables.push_back(drawable);
-    }
-    if (auto drawable =
-          Drawable::Load(grapho::join_path(dir, "resources/textures/pbr/wall"),
-                         { 4.0, 0.0, 2.0 })) {
-      m_drawables.push_back(drawable);
+    struct
+    {
+      const char* Name;
+      grapho::XMFLOAT3 Position;
+    } materials[] = {
+      { "rusted_iron", { -4.0, 0.0, 2.0 } },
+      { "gold", { -2.0, 0.0, 2.0 } },
+      { "grass", { -0.0, 0.0, 2.0 } },
+      { "plastic", { 2.0, 0.0, 2.0 } },
+      { "wall", { 4.0, 0.0, 2.0 } },
+    };
+    for (auto& material : materials) {
+      if (auto drawable = Drawable::Load(
+            *m_streamer,
+            m_pbrEnv->PbrShader,
+            grapho::join_path(dir,
+                              std::string("resources/textures/pbr/") +
+                                material.Name),
+            material.Position)) {
+        drawable->Sampler = sampler->Handle();
+        m_drawables.push_back(drawable);
+      }
     }
 
     docks.push_back({ "pbr", std::bind(&Gui::ShowGui, this), true });
@@ -157,6 +193,9 @@ public:
     docks.push_back(
       { "uniforms", std::bind(&Gui::ShowUniformList, this), false });
 
+    docks.push_back(
+      { "state", std::bind(&Gui::ShowStateCounters, this), false });
+
     return true;
   }
 
@@ -188,6 +227,7 @@ public:
 
     // render to fbo
     m_camera.Update();
+    m_streamStats = m_streamer->Update();
 
     // configure global opengl state
     // -----------------------------
@@ -198,17 +238,42 @@ public:
     // map.
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-    m_worldUbo->Upload(m_world);
-    m_worldUbo->Bind();
-    m_worldUbo->SetBindingPoint(0);
+    m_world->Set(&grapho::WorldVars::projection, m_camera.ProjectionMatrix);
+    m_world->Set(&grapho::WorldVars::view, m_camera.ViewMatrix);
+    m_world->Set(&grapho::WorldVars::camPos,
+                 {
+                   m_camera.Translation.x,
+                   m_camera.Translation.y,
+                   m_camera.Translation.z,
+                   1,
+                 });
+    m_world->Flush();
+    m_world->Buffer()->SetBindingPoint(0);
 
     // ENV
     m_pbrEnv->Activate();
     // OBJECTS
-    for (auto& drawable : m_drawables) {
-      drawable->Draw(0);
+    if (m_objects->Begin(m_drawables.size())) {
+      for (uint32_t i = 0; i < m_drawables.size(); ++i) {
+        m_drawables[i]->Update();
+        m_objects->Set(i, m_drawables[i]->Vars);
+      }
+      m_objects->Flush();
+      for (uint32_t i = 0; i < m_drawables.size(); ++i) {
+        auto& drawable = m_drawables[i];
+        auto dx = drawable->Position.x - m_camera.Translation.x;
+        auto dy = drawable->Position.y - m_camera.Translation.y;
+        auto dz = drawable->Position.z - m_camera.Translation.z;
+        drawable->Record(m_queue,
+                         *m_objects,
+                         i,
+                         std::sqrt(dx * dx + dy * dy + dz * dz) /
+                           m_camera.Projection.FarZ);
+      }
+      m_queue.Execute();
     }
     m_pbrEnv->DrawSkybox(m_camera.ProjectionMatrix, m_camera.ViewMatrix);
+    m_objects->EndFrame();
 
     m_fbo.Unbind();
   }
@@ -259,6 +324,39 @@ public:
     }
   }
 
+  void ShowStateCounters()
+  {
+    std::array<const char*, 3> cols = {
+      "bind",
+      "calls",
+      "filtered",
+    };
+    if (grapho::imgui::BeginTableColumns("state", cols)) {
+      auto row = [](const char* name, uint32_t calls, uint32_t filtered) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", calls);
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", filtered);
+      };
+      auto& c = m_stateCounters;
+      row("program", c.Program.Calls, c.Program.Filtered);
+      row("vertex array", c.VertexArray.Calls, c.VertexArray.Filtered);
+      row("buffer", c.Buffer.Calls, c.Buffer.Filtered);
+      row("indexed buffer", c.IndexedBuffer.Calls, c.IndexedBuffer.Filtered);
+      row("texture", c.Texture.Calls, c.Texture.Filtered);
+      row("sampler", c.Sampler.Calls, c.Sampler.Filtered);
+      row("framebuffer", c.Framebuffer.Calls, c.Framebuffer.Filtered);
+      row("total", c.Calls(), c.Filtered());
+      ImGui::EndTable();
+    }
+
+    auto& s = m_streamStats;
+    ImGui::Text("textures: %u decoding, %u uploading", s.Decoding, s.Uploading);
+  }
+
   void Begin()
   {
     ImGui_ImplOpenGL3_NewFrame();
@@ -286,6 +384,11 @@ public:
   {
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+    // the imgui backend binds with raw GL calls
+    auto& state = grapho::gl3::StateCache::Current();
+    m_stateCounters = state.TakeCounters();
+    state.Invalidate();
   }
 };
 
@@ -299,11 +402,15 @@ int
 main(int argc, char** argv)
 {
   if (argc < 2) {
-    std::cout << "usage: " << argv[0] << " {path to LearnOpenGL dir}"
-              << std::endl;
+    std::cout << "usage: " << argv[0]
+              << " {path to LearnOpenGL dir} [cache dir]" << std::endl;
     return 1;
   }
   std::string dir(argv[1]);
+  std::string cacheDir;
+  if (argc >= 3) {
+    cacheDir = argv[2];
+  }
 
   GlfwPlatform platform;
   auto window = platform.CreateWindow("LearnOpenGL", SCR_WIDTH, SCR_HEIGHT);
@@ -316,11 +423,21 @@ main(int argc, char** argv)
     return 3;
   }
   grapho::gl3::CheckAndPrintError(&print);
+  if (cacheDir.size()) {
+    // the shaders too. a launch after the first skips compile and link
+    auto programDir = grapho::join_path(cacheDir, "programs");
+    grapho::gl3::ProgramCache::Current() =
+      grapho::gl3::ProgramCache::Create(programDir);
+  }
 
   Gui gui(window);
-  if (!gui.InitializeScene(dir)) {
+  if (!gui.InitializeScene(dir, cacheDir)) {
     return 4;
   }
+  if (auto& cache = grapho::gl3::ProgramCache::Current()) {
+    std::cout << "programs: " << cache->Hits << " cached, " << cache->Misses
+              << " compiled" << std::endl;
+  }
   grapho::gl3::CheckAndPrintError(&print);
 
   // render loop
@@ -0,0 +1,185 @@
+// converts images to a grapho texture file. mipmaps and block compression
+// offline, so loading is a memory map and an upload.
+//
+// usage: texconv [options] output.gtex input...
+//
+//   one input for a 2D texture, six for a cubemap. +x, -x, +y, -y, +z, -z
+//
+//   --format bc1|bc3|bc4|bc5|bc7  block compression. default the input as is
+//   --linear   data such as normal, metallic, roughness and ao maps.
+//              without it 8 bit input is encoded as sRGB color
+//   --kaiser   sharper mip filter than the 2x2 box
+//   --no-mips  level 0 only
+#define STB_IMAGE_IMPLEMENTATION
+#include <chrono>
+#include <grapho/bcencoder.h>
+#include <grapho/texturefile.h>
+#include <optional>
+#include <stb_image.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static std::optional<grapho::PixelFormat>
+ParseFormat(const char* name)
+{
+  if (strcmp(name, "bc1") == 0) {
+    return grapho::PixelFormat::bc1_RGB;
+  }
+  if (strcmp(name, "bc3") == 0) {
+    return grapho::PixelFormat::bc3_RGBA;
+  }
+  if (strcmp(name, "bc4") == 0) {
+    return grapho::PixelFormat::bc4_R;
+  }
+  if (strcmp(name, "bc5") == 0) {
+    return grapho::PixelFormat::bc5_RG;
+  }
+  if (strcmp(name, "bc7") == 0) {
+    return grapho::PixelFormat::bc7_RGBA;
+  }
+  return std::nullopt;
+}
+
+// level 0. float rgb for a hdr file
+static std::optional<grapho::MipChain>
+Load(const char* path, bool linear)
+{
+  int width;
+  int height;
+  int channels;
+  grapho::Image image{};
+  if (stbi_is_hdr(path)) {
+    auto pixels = stbi_loadf(path, &width, &height, &channels, 3);
+    if (!pixels) {
+      return std::nullopt;
+    }
+    image = {
+      width,
+      height,
+      grapho::PixelFormat::f32_RGB,
+      grapho::ColorSpace::Linear,
+      (const uint8_t*)pixels,
+    };
+    auto chain = grapho::MipChain::FromImage(image);
+    stbi_image_free(pixels);
+    return chain;
+  }
+
+  auto pixels = stbi_load(path, &width, &height, &channels, 0);
+  if (!pixels) {
+    return std::nullopt;
+  }
+  image = {
+    width,
+    height,
+    channels == 1   ? grapho::PixelFormat::u8_R
+    : channels == 3 ? grapho::PixelFormat::u8_RGB
+                    : grapho::PixelFormat::u8_RGBA,
+    linear ? grapho::ColorSpace::Linear : grapho::ColorSpace::sRGB,
+    pixels,
+  };
+  std::vector<uint8_t> rgba;
+  if (channels == 2) {
+    // grey alpha. expand to rgba
+    rgba.resize(width * height * 4);
+    for (int i = 0; i < width * height; ++i) {
+      rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = pixels[i * 2];
+      rgba[i * 4 + 3] = pixels[i * 2 + 1];
+    }
+    image.Pixels = rgba.data();
+  }
+  auto chain = grapho::MipChain::FromImage(image);
+  stbi_image_free(pixels);
+  return chain;
+}
+
+static void
+Usage()
+{
+  printf("usage: texconv [--format bc1|bc3|bc4|bc5|bc7] [--linear] "
+         "[--kaiser] [--no-mips] output.gtex input...\n"
+         "  --linear for data maps (normal, metallic, roughness, ao). "
+         "8 bit input is sRGB color without it\n");
+}
+
+int
+main(int argc, char** argv)
+{
+  std::optional<grapho::PixelFormat> format;
+  bool linear = false;
+  auto filter = grapho::MipFilter::Box;
+  bool mips = true;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      auto parsed = ParseFormat(argv[++i]);
+      if (!parsed) {
+        Usage();
+        return 1;
+      }
+      format = parsed;
+    } else if (strcmp(argv[i], "--linear") == 0) {
+      linear = true;
+    } else if (strcmp(argv[i], "--kaiser") == 0) {
+      filter = grapho::MipFilter::Kaiser;
+    } else if (strcmp(argv[i], "--no-mips") == 0) {
+      mips = false;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.size() != 2 && paths.size() != 7) {
+    Usage();
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<grapho::MipChain> faces;
+  uint64_t sourceBytes = 0;
+  for (size_t i = 1; i < paths.size(); ++i) {
+    auto chain = Load(paths[i], linear);
+    if (!chain) {
+      printf("%s: failed to load\n", paths[i]);
+      return 1;
+    }
+    if (mips && !chain->Generate(filter)) {
+      printf("%s: no mipmaps for this format\n", paths[i]);
+      return 1;
+    }
+    sourceBytes += chain->Pixels.size();
+    if (format) {
+      chain = grapho::EncodeBlocks(*chain, *format);
+      if (!chain) {
+        printf("%s: can not encode. 8 bit only, bc4 and bc5 need --linear\n",
+               paths[i]);
+        return 1;
+      }
+    }
+    faces.push_back(std::move(*chain));
+  }
+
+  if (!grapho::WriteTextureFile(paths[0], faces)) {
+    printf("%s: failed to write\n", paths[0]);
+    return 1;
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto view = grapho::OpenTextureFile(paths[0]);
+  if (!view) {
+    printf("%s: failed to read back\n", paths[0]);
+    return 1;
+  }
+  printf("%s: %ux%u %s, %u levels, %u faces, %llu => %llu bytes, %.1fms\n",
+         paths[0],
+         view->Header->Width,
+         view->Header->Height,
+         view->Header->ColorSpace == grapho::ColorSpace::sRGB ? "sRGB"
+                                                               : "linear",
+         view->Header->LevelCount,
+         view->Header->FaceCount,
+         (unsigned long long)sourceBytes,
+         (unsigned long long)view->File->Size(),
+         std::chrono::duration<double, std::milli>(end - start).count());
+  return 0;
+}
@@ -0,0 +1,494 @@
+#include "bcencoder.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace grapho {
+
+namespace {
+
+using simd::Float4;
+
+// rgba 0-255
+struct Block
+{
+  Float4 Pixels[16];
+};
+
+float
+Dot(Float4 a, Float4 b)
+{
+  float f[4];
+  (a * b).Store(f);
+  return f[0] + f[1] + f[2] + f[3];
+}
+
+void
+LoadBlock(const uint8_t* pixels,
+          int width,
+          int height,
+          uint32_t channels,
+          int blockX,
+          int blockY,
+          Block& block)
+{
+  for (int y = 0; y < 4; ++y) {
+    auto sy = std::min(blockY * 4 + y, height - 1);
+    for (int x = 0; x < 4; ++x) {
+      auto sx = std::min(blockX * 4 + x, width - 1);
+      auto p = pixels + (sy * width + sx) * channels;
+      auto& dst = block.Pixels[y * 4 + x];
+      switch (channels) {
+        case 4:
+          dst = Float4(p[0], p[1], p[2], p[3]);
+          break;
+        case 3:
+          dst = Float4(p[0], p[1], p[2], 255);
+          break;
+        default:
+          // grayscale
+          dst = Float4(p[0], p[0], p[0], 255);
+          break;
+      }
+    }
+  }
+}
+
+// the endpoints at the ends of the principal axis, from a few power
+// iterations. mask zeroes the channels that are not encoded
+void
+PrincipalEndpoints(const Block& block, Float4 mask, Float4& e0, Float4& e1)
+{
+  Float4 sum(0.0f);
+  Float4 lo = block.Pixels[0];
+  Float4 hi = block.Pixels[0];
+  for (auto& p : block.Pixels) {
+    sum += p;
+    lo = Min(lo, p);
+    hi = Max(hi, p);
+  }
+  auto mean = sum * Float4(1.0f / 16);
+
+  auto axis = (hi - lo) * mask;
+  for (int i = 0; i < 8; ++i) {
+    Float4 next(0.0f);
+    for (auto& p : block.Pixels) {
+      auto d = (p - mean) * mask;
+      next += d * Float4(Dot(d, axis));
+    }
+    auto length = sqrtf(Dot(next, next));
+    if (length < 1e-6f) {
+      break;
+    }
+    axis = next * Float4(1.0f / length);
+  }
+  auto length = sqrtf(Dot(axis, axis));
+  if (length < 1e-6f) {
+    // flat
+    e0 = e1 = mean;
+    return;
+  }
+  axis = axis * Float4(1.0f / length);
+
+  float tMin = FLT_MAX;
+  float tMax = -FLT_MAX;
+  for (auto& p : block.Pixels) {
+    auto t = Dot((p - mean) * mask, axis);
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+  e0 = mean + axis * Float4(tMin);
+  e1 = mean + axis * Float4(tMax);
+}
+
+// least squares endpoints for pixel = e0 + (e1 - e0) * weight.
+// false if all the weights are the same
+bool
+FitEndpoints(const Block& block, const float* weights, Float4& e0, Float4& e1)
+{
+  float a = 0;
+  float b = 0;
+  float c = 0;
+  Float4 x0(0.0f);
+  Float4 x1(0.0f);
+  for (int i = 0; i < 16; ++i) {
+    auto w = weights[i];
+    auto u = 1 - w;
+    a += u * u;
+    b += u * w;
+    c += w * w;
+    x0 += block.Pixels[i] * Float4(u);
+    x1 += block.Pixels[i] * Float4(w);
+  }
+  auto det = a * c - b * b;
+  if (fabsf(det) < 1e-6f) {
+    return false;
+  }
+  auto inv = Float4(1.0f / det);
+  auto lo = Float4(0.0f);
+  auto hi = Float4(255.0f);
+  e0 = Min(Max((x0 * Float4(c) - x1 * Float4(b)) * inv, lo), hi);
+  e1 = Min(Max((x1 * Float4(a) - x0 * Float4(b)) * inv, lo), hi);
+  return true;
+}
+
+// the nearest entry per pixel. the squared error
+float
+AssignIndices(const Block& block,
+              Float4 mask,
+              const Float4* palette,
+              int count,
+              uint8_t* indices)
+{
+  float error = 0;
+  for (int i = 0; i < 16; ++i) {
+    float best = FLT_MAX;
+    for (int j = 0; j < count; ++j) {
+      auto d = (block.Pixels[i] - palette[j]) * mask;
+      auto e = Dot(d, d);
+      if (e < best) {
+        best = e;
+        indices[i] = j;
+      }
+    }
+    error += best;
+  }
+  return error;
+}
+
+// bits from the lsb of byte 0
+struct BitWriter
+{
+  uint8_t* Data;
+  uint32_t Bit = 0;
+
+  void Put(uint32_t value, uint32_t count)
+  {
+    for (uint32_t i = 0; i < count; ++i, ++Bit) {
+      if ((value >> i) & 1) {
+        Data[Bit >> 3] |= 1 << (Bit & 7);
+      }
+    }
+  }
+};
+
+//
+// bc1. two 565 endpoints and 2 bit indices. always the 4 color mode
+//
+uint16_t
+To565(Float4 color)
+{
+  auto q = [&color](int i, int max) {
+    return std::clamp(static_cast<int>(color[i] * max / 255 + 0.5f), 0, max);
+  };
+  return (q(0, 31) << 11) | (q(1, 63) << 5) | q(2, 31);
+}
+
+Float4
+From565(uint16_t c)
+{
+  int r = c >> 11;
+  int g = (c >> 5) & 63;
+  int b = c & 31;
+  return Float4(
+    (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0);
+}
+
+void
+EncodeBC1(const Block& block, uint8_t* out)
+{
+  const Float4 mask(1, 1, 1, 0);
+  const float WEIGHTS[4] = { 0, 1, 1.0f / 3, 2.0f / 3 };
+
+  Float4 e0;
+  Float4 e1;
+  PrincipalEndpoints(block, mask, e0, e1);
+  float best = FLT_MAX;
+  uint16_t c0 = 0;
+  uint16_t c1 = 0;
+  uint8_t indices[16];
+  for (int iteration = 0; iteration < 3; ++iteration) {
+    auto q0 = To565(e0);
+    auto q1 = To565(e1);
+    auto p0 = From565(q0);
+    auto p1 = From565(q1);
+    Float4 palette[4] = {
+      p0,
+      p1,
+      (p0 * Float4(2) + p1) * Float4(1.0f / 3),
+      (p0 + p1 * Float4(2)) * Float4(1.0f / 3),
+    };
+    uint8_t candidate[16];
+    auto error = AssignIndices(block, mask, palette, 4, candidate);
+    if (error < best) {
+      best = error;
+      c0 = q0;
+      c1 = q1;
+      memcpy(indices, candidate, 16);
+    }
+    float weights[16];
+    for (int i = 0; i < 16; ++i) {
+      weights[i] = WEIGHTS[candidate[i]];
+    }
+    if (best == 0 || !FitEndpoints(block, weights, e0, e1)) {
+      break;
+    }
+  }
+
+  // c0 > c1 selects the 4 color mode
+  if (c0 < c1) {
+    std::swap(c0, c1);
+    for (auto& index : indices) {
+      index ^= 1;
+    }
+  } else if (c0 == c1) {
+    memset(indices, 0, 16);
+  }
+  out[0] = c0 & 0xFF;
+  out[1] = c0 >> 8;
+  out[2] = c1 & 0xFF;
+  out[3] = c1 >> 8;
+  uint32_t bits = 0;
+  for (int i = 0; i < 16; ++i) {
+    bits |= indices[i] << (i * 2);
+  }
+  memcpy(out + 4, &bits, 4);
+}
+
+//
+// bc4. two 8 bit endpoints and 3 bit indices. always the 8 value mode
+//
+void
+EncodeBC4(const Block& block, int channel, uint8_t* out)
+{
+  float values[16];
+  float lo = 255;
+  float hi = 0;
+  for (int i = 0; i < 16; ++i) {
+    values[i] = block.Pixels[i][channel];
+    lo = std::min(lo, values[i]);
+    hi = std::max(hi, values[i]);
+  }
+  int e0 = static_cast<int>(hi + 0.5f);
+  int e1 = static_cast<int>(lo + 0.5f);
+  uint64_t bits = 0;
+  if (e0 > e1) {
+    float palette[8] = { static_cast<float>(e0), static_cast<float>(e1) };
+    for (int i = 2; i < 8; ++i) {
+      palette[i] = ((8 - i) * e0 + (i - 1) * e1) / 7.0f;
+    }
+    for (int i = 0; i < 16; ++i) {
+      uint64_t index = 0;
+      float best = FLT_MAX;
+      for (int j = 0; j < 8; ++j) {
+        auto e = fabsf(values[i] - palette[j]);
+        if (e < best) {
+          best = e;
+          index = j;
+        }
+      }
+      bits |= index << (i * 3);
+    }
+  }
+  // else flat. every index is 0
+  out[0] = e0;
+  out[1] = e1;
+  for (int i = 0; i < 6; ++i) {
+    out[2 + i] = (bits >> (i * 8)) & 0xFF;
+  }
+}
+
+//
+// bc7 mode 6. rgba 7 bit endpoints with a p bit each and 4 bit indices
+//
+const int BC7_WEIGHTS4[16] = { 0,  4,  9,  13, 17, 21, 26, 30,
+                               34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct Mode6Endpoint
+{
+  uint8_t Color[4];
+  uint8_t PBit;
+
+  static Mode6Endpoint Quantize(Float4 color)
+  {
+    Mode6Endpoint best{};
+    float bestError = FLT_MAX;
+    for (uint8_t p = 0; p < 2; ++p) {
+      Mode6Endpoint e{ {}, p };
+      float error = 0;
+      for (int i = 0; i < 4; ++i) {
+        auto q = std::clamp(
+          static_cast<int>((color[i] - p) / 2 + 0.5f), 0, 127);
+        e.Color[i] = q;
+        auto d = ((q << 1) | p) - color[i];
+        error += d * d;
+      }
+      if (error < bestError) {
+        bestError = error;
+        best = e;
+      }
+    }
+    return best;
+  }
+
+  int Value(int i) const { return (Color[i] << 1) | PBit; }
+};
+
+void
+EncodeBC7(const Block& block, uint8_t* out)
+{
+  const Float4 mask(1.0f);
+
+  Float4 e0;
+  Float4 e1;
+  PrincipalEndpoints(block, mask, e0, e1);
+  float best = FLT_MAX;
+  Mode6Endpoint q0{};
+  Mode6Endpoint q1{};
+  uint8_t indices[16];
+  for (int iteration = 0; iteration < 3; ++iteration) {
+    auto a = Mode6Endpoint::Quantize(e0);
+    auto b = Mode6Endpoint::Quantize(e1);
+    Float4 palette[16];
+    for (int i = 0; i < 16; ++i) {
+      auto w = BC7_WEIGHTS4[i];
+      auto lerp = [&](int c) -> float {
+        return ((64 - w) * a.Value(c) + w * b.Value(c) + 32) >> 6;
+      };
+      palette[i] = Float4(lerp(0), lerp(1), lerp(2), lerp(3));
+    }
+    uint8_t candidate[16];
+    auto error = AssignIndices(block, mask, palette, 16, candidate);
+    if (error < best) {
+      best = error;
+      q0 = a;
+      q1 = b;
+      memcpy(indices, candidate, 16);
+    }
+    float weights[16];
+    for (int i = 0; i < 16; ++i) {
+      weights[i] = BC7_WEIGHTS4[candidate[i]] / 64.0f;
+    }
+    if (best == 0 || !FitEndpoints(block, weights, e0, e1)) {
+      break;
+    }
+  }
+
+  // the msb of the anchor, pixel 0, is implicitly 0
+  if (indices[0] & 8) {
+    std::swap(q0, q1);
+    for (auto& index : indices) {
+      index = 15 - index;
+    }
+  }
+
+  memset(out, 0, 16);
+  BitWriter writer{ out };
+  writer.Put(1 << 6, 7);
+  for (int i = 0; i < 4; ++i) {
+    writer.Put(q0.Color[i], 7);
+    writer.Put(q1.Color[i], 7);
+  }
+  writer.Put(q0.PBit, 1);
+  writer.Put(q1.PBit, 1);
+  writer.Put(indices[0], 3);
+  for (int i = 1; i < 16; ++i) {
+    writer.Put(indices[i], 4);
+  }
+}
+
+void
+EncodeBlock(PixelFormat format, const Block& block, uint8_t* out)
+{
+  switch (format) {
+    case PixelFormat::bc1_RGB:
+      EncodeBC1(block, out);
+      break;
+    case PixelFormat::bc3_RGBA:
+      EncodeBC4(block, 3, out);
+      EncodeBC1(block, out + 8);
+      break;
+    case PixelFormat::bc4_R:
+      EncodeBC4(block, 0, out);
+      break;
+    case PixelFormat::bc5_RG:
+      EncodeBC4(block, 0, out);
+      EncodeBC4(block, 1, out + 8);
+      break;
+    case PixelFormat::bc7_RGBA:
+      EncodeBC7(block, out);
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace
+
+std::optional<MipChain>
+EncodeBlocks(const MipChain& src, PixelFormat format, uint32_t threadCount)
+{
+  uint32_t channels;
+  switch (src.Format) {
+    case PixelFormat::u8_RGBA:
+      channels = 4;
+      break;
+    case PixelFormat::u8_RGB:
+      channels = 3;
+      break;
+    case PixelFormat::u8_R:
+      channels = 1;
+      break;
+    default:
+      return std::nullopt;
+  }
+  if (!IsCompressed(format)) {
+    return std::nullopt;
+  }
+  if ((format == PixelFormat::bc4_R || format == PixelFormat::bc5_RG) &&
+      src.ColorSpace == ColorSpace::sRGB) {
+    return std::nullopt;
+  }
+  if (format == PixelFormat::bc5_RG && channels < 2) {
+    return std::nullopt;
+  }
+
+  MipChain dst;
+  dst.Format = format;
+  dst.ColorSpace = src.ColorSpace;
+  uint32_t offset = 0;
+  for (auto& level : src.Levels) {
+    auto size =
+      static_cast<uint32_t>(ImageSize(format, level.Width, level.Height));
+    dst.Levels.push_back({ level.Width, level.Height, offset, size });
+    offset += size;
+  }
+  dst.Pixels.resize(offset);
+
+  auto blockBytes = BytesPerBlock(format);
+  for (size_t i = 0; i < src.Levels.size(); ++i) {
+    auto& level = src.Levels[i];
+    auto pixels = src.Pixels.data() + level.Offset;
+    auto out = dst.Pixels.data() + dst.Levels[i].Offset;
+    int blocksX = (level.Width + 3) / 4;
+    int blocksY = (level.Height + 3) / 4;
+    ParallelFor(
+      blocksY,
+      [&](uint32_t y) {
+        Block block;
+        for (int x = 0; x < blocksX; ++x) {
+          LoadBlock(
+            pixels, level.Width, level.Height, channels, x, y, block);
+          EncodeBlock(
+            format, block, out + (y * blocksX + x) * blockBytes);
+        }
+      },
+      threadCount);
+  }
+  return dst;
+}
+
+}
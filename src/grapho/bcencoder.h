@@ -0,0 +1,32 @@
+#pragma once
+#include "mipchain.h"
+#include <optional>
+#include <stdint.h>
+
+namespace grapho {
+
+//
+// block compression on the cpu, for assets compressed offline.
+//
+// every level of an 8 bit chain is encoded in 4x4 blocks, on threadCount
+// threads, 0 for all. a partial block at the edge repeats the last row and
+// column.
+//
+//   bc1_RGB    8 bytes. rgb, alpha is dropped
+//   bc3_RGBA  16 bytes. bc1 color and bc4 alpha
+//   bc4_R      8 bytes. the first channel
+//   bc5_RG    16 bytes. the first two channels, e.g. a normal map xy
+//   bc7_RGBA  16 bytes. mode 6 only, one rgba line with 16 steps
+//
+// the color space is kept. bc4 and bc5 have no sRGB and need Linear.
+// nullopt for a float or compressed source, or bc5 from a single channel.
+//
+//   auto chain = MipChain::FromImage(image);
+//   chain.Generate();
+//   auto compressed = EncodeBlocks(chain, PixelFormat::bc7_RGBA);
+//   auto texture = gl3::Texture::Create(*compressed);
+//
+std::optional<MipChain>
+EncodeBlocks(const MipChain& src, PixelFormat format, uint32_t threadCount = 0);
+
+}
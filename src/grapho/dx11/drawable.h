@@ -11,9 +11,13 @@ namespace dx11 {
 inline DXGI_FORMAT
 DxgiFormat(const grapho::VertexLayout& layout)
 {
+  // DXGI has no 3 component 8/16 bit formats
+  auto n = layout.Normalized;
   switch (layout.Type) {
     case grapho::ValueType::Float:
       switch (layout.Count) {
+        case 1:
+          return DXGI_FORMAT_R32_FLOAT;
         case 2:
           return DXGI_FORMAT_R32G32_FLOAT;
         case 3:
@@ -21,6 +25,88 @@ DxgiFormat(const grapho::VertexLayout& layout)
         case 4:
           return DXGI_FORMAT_R32G32B32A32_FLOAT;
       }
+      break;
+    case grapho::ValueType::Half:
+      switch (layout.Count) {
+        case 1:
+          return DXGI_FORMAT_R16_FLOAT;
+        case 2:
+          return DXGI_FORMAT_R16G16_FLOAT;
+        case 4:
+          return DXGI_FORMAT_R16G16B16A16_FLOAT;
+      }
+      break;
+    case grapho::ValueType::Int8:
+      switch (layout.Count) {
+        case 1:
+          return n ? DXGI_FORMAT_R8_SNORM : DXGI_FORMAT_R8_SINT;
+        case 2:
+          return n ? DXGI_FORMAT_R8G8_SNORM : DXGI_FORMAT_R8G8_SINT;
+        case 4:
+          return n ? DXGI_FORMAT_R8G8B8A8_SNORM : DXGI_FORMAT_R8G8B8A8_SINT;
+      }
+      break;
+    case grapho::ValueType::UInt8:
+      switch (layout.Count) {
+        case 1:
+          return n ? DXGI_FORMAT_R8_UNORM : DXGI_FORMAT_R8_UINT;
+        case 2:
+          return n ? DXGI_FORMAT_R8G8_UNORM : DXGI_FORMAT_R8G8_UINT;
+        case 4:
+          return n ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_R8G8B8A8_UINT;
+      }
+      break;
+    case grapho::ValueType::Int16:
+      switch (layout.Count) {
+        case 1:
+          return n ? DXGI_FORMAT_R16_SNORM : DXGI_FORMAT_R16_SINT;
+        case 2:
+          return n ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R16G16_SINT;
+        case 4:
+          return n ? DXGI_FORMAT_R16G16B16A16_SNORM
+                   : DXGI_FORMAT_R16G16B16A16_SINT;
+      }
+      break;
+    case grapho::ValueType::UInt16:
+      switch (layout.Count) {
+        case 1:
+          return n ? DXGI_FORMAT_R16_UNORM : DXGI_FORMAT_R16_UINT;
+        case 2:
+          return n ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R16G16_UINT;
+        case 4:
+          return n ? DXGI_FORMAT_R16G16B16A16_UNORM
+                   : DXGI_FORMAT_R16G16B16A16_UINT;
+      }
+      break;
+    case grapho::ValueType::Int32:
+      switch (layout.Count) {
+        case 1:
+          return DXGI_FORMAT_R32_SINT;
+        case 2:
+          return DXGI_FORMAT_R32G32_SINT;
+        case 3:
+          return DXGI_FORMAT_R32G32B32_SINT;
+        case 4:
+          return DXGI_FORMAT_R32G32B32A32_SINT;
+      }
+      break;
+    case grapho::ValueType::UInt32:
+      switch (layout.Count) {
+        case 1:
+          return DXGI_FORMAT_R32_UINT;
+        case 2:
+          return DXGI_FORMAT_R32G32_UINT;
+        case 3:
+          return DXGI_FORMAT_R32G32B32_UINT;
+        case 4:
+          return DXGI_FORMAT_R32G32B32A32_UINT;
+      }
+      break;
+    case grapho::ValueType::UInt2_10_10_10:
+      return n ? DXGI_FORMAT_R10G10B10A2_UNORM : DXGI_FORMAT_R10G10B10A2_UINT;
+    default:
+      // Double and the signed 10:10:10:2 have no DXGI format
+      break;
   }
   throw std::invalid_argument("not implemented");
 }
@@ -0,0 +1,287 @@
+#include <GL/glew.h>
+
+#include "commandqueue.h"
+#include "shader.h"
+#include "statecache.h"
+#include "vao.h"
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+CommandQueue::CommandQueue()
+{
+  materials_.push_back({});
+}
+
+uint32_t
+CommandQueue::DenseId(std::unordered_map<uint32_t, uint32_t>& ids,
+                      uint32_t handle,
+                      uint32_t limit)
+{
+  auto found = ids.find(handle);
+  if (found != ids.end()) {
+    return found->second;
+  }
+  uint32_t id = ids.size();
+  // the sort key field is full
+  assert(id < limit);
+  ids.insert({ handle, id });
+  return id;
+}
+
+void
+CommandQueue::EnableInstancing(std::span<const VertexLayout> layouts,
+                               uint32_t stride)
+{
+  instanceLayouts_.assign(layouts.begin(), layouts.end());
+  instanceStride_ = stride;
+  instances_ = Vbo::Create(0, nullptr);
+  instancedVaos_.clear();
+}
+
+const std::shared_ptr<Vao>&
+CommandQueue::InstancedVao(const Vao& vao)
+{
+  auto found = instancedVaos_.find(vao.vao_);
+  if (found != instancedVaos_.end()) {
+    // a deleted vao name may be recycled
+    auto& instanced = *found->second;
+    if (instanced.ibo_ == vao.ibo_ &&
+        instanced.slots_.size() == vao.slots_.size() + 1 &&
+        std::equal(
+          vao.slots_.begin(), vao.slots_.end(), instanced.slots_.begin())) {
+      return found->second;
+    }
+    // built for a deleted vao. releases its buffers now
+    instancedVaos_.erase(found);
+  }
+  auto instanced = vao.CreateInstanced(make_span(instanceLayouts_), instances_);
+  return instancedVaos_[vao.vao_] = instanced;
+}
+
+uint32_t
+CommandQueue::AddMaterial(std::span<const TextureBinding> textures)
+{
+  assert(materials_.size() < SORT_KEY_MATERIALS);
+  materials_.push_back({ textures.begin(), textures.end() });
+  return materials_.size() - 1;
+}
+
+void
+CommandQueue::Push(const DrawItem& item)
+{
+  uint32_t instance = DrawCommand::NO_INSTANCE;
+  uint32_t vao = item.Vao->vao_;
+  if (item.Instance && instances_) {
+    instance = instanceData_.size() / instanceStride_;
+    auto src = static_cast<const uint8_t*>(item.Instance);
+    instanceData_.insert(instanceData_.end(), src, src + instanceStride_);
+    vao = InstancedVao(*item.Vao)->vao_;
+  }
+
+  DrawCommand command{
+    .Program = item.Program->Handle(),
+    .Vao = vao,
+    .Material = item.Material,
+    .Mode = item.Mode,
+    .Count = item.Count,
+    .IndexType = item.Vao->ibo_ ? item.Vao->ibo_->valuetype_ : 0,
+    .Offset = item.Offset,
+    .ObjectBuffer = item.ObjectBuffer,
+    .ObjectOffset = item.ObjectOffset,
+    .ObjectSize = item.ObjectSize,
+    .Instance = instance,
+  };
+  Push(MakeSortKey(item,
+                   DenseId(programIds_, command.Program, SORT_KEY_PROGRAMS),
+                   DenseId(vaoIds_, command.Vao, SORT_KEY_VAOS)),
+       command);
+}
+
+void
+CommandQueue::Push(uint64_t key, const DrawCommand& command)
+{
+  keys_.push_back({ key, static_cast<uint32_t>(commands_.size()) });
+  commands_.push_back(command);
+}
+
+void
+CommandQueue::Sort()
+{
+  temp_.resize(keys_.size());
+  RadixSort(keys_, temp_);
+}
+
+void
+CommandQueue::Clear()
+{
+  commands_.clear();
+  keys_.clear();
+  instanceData_.clear();
+}
+
+static bool
+CanInstance(const DrawCommand& lhs, const DrawCommand& rhs)
+{
+  return lhs.Instance != DrawCommand::NO_INSTANCE &&
+         rhs.Instance != DrawCommand::NO_INSTANCE &&
+         lhs.Program == rhs.Program && lhs.Material == rhs.Material &&
+         lhs.Vao == rhs.Vao && lhs.Mode == rhs.Mode &&
+         lhs.Count == rhs.Count && lhs.IndexType == rhs.IndexType &&
+         lhs.Offset == rhs.Offset && lhs.ObjectBuffer == rhs.ObjectBuffer &&
+         lhs.ObjectOffset == rhs.ObjectOffset &&
+         lhs.ObjectSize == rhs.ObjectSize;
+}
+
+void
+CommandQueue::DrawInstanced(const DrawCommand& command,
+                            uint32_t first,
+                            uint32_t count)
+{
+  auto indices =
+    reinterpret_cast<void*>(static_cast<uint64_t>(command.Offset));
+  if (GLEW_ARB_base_instance) {
+    if (command.IndexType) {
+      glDrawElementsInstancedBaseInstance(command.Mode,
+                                          command.Count,
+                                          command.IndexType,
+                                          indices,
+                                          count,
+                                          first);
+    } else {
+      glDrawArraysInstancedBaseInstance(
+        command.Mode, command.Offset, command.Count, count, first);
+    }
+    return;
+  }
+
+  // point the instance attributes of the bound vao at the first instance
+  instances_->Bind();
+  for (auto& layout : instanceLayouts_) {
+    glVertexAttribPointer(layout.Id.AttributeLocation,
+                          layout.Count,
+                          *GLType(layout.Type),
+                          layout.Normalized ? GL_TRUE : GL_FALSE,
+                          instanceStride_,
+                          reinterpret_cast<void*>(static_cast<uint64_t>(
+                            layout.Offset + first * instanceStride_)));
+  }
+  if (command.IndexType) {
+    glDrawElementsInstanced(
+      command.Mode, command.Count, command.IndexType, indices, count);
+  } else {
+    glDrawArraysInstanced(command.Mode, command.Offset, command.Count, count);
+  }
+}
+
+CommandQueueStatistics
+CommandQueue::Execute()
+{
+  Sort();
+
+  // instance data in the sorted order. a run is contiguous
+  auto& firsts = instanceFirsts_;
+  firsts.resize(keys_.size());
+  if (instanceData_.size()) {
+    sortedInstances_.resize(instanceData_.size());
+    uint32_t sorted = 0;
+    for (uint32_t i = 0; i < keys_.size(); ++i) {
+      auto& command = commands_[keys_[i].Index];
+      if (command.Instance == DrawCommand::NO_INSTANCE) {
+        continue;
+      }
+      firsts[i] = sorted;
+      memcpy(sortedInstances_.data() + sorted * instanceStride_,
+             instanceData_.data() + command.Instance * instanceStride_,
+             instanceStride_);
+      ++sorted;
+    }
+    instances_->Orphan(sortedInstances_.size(), sortedInstances_.data());
+  }
+
+  CommandQueueStatistics stats;
+  auto& state = StateCache::Current();
+  const DrawCommand* last = nullptr;
+  for (uint32_t i = 0; i < keys_.size(); ++i) {
+    auto& command = commands_[keys_[i].Index];
+    if (!last || last->Program != command.Program) {
+      state.UseProgram(command.Program);
+      ++stats.ProgramChanges;
+    }
+    if (!last || last->Material != command.Material) {
+      for (auto& texture : materials_[command.Material]) {
+        state.BindTexture(texture.Unit, texture.Target, texture.Handle);
+        if (texture.Sampler || GLEW_ARB_sampler_objects) {
+          state.BindSampler(texture.Unit, texture.Sampler);
+        }
+      }
+      ++stats.MaterialChanges;
+    }
+    if (!last || last->Vao != command.Vao) {
+      state.BindVertexArray(command.Vao);
+      ++stats.VaoChanges;
+    }
+    if (command.ObjectBuffer) {
+      state.BindBufferRange(GL_UNIFORM_BUFFER,
+                            ObjectBinding,
+                            command.ObjectBuffer,
+                            command.ObjectOffset,
+                            command.ObjectSize);
+    }
+    if (command.Instance != DrawCommand::NO_INSTANCE) {
+      auto end = i + 1;
+      while (end < keys_.size() &&
+             CanInstance(command, commands_[keys_[end].Index])) {
+        ++end;
+      }
+      DrawInstanced(command, firsts[i], end - i);
+      ++stats.InstancedDraws;
+      stats.Instances += end - i;
+      i = end - 1;
+    } else if (command.IndexType) {
+      glDrawElements(
+        command.Mode,
+        command.Count,
+        command.IndexType,
+        reinterpret_cast<void*>(static_cast<uint64_t>(command.Offset)));
+    } else {
+      glDrawArrays(command.Mode, command.Offset, command.Count);
+    }
+    ++stats.Draws;
+    last = &command;
+  }
+
+  Clear();
+  PurgeInstancedVaos();
+  return stats;
+}
+
+uint32_t
+CommandQueue::PurgeInstancedVaos()
+{
+  uint32_t count = 0;
+  for (auto it = instancedVaos_.begin(); it != instancedVaos_.end();) {
+    // the source vao holds every source buffer. if the instanced one is the
+    // only owner of a buffer, the source is gone
+    auto& instanced = *it->second;
+    auto stale = instanced.ibo_ && instanced.ibo_.use_count() == 1;
+    for (size_t i = 0; i + 1 < instanced.slots_.size(); ++i) {
+      if (instanced.slots_[i].use_count() == 1) {
+        stale = true;
+      }
+    }
+    if (stale) {
+      it = instancedVaos_.erase(it);
+      ++count;
+    } else {
+      ++it;
+    }
+  }
+  return count;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,229 @@
+#pragma once
+#include "../radixsort.h"
+#include "../vertexlayout.h"
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+class ShaderProgram;
+struct Vao;
+class Vbo;
+
+//
+// sort key, msb first
+//
+// 63-56 layer     e.g. opaque, sky, transparent. drawn in this order
+// 55-44 program   4096 programs
+// 43-28 material  65536 texture sets
+// 27-16 vao       4096 vertex arrays
+// 15- 0 depth     16 bit. front to back
+//
+// back to front, e.g. a transparent layer. the depth orders the whole layer
+// and the state only groups draws at the same depth
+//
+// 63-56 layer
+// 55-40 depth     16 bit. inverted
+// 39-28 program
+// 27-12 material
+// 11- 0 vao
+//
+// program, material and vao are dense ids assigned by the queue, so the
+// handles do not have to be small. the ids are not recycled, a queue sees at
+// most SORT_KEY_PROGRAMS programs, SORT_KEY_MATERIALS materials and
+// SORT_KEY_VAOS vertex arrays in its lifetime. asserted, more would alias.
+//
+constexpr uint32_t SORT_KEY_PROGRAMS = 0x1000;
+constexpr uint32_t SORT_KEY_MATERIALS = 0x10000;
+constexpr uint32_t SORT_KEY_VAOS = 0x1000;
+
+inline uint64_t
+MakeSortKey(uint32_t layer,
+            uint32_t program,
+            uint32_t material,
+            uint32_t vao,
+            uint32_t depth)
+{
+  return (static_cast<uint64_t>(layer & 0xFF) << 56) |
+         (static_cast<uint64_t>(program & (SORT_KEY_PROGRAMS - 1)) << 44) |
+         (static_cast<uint64_t>(material & (SORT_KEY_MATERIALS - 1)) << 28) |
+         (static_cast<uint64_t>(vao & (SORT_KEY_VAOS - 1)) << 16) |
+         (depth & 0xFFFF);
+}
+
+inline uint64_t
+MakeBackToFrontSortKey(uint32_t layer,
+                       uint32_t depth,
+                       uint32_t program,
+                       uint32_t material,
+                       uint32_t vao)
+{
+  return (static_cast<uint64_t>(layer & 0xFF) << 56) |
+         (static_cast<uint64_t>(depth & 0xFFFF) << 40) |
+         (static_cast<uint64_t>(program & (SORT_KEY_PROGRAMS - 1)) << 28) |
+         (static_cast<uint64_t>(material & (SORT_KEY_MATERIALS - 1)) << 12) |
+         (vao & (SORT_KEY_VAOS - 1));
+}
+
+struct TextureBinding
+{
+  uint32_t Unit;
+  // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+  uint32_t Target;
+  uint32_t Handle;
+  // gl3::Sampler. 0 for the parameters of the texture
+  uint32_t Sampler = 0;
+};
+
+// a recorded draw. plain data, no ownership. the objects must live until
+// Execute.
+struct DrawCommand
+{
+  uint32_t Program;
+  uint32_t Vao;
+  uint32_t Material;
+  uint32_t Mode;
+  uint32_t Count;
+  // GL_UNSIGNED_SHORT... 0 for glDrawArrays
+  uint32_t IndexType;
+  // bytes into the index buffer, or the first vertex
+  uint32_t Offset;
+  // a range bound to ObjectBinding. Buffer 0 for none
+  uint32_t ObjectBuffer;
+  uint32_t ObjectOffset;
+  uint32_t ObjectSize;
+  // into the instance data of the queue. Vao is the instanced one
+  uint32_t Instance = NO_INSTANCE;
+
+  static constexpr uint32_t NO_INSTANCE = 0xFFFFFFFF;
+};
+
+struct DrawItem
+{
+  uint8_t Layer = 0;
+  // [0, 1]. view depth / far for example
+  float Depth = 0;
+  bool BackToFront = false;
+  ShaderProgram* Program = nullptr;
+  gl3::Vao* Vao = nullptr;
+  uint32_t Material = 0;
+  uint32_t Mode = 0x0004 /*GL_TRIANGLES*/;
+  uint32_t Count = 0;
+  uint32_t Offset = 0;
+  uint32_t ObjectBuffer = 0;
+  uint32_t ObjectOffset = 0;
+  uint32_t ObjectSize = 0;
+  // the per instance attributes of this draw. stride bytes, copied by Push.
+  // needs EnableInstancing
+  const void* Instance = nullptr;
+};
+
+// the key of an item with the dense program and vao ids
+inline uint64_t
+MakeSortKey(const DrawItem& item, uint32_t program, uint32_t vao)
+{
+  auto depth = static_cast<uint32_t>(
+    std::clamp(item.BackToFront ? 1.0f - item.Depth : item.Depth, 0.0f, 1.0f) *
+    0xFFFF);
+  if (item.BackToFront) {
+    return MakeBackToFrontSortKey(
+      item.Layer, depth, program, item.Material, vao);
+  }
+  return MakeSortKey(item.Layer, program, item.Material, vao, depth);
+}
+
+struct CommandQueueStatistics
+{
+  // gl calls. an instanced draw is one
+  uint32_t Draws = 0;
+  uint32_t InstancedDraws = 0;
+  // drawn by the instanced draws
+  uint32_t Instances = 0;
+  uint32_t ProgramChanges = 0;
+  uint32_t MaterialChanges = 0;
+  uint32_t VaoChanges = 0;
+};
+
+//
+// records draws, sorts them by key and executes with the state changes
+// between neighbours only.
+//
+//   auto material = queue.AddMaterial(textures); // once
+//   queue.Push({ .Program = shader, .Vao = vao, .Material = material ...});
+//   queue.Execute(); // sorts and clears
+//
+// with EnableInstancing, items that have Instance data and the same program,
+// material, vao and range become one instanced draw. they are neighbours after
+// the sort, as depth is the lowest part of the key. not for BackToFront, the
+// depth is over the state.
+//
+class CommandQueue
+{
+  std::vector<std::vector<TextureBinding>> materials_;
+  std::unordered_map<uint32_t, uint32_t> programIds_;
+  std::unordered_map<uint32_t, uint32_t> vaoIds_;
+
+  std::vector<VertexLayout> instanceLayouts_;
+  uint32_t instanceStride_ = 0;
+  std::shared_ptr<Vbo> instances_;
+  // source vao handle to the vao with the instance attributes. the last slot
+  // is instances_
+  std::unordered_map<uint32_t, std::shared_ptr<Vao>> instancedVaos_;
+  std::vector<uint8_t> instanceData_;
+  std::vector<uint8_t> sortedInstances_;
+  // of each sorted command
+  std::vector<uint32_t> instanceFirsts_;
+
+  std::vector<DrawCommand> commands_;
+  std::vector<SortKey> keys_;
+  std::vector<SortKey> temp_;
+
+  uint32_t DenseId(std::unordered_map<uint32_t, uint32_t>& ids,
+                   uint32_t handle,
+                   uint32_t limit);
+  const std::shared_ptr<Vao>& InstancedVao(const Vao& vao);
+  void DrawInstanced(const DrawCommand& command,
+                     uint32_t first,
+                     uint32_t count);
+
+public:
+  // the binding point of DrawCommand::Object*
+  uint32_t ObjectBinding = 1;
+
+  CommandQueue();
+
+  // per instance attributes at stride bytes per DrawItem::Instance.
+  // Slot is ignored, Divisor 0 is taken as 1. e.g. LocalVarsInstanceLayouts
+  void EnableInstancing(std::span<const VertexLayout> layouts,
+                        uint32_t stride);
+
+  // material 0 binds no texture. up to SORT_KEY_MATERIALS
+  uint32_t AddMaterial(std::span<const TextureBinding> textures);
+  void Push(const DrawItem& item);
+  // for a key made by the caller
+  void Push(uint64_t key, const DrawCommand& command);
+  uint32_t Size() const { return commands_.size(); }
+
+  // sort and draw everything recorded, then clear and PurgeInstancedVaos
+  CommandQueueStatistics Execute();
+  // drops the instanced vaos of deleted source vaos, that would keep their
+  // buffers alive. the count dropped
+  uint32_t PurgeInstancedVaos();
+  // sort only. Command(i) in the sorted order
+  void Sort();
+  void Clear();
+  const DrawCommand& Command(uint32_t i) const
+  {
+    return commands_[keys_[i].Index];
+  }
+  uint64_t Key(uint32_t i) const { return keys_[i].Key; }
+};
+
+} // namespace
+} // namespace
@@ -1,6 +1,8 @@
 #pragma once
 #include "../image.h"
+#include "statecache.h"
 #include "texture.h"
+#include <span>
 #include <stdint.h>
 
 namespace grapho {
@@ -14,47 +16,124 @@ class Cubemap
 
 public:
   Cubemap() { glGenTextures(1, &m_handle); }
-  ~Cubemap() { glDeleteTextures(1, &m_handle); }
+  ~Cubemap()
+  {
+    glDeleteTextures(1, &m_handle);
+    StateCache::Current().DeletedTexture(m_handle);
+  }
   uint32_t Handle() const { return m_handle; }
+  int Width() const { return m_width; }
+  int Height() const { return m_height; }
+  // the storage of levels for 6 faces of the size of data. immutable where
+  // supported, so levels must cover every later Upload and GenerateMipmap.
+  // the pixels are not uploaded
   static std::shared_ptr<Cubemap> Create(const Image& data,
-                                         bool useFloat = false)
+                                         bool useFloat = false,
+                                         int levels = 1)
   {
     auto ptr = std::shared_ptr<Cubemap>(new Cubemap());
     ptr->m_width = data.Width;
     ptr->m_height = data.Height;
     ptr->Bind();
     if (auto format = GLImageFormat(data.Format, data.ColorSpace)) {
-      for (unsigned int i = 0; i < 6; ++i) {
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                     0,
+      GLTexStorage2D(GL_TEXTURE_CUBE_MAP,
+                     levels,
                      *format,
+                     data.Format,
                      data.Width,
-                     data.Height,
-                     0,
-                     GLInternalFormat(data.Format),
-                     useFloat ? GL_FLOAT : GL_UNSIGNED_BYTE,
-                     nullptr);
-      }
+                     data.Height);
       glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
       glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
       glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     }
-    ptr->UnBind();
     ptr->SamplingLinear();
 
     return ptr;
   }
 
+  // levels[level * 6 + face], level 0 first. e.g. TextureFileView::Images.
+  // immutable storage where supported. nullptr for an unsupported format
+  // or size
+  static std::shared_ptr<Cubemap> Create(std::span<const Image> levels)
+  {
+    if (levels.empty() || levels.size() % 6) {
+      return {};
+    }
+    auto& base = levels[0];
+    auto format = GLImageFormat(base.Format, base.ColorSpace);
+    if (!format ||
+        !IsTextureSizeSupported(GL_TEXTURE_CUBE_MAP, base.Width, base.Height)) {
+      return {};
+    }
+    auto ptr = std::shared_ptr<Cubemap>(new Cubemap());
+    ptr->m_width = base.Width;
+    ptr->m_height = base.Height;
+    ptr->Bind();
+    GLTexStorage2D(GL_TEXTURE_CUBE_MAP,
+                   levels.size() / 6,
+                   *format,
+                   base.Format,
+                   base.Width,
+                   base.Height);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (uint32_t i = 0; i < levels.size(); ++i) {
+      auto& level = levels[i];
+      GLTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i % 6,
+                      i / 6,
+                      *format,
+                      base.Format,
+                      level.Width,
+                      level.Height,
+                      GLPixelType(base.Format),
+                      level.Pixels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    ptr->MaxLevel(levels.size() / 6 - 1);
+    ptr->SamplingLinear(levels.size() > 6);
+    return ptr;
+  }
+
+  // face: GL_TEXTURE_CUBE_MAP_POSITIVE_X + face. into the storage of
+  // Create, mipLevel within its levels and data of the level size.
+  // a compressed face has no GenerateMipmap, upload each level
+  void Upload(int face, const Image& data, bool useFloat, int mipLevel = 0)
+  {
+    Bind();
+    if (auto format = GLImageFormat(data.Format, data.ColorSpace)) {
+      GLTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                      mipLevel,
+                      *format,
+                      data.Format,
+                      data.Width,
+                      data.Height,
+                      useFloat ? GL_FLOAT : GL_UNSIGNED_BYTE,
+                      data.Pixels);
+    }
+  }
+
+  // limit sampling to the uploaded mip levels
+  void MaxLevel(int level)
+  {
+    Bind();
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, level);
+  }
+
   void GenerateMipmap()
   {
     // then let OpenGL generate mipmaps from first mip face (combatting visible
     // dots artifact)
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_handle);
+    Bind();
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
   }
 
-  void Bind() { glBindTexture(GL_TEXTURE_CUBE_MAP, m_handle); }
-  void UnBind() { glBindTexture(GL_TEXTURE_CUBE_MAP, 0); }
+  void Bind()
+  {
+    StateCache::Current().BindTexture(GL_TEXTURE_CUBE_MAP, m_handle);
+  }
+  void UnBind() { StateCache::Current().BindTexture(GL_TEXTURE_CUBE_MAP, 0); }
 
   void SamplingLinear(bool mip = false)
   {
@@ -68,13 +147,11 @@ public:
       glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
       glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     }
-    UnBind();
   }
 
   void Activate(uint32_t unit)
   {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_handle);
+    StateCache::Current().BindTexture(unit, GL_TEXTURE_CUBE_MAP, m_handle);
   }
 };
 
@@ -3,6 +3,7 @@
 #include <GL/glew.h>
 #include <grapho/mesh.h>
 #include <grapho/gl3/fbo.h>
+#include <grapho/gl3/statecache.h>
 
 namespace grapho {
 namespace gl3 {
@@ -71,7 +72,7 @@ CubeRenderer::Render(int size,
     m_cube->Draw(m_mode, m_cubeDrawCount);
     assert(!TryGetError());
   }
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  StateCache::Current().BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 } // namespace
@@ -1,6 +1,7 @@
 #include <GL/glew.h>
 
 #include "fbo.h"
+#include "statecache.h"
 
 namespace grapho::gl3 {
 
@@ -37,6 +38,7 @@ Fbo::Fbo()
 Fbo::~Fbo()
 {
   glDeleteFramebuffers(1, &m_fbo);
+  StateCache::Current().DeletedFramebuffer(m_fbo);
   if (m_rbo) {
     glDeleteRenderbuffers(1, &m_rbo);
   }
@@ -45,13 +47,13 @@ Fbo::~Fbo()
 void
 Fbo::Bind()
 {
-  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  StateCache::Current().BindFramebuffer(GL_FRAMEBUFFER, m_fbo);
 }
 
 void
 Fbo::Unbind()
 {
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  StateCache::Current().BindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void
@@ -65,7 +67,7 @@ Fbo::AttachDepth(int width, int height)
   glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
   glFramebufferRenderbuffer(
     GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_rbo);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  Unbind();
 }
 
 void
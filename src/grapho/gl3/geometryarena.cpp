@@ -0,0 +1,240 @@
+#include <GL/glew.h>
+
+#include "geometryarena.h"
+#include "statecache.h"
+#include "vao.h"
+#include <algorithm>
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+GeometryArena::GeometryArena(std::span<const VertexLayout> layouts,
+                             uint32_t maxVertices,
+                             uint32_t maxIndices)
+  : layouts_(layouts.begin(), layouts.end())
+  , vertices_(maxVertices)
+  , indices_(maxIndices)
+{
+  for (auto& layout : layouts_) {
+    if (layout.Id.Slot >= strides_.size()) {
+      strides_.resize(layout.Id.Slot + 1);
+    }
+    strides_[layout.Id.Slot] = layout.Stride;
+  }
+  for (auto stride : strides_) {
+    slots_.push_back(Vbo::Create(stride * maxVertices, nullptr));
+  }
+  ibo_ = Ibo::Create(maxIndices * 4, nullptr, GL_UNSIGNED_INT);
+  vao_ = gl3::Vao::Create(make_span(layouts_), make_span(slots_), ibo_);
+}
+
+std::shared_ptr<GeometryArena>
+GeometryArena::Create(std::span<const VertexLayout> layouts,
+                      uint32_t maxVertices,
+                      uint32_t maxIndices)
+{
+  if (layouts.empty()) {
+    return {};
+  }
+  return std::make_shared<GeometryArena>(layouts, maxVertices, maxIndices);
+}
+
+static bool
+IsSameLayout(const VertexLayout& lhs, const VertexLayout& rhs)
+{
+  return lhs.Id.AttributeLocation == rhs.Id.AttributeLocation &&
+         lhs.Id.Slot == rhs.Id.Slot && lhs.Type == rhs.Type &&
+         lhs.Count == rhs.Count && lhs.Offset == rhs.Offset &&
+         lhs.Stride == rhs.Stride && lhs.Divisor == rhs.Divisor &&
+         lhs.Normalized == rhs.Normalized;
+}
+
+static bool
+WidenIndices(const Mesh& mesh, std::vector<uint32_t>& indices)
+{
+  auto count = mesh.DrawCount();
+  indices.resize(count);
+  if (!mesh.Indices.Size()) {
+    for (uint32_t i = 0; i < count; ++i) {
+      indices[i] = i;
+    }
+    return true;
+  }
+  auto data = mesh.Indices.Data();
+  switch (mesh.Indices.Stride()) {
+    case 1:
+      for (uint32_t i = 0; i < count; ++i) {
+        indices[i] = data[i];
+      }
+      return true;
+    case 2:
+      for (uint32_t i = 0; i < count; ++i) {
+        indices[i] = reinterpret_cast<const uint16_t*>(data)[i];
+      }
+      return true;
+    case 4:
+      memcpy(indices.data(), data, count * 4);
+      return true;
+  }
+  return false;
+}
+
+std::optional<uint32_t>
+GeometryArena::Add(const Mesh& mesh)
+{
+  if (mesh.SlotCount() != strides_.size() ||
+      mesh.Layouts.size() != layouts_.size()) {
+    return std::nullopt;
+  }
+  for (size_t i = 0; i < layouts_.size(); ++i) {
+    if (!IsSameLayout(mesh.Layouts[i], layouts_[i])) {
+      return std::nullopt;
+    }
+  }
+  auto vertexCount = mesh.Vertices.Count;
+  for (uint32_t slot = 0; slot < strides_.size(); ++slot) {
+    if (mesh.Slot(slot).Count != vertexCount) {
+      return std::nullopt;
+    }
+  }
+  std::vector<uint32_t> indices;
+  if (!WidenIndices(mesh, indices)) {
+    return std::nullopt;
+  }
+
+  auto baseVertex = vertices_.Allocate(vertexCount);
+  if (!baseVertex) {
+    return std::nullopt;
+  }
+  auto firstIndex = indices_.Allocate(indices.size());
+  if (!firstIndex) {
+    vertices_.Free(*baseVertex, vertexCount);
+    return std::nullopt;
+  }
+
+  for (uint32_t slot = 0; slot < strides_.size(); ++slot) {
+    auto& stream = mesh.Slot(slot);
+    slots_[slot]->Upload(
+      *baseVertex * strides_[slot], stream.Size(), stream.Data());
+  }
+  ibo_->Upload(*firstIndex * 4, indices.size() * 4, indices.data());
+
+  Entry entry{
+    .Range = {
+      .FirstIndex = *firstIndex,
+      .IndexCount = static_cast<uint32_t>(indices.size()),
+      .BaseVertex = static_cast<int32_t>(*baseVertex),
+      .VertexCount = vertexCount,
+    },
+    .Used = true,
+  };
+  if (freeEntries_.size()) {
+    auto id = freeEntries_.back();
+    freeEntries_.pop_back();
+    entries_[id] = entry;
+    return id;
+  }
+  entries_.push_back(entry);
+  return entries_.size() - 1;
+}
+
+void
+GeometryArena::Remove(uint32_t mesh)
+{
+  auto& entry = entries_[mesh];
+  if (!entry.Used) {
+    return;
+  }
+  vertices_.Free(entry.Range.BaseVertex, entry.Range.VertexCount);
+  indices_.Free(entry.Range.FirstIndex, entry.Range.IndexCount);
+  entry.Used = false;
+  freeEntries_.push_back(mesh);
+}
+
+struct RangeMove
+{
+  uint32_t Src;
+  uint32_t Dst;
+  uint32_t Size;
+};
+
+// the moves in elements of stride bytes. they may overlap, so copy to a
+// scratch buffer and back.
+static void
+CopyCompacted(uint32_t buffer,
+              uint32_t stride,
+              const std::vector<RangeMove>& moves,
+              uint32_t used)
+{
+  if (used == 0) {
+    return;
+  }
+  auto& state = StateCache::Current();
+  GLuint scratch;
+  glGenBuffers(1, &scratch);
+  state.BindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+  glBufferData(GL_COPY_WRITE_BUFFER, used * stride, nullptr, GL_STREAM_COPY);
+  state.BindBuffer(GL_COPY_READ_BUFFER, buffer);
+  for (auto& move : moves) {
+    glCopyBufferSubData(GL_COPY_READ_BUFFER,
+                        GL_COPY_WRITE_BUFFER,
+                        move.Src * stride,
+                        move.Dst * stride,
+                        move.Size * stride);
+  }
+  state.BindBuffer(GL_COPY_READ_BUFFER, scratch);
+  state.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+  glCopyBufferSubData(
+    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used * stride);
+  glDeleteBuffers(1, &scratch);
+  state.DeletedBuffer(scratch);
+}
+
+void
+GeometryArena::Defragment()
+{
+  std::vector<uint32_t> live;
+  for (uint32_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].Used) {
+      live.push_back(i);
+    }
+  }
+
+  // vertices in the order of the current offsets
+  std::sort(live.begin(), live.end(), [this](auto lhs, auto rhs) {
+    return entries_[lhs].Range.BaseVertex < entries_[rhs].Range.BaseVertex;
+  });
+  std::vector<RangeMove> moves;
+  uint32_t vertexCount = 0;
+  for (auto id : live) {
+    auto& range = entries_[id].Range;
+    moves.push_back({ static_cast<uint32_t>(range.BaseVertex),
+                      vertexCount,
+                      range.VertexCount });
+    range.BaseVertex = vertexCount;
+    vertexCount += range.VertexCount;
+  }
+  for (uint32_t slot = 0; slot < slots_.size(); ++slot) {
+    CopyCompacted(slots_[slot]->Handle(), strides_[slot], moves, vertexCount);
+  }
+  vertices_.Reset(vertices_.Capacity(), vertexCount);
+
+  // the indices are relative to the base vertex and stay as they are
+  std::sort(live.begin(), live.end(), [this](auto lhs, auto rhs) {
+    return entries_[lhs].Range.FirstIndex < entries_[rhs].Range.FirstIndex;
+  });
+  moves.clear();
+  uint32_t indexCount = 0;
+  for (auto id : live) {
+    auto& range = entries_[id].Range;
+    moves.push_back({ range.FirstIndex, indexCount, range.IndexCount });
+    range.FirstIndex = indexCount;
+    indexCount += range.IndexCount;
+  }
+  CopyCompacted(ibo_->Handle(), 4, moves, indexCount);
+  indices_.Reset(indices_.Capacity(), indexCount);
+}
+
+} // namespace
+} // namespace
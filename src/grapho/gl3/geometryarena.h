@@ -0,0 +1,97 @@
+#pragma once
+#include "../rangeallocator.h"
+#include "../vertexlayout.h"
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+class Vbo;
+class Ibo;
+struct Vao;
+
+// a mesh in a GeometryArena
+struct MeshRange
+{
+  uint32_t FirstIndex;
+  uint32_t IndexCount;
+  int32_t BaseVertex;
+  uint32_t VertexCount;
+
+  // for Vao::Draw
+  uint32_t IndexOffsetBytes() const { return FirstIndex * 4; }
+};
+
+//
+// meshes of one vertex layout suballocated from a vertex buffer per slot and
+// one 32 bit index buffer, instead of buffers per mesh.
+//
+// a mesh is a handle. its range moves with Defragment, so look it up before
+// drawing.
+//
+//   auto mesh = arena->Add(*src);
+//   auto& range = arena->Range(*mesh);
+//   arena->Vao()->DrawBaseVertex(GL_TRIANGLES,
+//                                range.IndexCount,
+//                                range.IndexOffsetBytes(),
+//                                range.BaseVertex);
+//   arena->Remove(*mesh);
+//
+class GeometryArena
+{
+  std::vector<VertexLayout> layouts_;
+  std::vector<uint32_t> strides_;
+  std::vector<std::shared_ptr<Vbo>> slots_;
+  std::shared_ptr<Ibo> ibo_;
+  std::shared_ptr<gl3::Vao> vao_;
+
+  RangeAllocator vertices_;
+  RangeAllocator indices_;
+
+  struct Entry
+  {
+    MeshRange Range;
+    bool Used;
+  };
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> freeEntries_;
+
+public:
+  GeometryArena(std::span<const VertexLayout> layouts,
+                uint32_t maxVertices,
+                uint32_t maxIndices);
+  GeometryArena(const GeometryArena&) = delete;
+  GeometryArena& operator=(const GeometryArena&) = delete;
+
+  static std::shared_ptr<GeometryArena> Create(
+    std::span<const VertexLayout> layouts,
+    uint32_t maxVertices,
+    uint32_t maxIndices);
+
+  const std::vector<VertexLayout>& Layouts() const { return layouts_; }
+  const std::vector<std::shared_ptr<Vbo>>& Slots() const { return slots_; }
+  const std::shared_ptr<gl3::Ibo>& Ibo() const { return ibo_; }
+  // the layouts over the shared buffers
+  const std::shared_ptr<gl3::Vao>& Vao() const { return vao_; }
+
+  const RangeAllocator& Vertices() const { return vertices_; }
+  const RangeAllocator& Indices() const { return indices_; }
+
+  // nullopt if the layout differs or no free range is large enough.
+  // 8 and 16 bit indices are widened. a mesh without indices gets 0, 1, 2...
+  std::optional<uint32_t> Add(const Mesh& mesh);
+  void Remove(uint32_t mesh);
+  const MeshRange& Range(uint32_t mesh) const { return entries_[mesh].Range; }
+
+  // the free ranges merged into one at the end, when an Add does not fit
+  // after many Removes. copies the meshes on the gpu with glCopyBufferSubData
+  // through a scratch buffer. the buffers and the vao stay the same.
+  void Defragment();
+};
+
+} // namespace
+} // namespace
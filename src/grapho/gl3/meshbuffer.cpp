@@ -0,0 +1,194 @@
+#include <GL/glew.h>
+
+#include "meshbuffer.h"
+#include "ringbuffer.h"
+#include "statecache.h"
+#include "vao.h"
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+// frames of draw commands in flight
+const auto COMMAND_FRAMES = 3;
+
+MeshBuffer::MeshBuffer(std::span<const VertexLayout> layouts,
+                       uint32_t mode,
+                       uint32_t maxVertices,
+                       uint32_t maxIndices,
+                       uint32_t maxDraws,
+                       std::optional<uint32_t> drawIdLocation,
+                       bool indirect)
+  : arena_(GeometryArena::Create(layouts, maxVertices, maxIndices))
+  , mode_(mode)
+  , maxDraws_(maxDraws)
+  , drawIdLocation_(drawIdLocation)
+  , indirect_(indirect)
+{
+  vao_ = arena_->Vao();
+  if (indirect_) {
+    commandBuffer_ =
+      RingBuffer::Create(GL_DRAW_INDIRECT_BUFFER,
+                         sizeof(DrawElementsIndirectCommand) * maxDraws *
+                           COMMAND_FRAMES);
+    if (drawIdLocation_) {
+      std::vector<uint32_t> ids(maxDraws);
+      for (uint32_t i = 0; i < maxDraws; ++i) {
+        ids[i] = i;
+      }
+      auto layouts = arena_->Layouts();
+      auto slots = arena_->Slots();
+      layouts.push_back({
+        .Id = { .AttributeLocation = *drawIdLocation_,
+                .Slot = static_cast<uint32_t>(slots.size()) },
+        .Type = ValueType::UInt32,
+        .Count = 1,
+        .Offset = 0,
+        .Stride = 4,
+        .Divisor = 1,
+      });
+      slots.push_back(Vbo::Create(ids));
+      vao_ =
+        gl3::Vao::Create(make_span(layouts), make_span(slots), arena_->Ibo());
+    }
+  }
+}
+
+std::shared_ptr<MeshBuffer>
+MeshBuffer::Create(std::span<const VertexLayout> layouts,
+                   DrawMode mode,
+                   uint32_t maxVertices,
+                   uint32_t maxIndices,
+                   uint32_t maxDraws,
+                   std::optional<uint32_t> drawIdLocation,
+                   bool indirect)
+{
+  auto glMode = GLMode(mode);
+  if (!glMode || layouts.empty()) {
+    return {};
+  }
+  return std::make_shared<MeshBuffer>(layouts,
+                                      *glMode,
+                                      maxVertices,
+                                      maxIndices,
+                                      maxDraws,
+                                      drawIdLocation,
+                                      indirect && GLEW_ARB_multi_draw_indirect);
+}
+
+std::optional<uint32_t>
+MeshBuffer::Add(const Mesh& mesh)
+{
+  if (GLMode(mesh.Mode) != mode_) {
+    return std::nullopt;
+  }
+  return arena_->Add(mesh);
+}
+
+std::optional<uint32_t>
+MeshBuffer::Push(uint32_t mesh)
+{
+  if (commands_.size() >= maxDraws_) {
+    return std::nullopt;
+  }
+  auto& range = arena_->Range(mesh);
+  uint32_t id = commands_.size();
+  commands_.push_back({
+    .Count = range.IndexCount,
+    .InstanceCount = 1,
+    .FirstIndex = range.FirstIndex,
+    .BaseVertex = range.BaseVertex,
+    .BaseInstance = id,
+  });
+  return id;
+}
+
+bool
+MeshBuffer::DrawIndirect()
+{
+  auto size = commands_.size() * sizeof(DrawElementsIndirectCommand);
+  auto block = commandBuffer_->Allocate(size, 4);
+  if (!block) {
+    return false;
+  }
+  memcpy(block->Data, commands_.data(), size);
+  commandBuffer_->Flush();
+  commandBuffer_->Bind();
+  glMultiDrawElementsIndirect(
+    mode_,
+    GL_UNSIGNED_INT,
+    reinterpret_cast<void*>(static_cast<uint64_t>(block->Offset)),
+    commands_.size(),
+    0);
+  commandBuffer_->EndFrame();
+  return true;
+}
+
+void
+MeshBuffer::DrawFallback()
+{
+  if (drawIdLocation_ && indirect_) {
+    // the id array is enabled on vao_. a draw per mesh with the id as the
+    // base instance, as the indirect command would
+    for (uint32_t i = 0; i < commands_.size(); ++i) {
+      auto& command = commands_[i];
+      glDrawElementsInstancedBaseVertexBaseInstance(
+        mode_,
+        command.Count,
+        GL_UNSIGNED_INT,
+        reinterpret_cast<void*>(static_cast<uint64_t>(command.FirstIndex * 4)),
+        1,
+        command.BaseVertex,
+        i);
+    }
+    return;
+  }
+  if (drawIdLocation_) {
+    // no draw id in a multi draw. a draw per mesh with the id as the
+    // current value of the disabled attribute
+    for (uint32_t i = 0; i < commands_.size(); ++i) {
+      auto& command = commands_[i];
+      glVertexAttrib1f(*drawIdLocation_, static_cast<float>(i));
+      glDrawElementsBaseVertex(mode_,
+                               command.Count,
+                               GL_UNSIGNED_INT,
+                               reinterpret_cast<void*>(static_cast<uint64_t>(
+                                 command.FirstIndex * 4)),
+                               command.BaseVertex);
+    }
+    return;
+  }
+
+  counts_.resize(commands_.size());
+  offsets_.resize(commands_.size());
+  baseVertices_.resize(commands_.size());
+  for (uint32_t i = 0; i < commands_.size(); ++i) {
+    auto& command = commands_[i];
+    counts_[i] = command.Count;
+    offsets_[i] = reinterpret_cast<const void*>(
+      static_cast<uint64_t>(command.FirstIndex * 4));
+    baseVertices_[i] = command.BaseVertex;
+  }
+  glMultiDrawElementsBaseVertex(mode_,
+                                counts_.data(),
+                                GL_UNSIGNED_INT,
+                                offsets_.data(),
+                                commands_.size(),
+                                baseVertices_.data());
+}
+
+void
+MeshBuffer::Draw()
+{
+  if (commands_.empty()) {
+    return;
+  }
+  vao_->Bind();
+  if (!indirect_ || !DrawIndirect()) {
+    DrawFallback();
+  }
+  Clear();
+}
+
+} // namespace
+} // namespace
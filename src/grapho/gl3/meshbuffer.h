@@ -0,0 +1,103 @@
+#pragma once
+#include "geometryarena.h"
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+struct Vao;
+class RingBuffer;
+
+// the layout of glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+  uint32_t Count;
+  uint32_t InstanceCount;
+  uint32_t FirstIndex;
+  int32_t BaseVertex;
+  uint32_t BaseInstance;
+};
+
+//
+// many meshes of a GeometryArena drawn with one call.
+//
+// indirect: glMultiDrawElementsIndirect from the draw commands in a
+//           RingBuffer. ARB_multi_draw_indirect.
+// fallback: glMultiDrawElementsBaseVertex. GL 3.3.
+//
+// the draw id, the index of Push, is a float attribute at drawIdLocation.
+// indirect draws read it from a divisor 1 buffer of 0, 1, 2... through the
+// base instance. the fallback sets it with glVertexAttrib1f and a draw per
+// mesh. when the ring buffer is full an indirect buffer draws per mesh with
+// the id as the base instance. the shader fetches the object data with it,
+// e.g. from a texture buffer.
+//
+//   auto mesh = buffer->Add(*src); // once
+//   buffer->Push(*mesh);           // per frame
+//   buffer->Draw();                // draws and clears
+//
+class MeshBuffer
+{
+  std::shared_ptr<GeometryArena> arena_;
+  uint32_t mode_;
+  uint32_t maxDraws_;
+  std::optional<uint32_t> drawIdLocation_;
+  bool indirect_ = false;
+
+  // the arena buffers and the draw ids
+  std::shared_ptr<gl3::Vao> vao_;
+  std::shared_ptr<RingBuffer> commandBuffer_;
+
+  std::vector<DrawElementsIndirectCommand> commands_;
+  // fallback
+  std::vector<int32_t> counts_;
+  std::vector<const void*> offsets_;
+  std::vector<int32_t> baseVertices_;
+
+  bool DrawIndirect();
+  void DrawFallback();
+
+public:
+  MeshBuffer(std::span<const VertexLayout> layouts,
+             uint32_t mode,
+             uint32_t maxVertices,
+             uint32_t maxIndices,
+             uint32_t maxDraws,
+             std::optional<uint32_t> drawIdLocation,
+             bool indirect);
+  MeshBuffer(const MeshBuffer&) = delete;
+  MeshBuffer& operator=(const MeshBuffer&) = delete;
+
+  // indirect when ARB_multi_draw_indirect is available and indirect is true
+  static std::shared_ptr<MeshBuffer> Create(
+    std::span<const VertexLayout> layouts,
+    DrawMode mode,
+    uint32_t maxVertices,
+    uint32_t maxIndices,
+    uint32_t maxDraws,
+    std::optional<uint32_t> drawIdLocation = {},
+    bool indirect = true);
+
+  bool IsIndirect() const { return indirect_; }
+  const std::shared_ptr<gl3::Vao>& Vao() const { return vao_; }
+  // Defragment between frames, not between Push and Draw
+  const std::shared_ptr<GeometryArena>& Arena() const { return arena_; }
+
+  // a mesh of the arena. nullopt if the mode differs, or as GeometryArena::Add
+  std::optional<uint32_t> Add(const Mesh& mesh);
+  void Remove(uint32_t mesh) { arena_->Remove(mesh); }
+
+  // the draw id. nullopt over maxDraws
+  std::optional<uint32_t> Push(uint32_t mesh);
+  uint32_t Size() const { return commands_.size(); }
+  // everything pushed, then clear
+  void Draw();
+  void Clear() { commands_.clear(); }
+};
+
+} // namespace
+} // namespace
@@ -1,23 +1,39 @@
 #pragma once
+#include "../ibl/baker.h"
+#include "../ibl/cache.h"
+#include "../ibl/sh.h"
 #include "../mesh.h"
+#ifndef GRAPHO_NO_BRDF_LUT_TABLE
+#include "../ibl/brdflut_table.h"
+#endif
 #include "cubemap.h"
 #include "cuberenderer.h"
 #include "error_check.h"
 #include "fbo.h"
 #include "shader.h"
+#include "shaderbatch.h"
+#include "statecache.h"
+#include "ubo.h"
 #include "vao.h"
 #include <assert.h>
+#include <filesystem>
 
 namespace grapho {
 namespace gl3 {
 
+// how PbrEnv provides the diffuse irradiance
+enum class PbrIrradiance
+{
+  // 32x32 convoluted cubemap. texture unit 0
+  Cubemap,
+  // ibl::SH9 projected on the cpu. uniform block binding 2
+  SphericalHarmonics,
+};
+
 // pbr: generate a 2D LUT(look up table) from the BRDF equations used.
 inline std::shared_ptr<grapho::gl3::Texture>
-GenerateBrdfLUTTexture()
+GenerateBrdfLUTTexture(const std::shared_ptr<ShaderProgram>& brdfShader)
 {
-#include "shaders/brdf_fs.h"
-#include "shaders/brdf_vs.h"
-
   auto brdfLUTTexture =
     grapho::gl3::Texture::Create({ .Width = 512,
                                    .Height = 512,
@@ -30,7 +46,6 @@ GenerateBrdfLUTTexture()
   grapho::gl3::Fbo fbo;
   fbo.AttachTexture2D(brdfLUTTexture->Handle());
   grapho::gl3::ClearViewport(grapho::camera::Viewport{ 512, 512 });
-  auto brdfShader = grapho::gl3::ShaderProgram::Create(BRDF_VS, BRDF_FS);
   brdfShader->Use();
 
   // renderQuad() renders a 1x1 XY quad in NDC
@@ -40,67 +55,143 @@ GenerateBrdfLUTTexture()
   auto drawMode = *grapho::gl3::GLMode(quad->Mode);
   quadVao->Draw(drawMode, drawCount);
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  StateCache::Current().BindFramebuffer(GL_FRAMEBUFFER, 0);
 
   return brdfLUTTexture;
 }
 
+inline std::shared_ptr<grapho::gl3::Texture>
+GenerateBrdfLUTTexture()
+{
+#include "shaders/brdf_fs.h"
+#include "shaders/brdf_vs.h"
+  return GenerateBrdfLUTTexture(
+    grapho::gl3::ShaderProgram::Create(BRDF_VS, BRDF_FS));
+}
+
+// pbr: the BRDF LUT does not depend on the environment. upload the table
+// generated by example/brdflut instead of rendering it. falls back to
+// GenerateBrdfLUTTexture when the table is compiled out or rejected, with
+// brdfShader if given.
+inline std::shared_ptr<grapho::gl3::Texture>
+LoadBrdfLUTTexture(const std::shared_ptr<ShaderProgram>& brdfShader = {})
+{
+#ifndef GRAPHO_NO_BRDF_LUT_TABLE
+  // the storage only, then the halves as they are. left bound by Create
+  auto texture =
+    grapho::gl3::Texture::Create({ .Width = ibl::BRDF_LUT_SIZE,
+                                   .Height = ibl::BRDF_LUT_SIZE,
+                                   .Format = grapho::PixelFormat::f16_RG,
+                                   .ColorSpace = grapho::ColorSpace::Linear },
+                                 true);
+  GLTexSubImage2D(GL_TEXTURE_2D,
+                  0,
+                  GL_RG16F,
+                  grapho::PixelFormat::f16_RG,
+                  ibl::BRDF_LUT_SIZE,
+                  ibl::BRDF_LUT_SIZE,
+                  GL_HALF_FLOAT,
+                  ibl::BRDF_LUT);
+  // asks the texture, the errors of other calls stay pending
+  GLint format = 0;
+  glGetTexLevelParameteriv(
+    GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+  if (format == GL_RG16F) {
+    return texture;
+  }
+#endif
+  if (brdfShader) {
+    return GenerateBrdfLUTTexture(brdfShader);
+  }
+  return GenerateBrdfLUTTexture();
+}
+
 // pbr: convert HDR equirectangular environment map to cubemap equivalent
 inline void
-GenerateEnvCubeMap(const grapho::gl3::CubeRenderer& cubeRenderer,
-                   uint32_t envCubemap)
+GenerateEnvCubeMap(
+  const grapho::gl3::CubeRenderer& cubeRenderer,
+  uint32_t envCubemap,
+  const std::shared_ptr<ShaderProgram>& equirectangularToCubemapShader)
 {
-#include "shaders/cubemap_vs.h"
-#include "shaders/equirectangular_to_cubemap_fs.h"
-
-  auto equirectangularToCubemapShader =
-    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, EQUIRECTANGULAR_FS);
   equirectangularToCubemapShader->Use();
   equirectangularToCubemapShader->SetUniform("equirectangularMap", 0);
+  auto projectionUniform =
+    equirectangularToCubemapShader->FindUniform(UniformName("projection"));
+  auto viewUniform =
+    equirectangularToCubemapShader->FindUniform(UniformName("view"));
 
   cubeRenderer.Render(
     512,
     envCubemap,
-    [equirectangularToCubemapShader](const auto& projection, const auto& view) {
-      equirectangularToCubemapShader->SetUniform("projection", projection);
-      equirectangularToCubemapShader->SetUniform("view", view);
+    [equirectangularToCubemapShader, projectionUniform, viewUniform](
+      const auto& projection, const auto& view) {
+      equirectangularToCubemapShader->SetUniform(projectionUniform,
+                                                 projection);
+      equirectangularToCubemapShader->SetUniform(viewUniform, view);
     });
 }
 
+inline void
+GenerateEnvCubeMap(const grapho::gl3::CubeRenderer& cubeRenderer,
+                   uint32_t envCubemap)
+{
+#include "shaders/cubemap_vs.h"
+#include "shaders/equirectangular_to_cubemap_fs.h"
+  GenerateEnvCubeMap(
+    cubeRenderer,
+    envCubemap,
+    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, EQUIRECTANGULAR_FS));
+}
+
 // pbr: solve diffuse integral by convolution to create an irradiance
 // (cube)map.
 inline void
 GenerateIrradianceMap(const grapho::gl3::CubeRenderer& cubeRenderer,
-                      uint32_t irradianceMap)
+                      uint32_t irradianceMap,
+                      const std::shared_ptr<ShaderProgram>& irradianceShader)
 {
-#include "shaders/cubemap_vs.h"
-#include "shaders/irradiance_convolution_fs.h"
-  auto irradianceShader =
-    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, IRRADIANCE_CONVOLUTION_FS);
   irradianceShader->Use();
   irradianceShader->SetUniform("environmentMap", 0);
+  auto projectionUniform =
+    irradianceShader->FindUniform(UniformName("projection"));
+  auto viewUniform = irradianceShader->FindUniform(UniformName("view"));
 
   cubeRenderer.Render(
     32,
     irradianceMap,
-    [irradianceShader](const auto& projection, const auto& view) {
-      irradianceShader->SetUniform("projection", projection);
-      irradianceShader->SetUniform("view", view);
+    [irradianceShader, projectionUniform, viewUniform](const auto& projection,
+                                                       const auto& view) {
+      irradianceShader->SetUniform(projectionUniform, projection);
+      irradianceShader->SetUniform(viewUniform, view);
     });
 }
 
+inline void
+GenerateIrradianceMap(const grapho::gl3::CubeRenderer& cubeRenderer,
+                      uint32_t irradianceMap)
+{
+#include "shaders/cubemap_vs.h"
+#include "shaders/irradiance_convolution_fs.h"
+  GenerateIrradianceMap(
+    cubeRenderer,
+    irradianceMap,
+    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, IRRADIANCE_CONVOLUTION_FS));
+}
+
 // pbr: run a quasi monte-carlo simulation on the environment lighting to
 // create a prefilter (cube)map.
 inline void
 GeneratePrefilterMap(const grapho::gl3::CubeRenderer& cubeRenderer,
-                     uint32_t prefilterMap)
+                     uint32_t prefilterMap,
+                     const std::shared_ptr<ShaderProgram>& prefilterShader)
 {
-#include "shaders/cubemap_vs.h"
-#include "shaders/prefilter_fs.h"
-  auto prefilterShader =
-    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, PREFILTER_FS);
   prefilterShader->Use();
   prefilterShader->SetUniform("environmentMap", 0);
+  auto roughnessUniform =
+    prefilterShader->FindUniform(UniformName("roughness"));
+  auto projectionUniform =
+    prefilterShader->FindUniform(UniformName("projection"));
+  auto viewUniform = prefilterShader->FindUniform(UniformName("view"));
   assert(!TryGetError());
 
   unsigned int maxMipLevels = 5;
@@ -108,23 +199,131 @@ GeneratePrefilterMap(const grapho::gl3::CubeRenderer& cubeRenderer,
     // reisze framebuffer according to mip-level size.
     auto mipSize = static_cast<int>(128 * std::pow(0.5, mip));
     float roughness = (float)mip / (float)(maxMipLevels - 1);
-    prefilterShader->SetUniform("roughness", roughness);
+    prefilterShader->SetUniform(roughnessUniform, roughness);
 
     assert(!TryGetError());
     cubeRenderer.Render(
       mipSize,
       prefilterMap,
-      [prefilterShader](const auto& projection, const auto& view) {
-        prefilterShader->SetUniform("projection", projection);
-        prefilterShader->SetUniform("view", view);
+      [prefilterShader, projectionUniform, viewUniform](
+        const auto& projection, const auto& view) {
+        prefilterShader->SetUniform(projectionUniform, projection);
+        prefilterShader->SetUniform(viewUniform, view);
       },
       mip);
     assert(!TryGetError());
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    StateCache::Current().BindFramebuffer(GL_FRAMEBUFFER, 0);
   }
 }
 
+inline void
+GeneratePrefilterMap(const grapho::gl3::CubeRenderer& cubeRenderer,
+                     uint32_t prefilterMap)
+{
+#include "shaders/cubemap_vs.h"
+#include "shaders/prefilter_fs.h"
+  GeneratePrefilterMap(
+    cubeRenderer,
+    prefilterMap,
+    grapho::gl3::ShaderProgram::Create(CUBEMAP_VS, PREFILTER_FS));
+}
+
+// upload a cpu baked cubemap with all of its mip levels
+inline std::shared_ptr<Cubemap>
+CreateCubemap(const ibl::CubemapImage& baked)
+{
+  auto cubemap =
+    Cubemap::Create(baked.Mips[0][0].ToImage(), true, baked.MipCount());
+  for (int mip = 0; mip < baked.MipCount(); ++mip) {
+    for (int face = 0; face < 6; ++face) {
+      cubemap->Upload(face, baked.Mips[mip][face].ToImage(), true, mip);
+    }
+  }
+  cubemap->MaxLevel(baked.MipCount() - 1);
+  cubemap->SamplingLinear(baked.MipCount() > 1);
+  return cubemap;
+}
+
+// upload a cubemap from a mapped cache file without copying
+inline std::shared_ptr<Cubemap>
+CreateCubemap(const ibl::CacheView& cache, ibl::CacheMap map)
+{
+  auto mipCount = cache.MipCount(map);
+  std::shared_ptr<Cubemap> cubemap;
+  for (auto& entry : cache.Entries) {
+    if (entry.Map == map && entry.Mip == 0) {
+      cubemap = Cubemap::Create(cache.ToImage(entry), true, mipCount);
+      break;
+    }
+  }
+  if (!cubemap) {
+    return {};
+  }
+  for (auto& entry : cache.Entries) {
+    if (entry.Map == map) {
+      cubemap->Upload(entry.Face, cache.ToImage(entry), true, entry.Mip);
+    }
+  }
+  cubemap->MaxLevel(mipCount - 1);
+  cubemap->SamplingLinear(mipCount > 1);
+  return cubemap;
+}
+
+// gpu to cpu. rgb float. mips [baseMip, baseMip + mipCount)
+inline ibl::CubemapImage
+ReadCubemap(Cubemap& cubemap, int mipCount, int baseMip = 0)
+{
+  ibl::CubemapImage baked;
+  baked.Mips.resize(mipCount);
+  cubemap.Bind();
+  for (int mip = 0; mip < mipCount; ++mip) {
+    auto size = std::max(cubemap.Width() >> (baseMip + mip), 1);
+    for (int face = 0; face < 6; ++face) {
+      auto& image = baked.Mips[mip][face];
+      image = ibl::FloatImage(size, size);
+      glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                    baseMip + mip,
+                    GL_RGB,
+                    GL_FLOAT,
+                    image.Pixels.data());
+    }
+  }
+  cubemap.UnBind();
+  return baked;
+}
+
+inline ibl::FloatImage
+ReadTexture(const Texture& texture)
+{
+  ibl::FloatImage image(texture.Width(), texture.Height());
+  texture.Bind();
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_FLOAT, image.Pixels.data());
+  texture.Unbind();
+  return image;
+}
+
+// PBR_FS with the irradiance variant matching PbrEnv::Irradiance
+inline uint32_t
+AddPbrShader(ShaderBatch& batch, PbrIrradiance irradiance)
+{
+#include "shaders/pbr_fs.h"
+#include "shaders/pbr_vs.h"
+  if (irradiance == PbrIrradiance::Cubemap) {
+    return batch.Add(PBR_VS, PBR_FS);
+  }
+  // the define must follow the #version line
+  std::u8string_view src = PBR_FS;
+  auto pos = src.find(u8'\n') + 1;
+  std::u8string_view vs[] = { PBR_VS };
+  std::u8string_view fs[] = {
+    src.substr(0, pos),
+    u8"#define SH_IRRADIANCE\n",
+    src.substr(pos),
+  };
+  return batch.Add(vs, fs);
+}
+
 struct PbrEnv
 {
   std::shared_ptr<Cubemap> EnvCubemap;
@@ -132,12 +331,85 @@ struct PbrEnv
   std::shared_ptr<Cubemap> PrefilterMap;
   std::shared_ptr<Texture> BrdfLUTTexture;
 
+  // PbrIrradiance::SphericalHarmonics. IrradianceMap is not created.
+  PbrIrradiance Irradiance = PbrIrradiance::Cubemap;
+  ibl::SH9 IrradianceSH = {};
+  std::shared_ptr<Ubo> IrradianceSHUbo;
+
   // Skybox skybox;
   std::shared_ptr<grapho::gl3::Vao> Cube;
   uint32_t CubeDrawCount = 0;
   std::shared_ptr<grapho::gl3::ShaderProgram> BackgroundShader;
+  UniformHandle BackgroundProjection;
+  UniformHandle BackgroundView;
+  // CreatePbrShader(Irradiance), compiled with BackgroundShader
+  std::shared_ptr<grapho::gl3::ShaderProgram> PbrShader;
 
-  PbrEnv(const std::shared_ptr<Texture>& hdrTexture)
+  // the programs of Generate
+  struct Passes
+  {
+    std::shared_ptr<ShaderProgram> EquirectangularToCubemap;
+    std::shared_ptr<ShaderProgram> Irradiance;
+    std::shared_ptr<ShaderProgram> Prefilter;
+    // only without the BRDF table
+    std::shared_ptr<ShaderProgram> Brdf;
+  };
+
+  PbrEnv(const std::shared_ptr<Texture>& hdrTexture,
+         PbrIrradiance irradiance = PbrIrradiance::Cubemap)
+    : Irradiance(irradiance)
+  {
+    SetupState();
+    Generate(hdrTexture);
+    CreateSkybox();
+  }
+
+  // maps baked by ibl::BakePbrEnv. no render pass.
+  PbrEnv(const ibl::BakedPbrEnv& baked,
+         PbrIrradiance irradiance = PbrIrradiance::Cubemap)
+    : Irradiance(irradiance)
+  {
+    SetupState();
+
+    EnvCubemap = CreateCubemap(baked.EnvCubemap);
+    if (Irradiance == PbrIrradiance::SphericalHarmonics) {
+      SetIrradianceSH(ibl::ProjectSH9(baked.EnvCubemap));
+    } else {
+      IrradianceMap = CreateCubemap(baked.IrradianceMap);
+    }
+    PrefilterMap = CreateCubemap(baked.PrefilterMap);
+    BrdfLUTTexture =
+      grapho::gl3::Texture::Create(baked.BrdfLUT.ToImage(), true);
+    assert(!TryGetError());
+
+    CreateSkybox();
+  }
+
+  // load the maps from cacheDir if the hdr was baked before.
+  // otherwise render them and store for the next time.
+  PbrEnv(const Image& hdr,
+         const std::string& cacheDir,
+         PbrIrradiance irradiance = PbrIrradiance::Cubemap)
+    : Irradiance(irradiance)
+  {
+    SetupState();
+
+    // one file per irradiance, they hold different maps
+    auto key = ibl::CacheKey(hdr, {}, static_cast<uint32_t>(irradiance));
+    auto path = grapho::join_path(cacheDir, ibl::CacheFileName(key));
+    auto cache = ibl::OpenCache(path, key);
+    if (!cache || !Load(*cache)) {
+      Generate(grapho::gl3::Texture::Create(hdr, true));
+      std::error_code ec;
+      std::filesystem::create_directories(cacheDir, ec);
+      ibl::WriteCache(path, key, Read());
+    }
+    assert(!TryGetError());
+
+    CreateSkybox();
+  }
+
+  void SetupState()
   {
     glDisable(GL_CULL_FACE);
     glEnable(GL_DEPTH_TEST);
@@ -146,7 +418,57 @@ struct PbrEnv
     // enable seamless cubemap sampling for lower mip levels in the pre-filter
     // map.
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+  }
+
+  // PbrShader, BackgroundShader and the passes of Generate if generate, in
+  // one ShaderBatch so the driver compiles them together
+  Passes CompilePrograms(bool generate)
+  {
+#include "shaders/background_fs.h"
+#include "shaders/background_vs.h"
+#include "shaders/cubemap_vs.h"
+#include "shaders/equirectangular_to_cubemap_fs.h"
+#include "shaders/irradiance_convolution_fs.h"
+#include "shaders/prefilter_fs.h"
+    ShaderBatch batch;
+    auto pbr = AddPbrShader(batch, Irradiance);
+    auto background = batch.Add(BACKGROUND_VS, BACKGROUND_FS);
+    std::optional<uint32_t> env;
+    std::optional<uint32_t> irradiance;
+    std::optional<uint32_t> prefilter;
+    std::optional<uint32_t> brdf;
+    if (generate) {
+      env = batch.Add(CUBEMAP_VS, EQUIRECTANGULAR_FS);
+      if (Irradiance == PbrIrradiance::Cubemap) {
+        irradiance = batch.Add(CUBEMAP_VS, IRRADIANCE_CONVOLUTION_FS);
+      }
+      prefilter = batch.Add(CUBEMAP_VS, PREFILTER_FS);
+#ifdef GRAPHO_NO_BRDF_LUT_TABLE
+#include "shaders/brdf_fs.h"
+#include "shaders/brdf_vs.h"
+      brdf = batch.Add(BRDF_VS, BRDF_FS);
+#endif
+    }
+
+    auto programs = batch.Resolve();
+    auto get = [&programs](std::optional<uint32_t> index) {
+      return index ? programs[*index] : nullptr;
+    };
+    PbrShader = programs[pbr];
+    BackgroundShader = programs[background];
+    return {
+      .EquirectangularToCubemap = get(env),
+      .Irradiance = get(irradiance),
+      .Prefilter = get(prefilter),
+      .Brdf = get(brdf),
+    };
+  }
+
+  void Generate(const std::shared_ptr<Texture>& hdrTexture)
+  {
+    auto passes = CompilePrograms(true);
 
+    // every level for GenerateMipmap
     EnvCubemap = grapho::gl3::Cubemap::Create(
       {
         512,
@@ -154,29 +476,38 @@ struct PbrEnv
         grapho::PixelFormat::f16_RGB,
         grapho::ColorSpace::Linear,
       },
-      true);
+      true,
+      ibl::FullMipCount(512));
     EnvCubemap->SamplingLinear(true);
     assert(!TryGetError());
 
     // hdr to cuemap
     hdrTexture->Activate(0);
     grapho::gl3::CubeRenderer cubeRenderer;
-    grapho::gl3::GenerateEnvCubeMap(cubeRenderer, EnvCubemap->Handle());
+    grapho::gl3::GenerateEnvCubeMap(
+      cubeRenderer, EnvCubemap->Handle(), passes.EquirectangularToCubemap);
     EnvCubemap->GenerateMipmap();
     EnvCubemap->UnBind();
     assert(!TryGetError());
 
-    // irradianceMap
-    IrradianceMap = grapho::gl3::Cubemap::Create(
-      {
-        32,
-        32,
-        grapho::PixelFormat::f16_RGB,
-        grapho::ColorSpace::Linear,
-      },
-      true);
-    EnvCubemap->Activate(0);
-    grapho::gl3::GenerateIrradianceMap(cubeRenderer, IrradianceMap->Handle());
+    if (Irradiance == PbrIrradiance::SphericalHarmonics) {
+      // project a 32x32 mip of the env. no convolution pass.
+      auto mip = ibl::FullMipCount(EnvCubemap->Width()) - ibl::FullMipCount(32);
+      SetIrradianceSH(ibl::ProjectSH9(ReadCubemap(*EnvCubemap, 1, mip)));
+    } else {
+      // irradianceMap
+      IrradianceMap = grapho::gl3::Cubemap::Create(
+        {
+          32,
+          32,
+          grapho::PixelFormat::f16_RGB,
+          grapho::ColorSpace::Linear,
+        },
+        true);
+      EnvCubemap->Activate(0);
+      grapho::gl3::GenerateIrradianceMap(
+        cubeRenderer, IrradianceMap->Handle(), passes.Irradiance);
+    }
     assert(!TryGetError());
 
     // prefilterMap
@@ -187,19 +518,89 @@ struct PbrEnv
         grapho::PixelFormat::f16_RGB,
         grapho::ColorSpace::Linear,
       },
-      true);
+      true,
+      ibl::FullMipCount(128));
     PrefilterMap->SamplingLinear(true);
     PrefilterMap->GenerateMipmap();
     EnvCubemap->Activate(0);
     assert(!TryGetError());
-    grapho::gl3::GeneratePrefilterMap(cubeRenderer, PrefilterMap->Handle());
+    grapho::gl3::GeneratePrefilterMap(
+      cubeRenderer, PrefilterMap->Handle(), passes.Prefilter);
     assert(!TryGetError());
     assert(!TryGetError());
 
     // brdefLUT
-    BrdfLUTTexture = grapho::gl3::GenerateBrdfLUTTexture();
+    BrdfLUTTexture = grapho::gl3::LoadBrdfLUTTexture(passes.Brdf);
     assert(!TryGetError());
+  }
 
+  // false if a map is missing. a cache written in the sh mode has no
+  // irradiance map.
+  bool Load(const ibl::CacheView& cache)
+  {
+    if (Irradiance == PbrIrradiance::SphericalHarmonics) {
+      // the largest env mip not larger than 32
+      uint32_t size = 0;
+      for (auto& entry : cache.Entries) {
+        if (entry.Map == ibl::CacheMap::EnvCubemap && entry.Width <= 32) {
+          size = std::max(size, entry.Width);
+        }
+      }
+      const float* faces[6] = {};
+      for (auto& entry : cache.Entries) {
+        if (entry.Map == ibl::CacheMap::EnvCubemap && entry.Width == size &&
+            entry.Face < 6) {
+          faces[entry.Face] = cache.Pixels(entry);
+        }
+      }
+      for (auto face : faces) {
+        if (!face) {
+          return false;
+        }
+      }
+      SetIrradianceSH(ibl::ProjectSH9(faces, size));
+    } else {
+      if (cache.MipCount(ibl::CacheMap::IrradianceMap) == 0) {
+        return false;
+      }
+      IrradianceMap = CreateCubemap(cache, ibl::CacheMap::IrradianceMap);
+    }
+    EnvCubemap = CreateCubemap(cache, ibl::CacheMap::EnvCubemap);
+    PrefilterMap = CreateCubemap(cache, ibl::CacheMap::PrefilterMap);
+    for (auto& entry : cache.Entries) {
+      if (entry.Map == ibl::CacheMap::BrdfLUT) {
+        BrdfLUTTexture =
+          grapho::gl3::Texture::Create(cache.ToImage(entry), true);
+      }
+    }
+    return EnvCubemap && PrefilterMap && BrdfLUTTexture;
+  }
+
+  void SetIrradianceSH(const ibl::SH9& sh)
+  {
+    IrradianceSH = sh;
+    if (!IrradianceSHUbo) {
+      IrradianceSHUbo = Ubo::Create<ibl::SH9>();
+    }
+    IrradianceSHUbo->Upload(IrradianceSH);
+  }
+
+  // read back the rendered maps
+  ibl::BakedPbrEnv Read() const
+  {
+    ibl::BakeSettings settings;
+    return {
+      .EnvCubemap =
+        ReadCubemap(*EnvCubemap, ibl::FullMipCount(EnvCubemap->Width())),
+      .IrradianceMap =
+        IrradianceMap ? ReadCubemap(*IrradianceMap, 1) : ibl::CubemapImage{},
+      .PrefilterMap = ReadCubemap(*PrefilterMap, settings.PrefilterMipCount),
+      .BrdfLUT = ReadTexture(*BrdfLUTTexture),
+    };
+  }
+
+  void CreateSkybox()
+  {
     // skybox
     auto cube = grapho::mesh::Cube();
     auto vbo =
@@ -209,21 +610,27 @@ struct PbrEnv
     CubeDrawCount = cube->Vertices.Count;
     assert(!TryGetError());
 
-#include "shaders/background_fs.h"
-#include "shaders/background_vs.h"
-    BackgroundShader =
-      grapho::gl3::ShaderProgram::Create(BACKGROUND_VS, BACKGROUND_FS);
+    if (!BackgroundShader) {
+      CompilePrograms(false);
+    }
     if (!BackgroundShader) {
       throw std::runtime_error(GetErrorString());
     }
     BackgroundShader->Use();
     BackgroundShader->SetUniform("environmentMap", 0);
+    BackgroundProjection =
+      BackgroundShader->FindUniform(UniformName("projection"));
+    BackgroundView = BackgroundShader->FindUniform(UniformName("view"));
     assert(!TryGetError());
   }
 
   void Activate()
   {
-    IrradianceMap->Activate(0);
+    if (IrradianceSHUbo) {
+      IrradianceSHUbo->SetBindingPoint(2);
+    } else {
+      IrradianceMap->Activate(0);
+    }
     PrefilterMap->Activate(1);
     BrdfLUTTexture->Activate(2);
   }
@@ -247,8 +654,8 @@ struct PbrEnv
 
     // render skybox (render as last to prevent overdraw)
     BackgroundShader->Use();
-    BackgroundShader->SetUniform("projection", projection);
-    BackgroundShader->SetUniform("view", view);
+    BackgroundShader->SetUniform(BackgroundProjection, projection);
+    BackgroundShader->SetUniform(BackgroundView, view);
     // glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap); // display irradiance
     // map glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap); // display
     // prefilter map
@@ -280,5 +687,13 @@ CreatePbrShader(std::span<std::u8string_view> _vs = {},
   return grapho::gl3::ShaderProgram::Create(vs, fs);
 }
 
+inline std::shared_ptr<ShaderProgram>
+CreatePbrShader(PbrIrradiance irradiance)
+{
+  ShaderBatch batch;
+  AddPbrShader(batch, irradiance);
+  return batch.Resolve()[0];
+}
+
 }
 }
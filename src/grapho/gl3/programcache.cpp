@@ -0,0 +1,164 @@
+#include <GL/glew.h>
+
+#include "../fileutil.h"
+#include "../hash.h"
+#include "../mappedfile.h"
+#include "programcache.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+static uint64_t
+HashString(GLenum name, uint64_t hash)
+{
+  auto str = (const char*)glGetString(name);
+  return Fnv1a64(str ? str : "", hash);
+}
+
+ProgramCache::ProgramCache(const std::string& dir,
+                           uint64_t driver,
+                           std::vector<uint32_t> formats)
+  : m_dir(dir)
+  , m_driver(driver)
+  , m_formats(std::move(formats))
+{
+}
+
+std::shared_ptr<ProgramCache>
+ProgramCache::Create(const std::string& dir)
+{
+  if (!GLEW_ARB_get_program_binary) {
+    return nullptr;
+  }
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+  if (count == 0) {
+    // the driver can not give back a binary
+    return nullptr;
+  }
+  std::vector<GLint> formats(count);
+  glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+
+  auto driver = HashValue(PROGRAM_CACHE_VERSION);
+  driver = HashString(GL_VENDOR, driver);
+  driver = HashString(GL_RENDERER, driver);
+  driver = HashString(GL_VERSION, driver);
+  return std::make_shared<ProgramCache>(
+    dir, driver, std::vector<uint32_t>(formats.begin(), formats.end()));
+}
+
+std::shared_ptr<ProgramCache>&
+ProgramCache::Current()
+{
+  thread_local std::shared_ptr<ProgramCache> s_cache;
+  return s_cache;
+}
+
+uint64_t
+ProgramCache::Key(std::span<std::u8string_view> vs,
+                  std::span<std::u8string_view> fs,
+                  std::span<std::u8string_view> gs) const
+{
+  auto hash = m_driver;
+  for (auto stage : { vs, fs, gs }) {
+    // the stage boundary
+    hash = HashValue(stage.size(), hash);
+    for (auto src : stage) {
+      hash = HashBytes(src.data(), src.size(), hash);
+    }
+  }
+  return hash;
+}
+
+std::string
+ProgramCache::Path(uint64_t key) const
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx.program", (unsigned long long)key);
+  return grapho::join_path(m_dir, buf);
+}
+
+std::optional<uint32_t>
+ProgramCache::Load(uint64_t key)
+{
+  auto file = MappedFile::Open(Path(key));
+  if (!file || file->Size() < sizeof(ProgramCacheHeader)) {
+    ++Misses;
+    return std::nullopt;
+  }
+  auto header = (const ProgramCacheHeader*)file->Data();
+  if (header->Magic != PROGRAM_CACHE_MAGIC ||
+      header->Version != PROGRAM_CACHE_VERSION || header->Key != key ||
+      header->Size > file->Size() - sizeof(ProgramCacheHeader) ||
+      std::find(m_formats.begin(), m_formats.end(), header->BinaryFormat) ==
+        m_formats.end()) {
+    ++Misses;
+    return std::nullopt;
+  }
+
+  auto program = glCreateProgram();
+  glProgramBinary(program,
+                  header->BinaryFormat,
+                  file->Data() + sizeof(ProgramCacheHeader),
+                  static_cast<GLsizei>(header->Size));
+  GLint isLinked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+  if (isLinked == GL_FALSE) {
+    // a binary of an older driver. a link failure, no GL error
+    glDeleteProgram(program);
+    ++Misses;
+    return std::nullopt;
+  }
+  ++Hits;
+  return program;
+}
+
+bool
+ProgramCache::Store(uint64_t key, uint32_t program)
+{
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return false;
+  }
+  std::vector<uint8_t> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+  if (length <= 0) {
+    return false;
+  }
+
+  // write to a temporary and rename, so a reader never maps a partial file
+  auto path = Path(key);
+  auto tmp = path + ".tmp";
+  {
+    std::ofstream os(tmp, std::ios::binary);
+    if (!os) {
+      return false;
+    }
+    ProgramCacheHeader header{
+      .Magic = PROGRAM_CACHE_MAGIC,
+      .Version = PROGRAM_CACHE_VERSION,
+      .Key = key,
+      .BinaryFormat = format,
+      .Size = static_cast<uint64_t>(length),
+    };
+    os.write((const char*)&header, sizeof(header));
+    os.write((const char*)binary.data(), length);
+    if (!os) {
+      return false;
+    }
+  }
+  remove(path.c_str());
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace
+} // namespace
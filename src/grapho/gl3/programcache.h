@@ -0,0 +1,83 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+// file layout
+//
+// ProgramCacheHeader
+// binary. Size bytes as returned by glGetProgramBinary
+
+const uint32_t PROGRAM_CACHE_MAGIC = 0x42505247; // "GRPB"
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader
+{
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  // GLenum of the driver
+  uint32_t BinaryFormat;
+  uint32_t Reserved;
+  uint64_t Size;
+};
+static_assert(sizeof(ProgramCacheHeader) == 32);
+
+//
+// linked programs on disk, so a launch after the first skips compile and
+// link.
+//
+// the key is a hash of the sources of every stage and GL_VENDOR,
+// GL_RENDERER and GL_VERSION. a driver update misses and the program is
+// compiled and stored again. a binary the driver rejects anyway, e.g. after
+// a change not reflected in the version string, fails glProgramBinary and is
+// compiled the same way.
+//
+// ShaderProgram::Create goes through Current() when it is set.
+//
+//   ProgramCache::Current() = ProgramCache::Create("cache/programs");
+//   auto shader = ShaderProgram::Create(vs, fs); // loaded if cached
+//
+class ProgramCache
+{
+  std::string m_dir;
+  // hash of the driver strings
+  uint64_t m_driver;
+  // GL_PROGRAM_BINARY_FORMATS. a file of another format is not passed to
+  // glProgramBinary, that would raise GL_INVALID_ENUM for the caller
+  std::vector<uint32_t> m_formats;
+
+public:
+  uint32_t Hits = 0;
+  uint32_t Misses = 0;
+
+  ProgramCache(const std::string& dir,
+               uint64_t driver,
+               std::vector<uint32_t> formats);
+
+  // needs a current context. nullptr without ARB_get_program_binary
+  static std::shared_ptr<ProgramCache> Create(const std::string& dir);
+
+  // per thread like StateCache. nullptr to compile every time
+  static std::shared_ptr<ProgramCache>& Current();
+
+  uint64_t Key(std::span<std::u8string_view> vs,
+               std::span<std::u8string_view> fs,
+               std::span<std::u8string_view> gs = {}) const;
+  std::string Path(uint64_t key) const;
+
+  // a linked program, or nullopt if missing, broken or rejected
+  std::optional<uint32_t> Load(uint64_t key);
+  // program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+  bool Store(uint64_t key, uint32_t program);
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,240 @@
+#include <GL/glew.h>
+
+#include "ringbuffer.h"
+#include "statecache.h"
+
+namespace grapho {
+namespace gl3 {
+
+static uint32_t
+AlignUp(uint32_t value, uint32_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t
+UniformBufferOffsetAlignment()
+{
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  return alignment > 0 ? alignment : 256;
+}
+
+RingBuffer::RingBuffer(uint32_t buffer, uint32_t target, uint32_t size)
+  : buffer_(buffer)
+  , target_(target)
+  , size_(size)
+  , alignment_(target == GL_UNIFORM_BUFFER ? UniformBufferOffsetAlignment() : 4)
+{
+}
+
+RingBuffer::~RingBuffer()
+{
+  for (auto& fence : fences_) {
+    glDeleteSync(static_cast<GLsync>(fence.Sync));
+  }
+  if (mapped_) {
+    Bind();
+    glUnmapBuffer(target_);
+  }
+  glDeleteBuffers(1, &buffer_);
+  StateCache::Current().DeletedBuffer(buffer_);
+}
+
+std::shared_ptr<RingBuffer>
+RingBuffer::Create(uint32_t target, uint32_t size, bool persistent)
+{
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  auto ptr = std::shared_ptr<RingBuffer>(new RingBuffer(buffer, target, size));
+  ptr->Bind();
+  if (persistent && GLEW_ARB_buffer_storage) {
+    GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, size, nullptr, flags);
+    ptr->mapped_ =
+      static_cast<uint8_t*>(glMapBufferRange(target, 0, size, flags));
+    ptr->persistent_ = ptr->mapped_ != nullptr;
+  }
+  if (!ptr->persistent_) {
+    if (persistent && GLEW_ARB_buffer_storage) {
+      // immutable storage without a mapping. start over.
+      glDeleteBuffers(1, &ptr->buffer_);
+      StateCache::Current().DeletedBuffer(ptr->buffer_);
+      glGenBuffers(1, &ptr->buffer_);
+      ptr->Bind();
+    }
+    glBufferData(target, size, nullptr, GL_STREAM_DRAW);
+    ptr->shadow_.resize(size);
+  }
+  ptr->Unbind();
+  return ptr;
+}
+
+bool
+RingBuffer::WaitOldestFrame()
+{
+  if (fences_.empty()) {
+    return false;
+  }
+  auto fence = fences_.front();
+  fences_.pop_front();
+  auto sync = static_cast<GLsync>(fence.Sync);
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  for (;;) {
+    auto status = glClientWaitSync(sync, flags, 1000000000);
+    if (status != GL_TIMEOUT_EXPIRED) {
+      break;
+    }
+    flags = 0;
+  }
+  glDeleteSync(sync);
+  used_ -= fence.Bytes;
+  ++WaitCount;
+  return true;
+}
+
+void
+RingBuffer::ReleaseSignaledFrames()
+{
+  while (!fences_.empty()) {
+    auto fence = fences_.front();
+    auto sync = static_cast<GLsync>(fence.Sync);
+    auto status = glClientWaitSync(sync, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+      break;
+    }
+    glDeleteSync(sync);
+    used_ -= fence.Bytes;
+    fences_.pop_front();
+  }
+}
+
+void
+RingBuffer::Orphan()
+{
+  // the draws already issued keep the old storage. the previous frames are
+  // released and this frame is uploaded again on the next Flush.
+  Bind();
+  glBufferData(target_, size_, nullptr, GL_STREAM_DRAW);
+  used_ = frameBytes_;
+  flushed_ = frameBegin_;
+  unflushed_ = frameBytes_;
+  ++OrphanCount;
+}
+
+std::optional<RingBlock>
+RingBuffer::Allocate(uint32_t size, uint32_t alignment)
+{
+  if (size == 0 || size > size_) {
+    return std::nullopt;
+  }
+  if (alignment == 0) {
+    alignment = alignment_;
+  }
+  uint32_t offset;
+  uint32_t bytes;
+  auto place = [&]() {
+    if (used_ == 0) {
+      // nothing in flight. start from the top
+      head_ = frameBegin_ = flushed_ = 0;
+    }
+    offset = AlignUp(head_, alignment);
+    if (offset > size_ || size > size_ - offset) {
+      // skip the tail and wrap
+      offset = 0;
+    }
+    auto padding = offset >= head_ ? offset - head_ : size_ - head_;
+    bytes = padding + size;
+    return used_ + bytes <= size_;
+  };
+
+  if (!place()) {
+    if (persistent_) {
+      do {
+        if (!WaitOldestFrame()) {
+          // this frame alone
+          return std::nullopt;
+        }
+      } while (!place());
+    } else {
+      Orphan();
+      if (!place()) {
+        return std::nullopt;
+      }
+    }
+  }
+
+  head_ = offset + size;
+  used_ += bytes;
+  frameBytes_ += bytes;
+  unflushed_ += bytes;
+  auto base = persistent_ ? mapped_ : shadow_.data();
+  return RingBlock{ base + offset, offset, size };
+}
+
+void
+RingBuffer::Upload(uint32_t offset, uint32_t size)
+{
+  if (size) {
+    glBufferSubData(target_, offset, size, shadow_.data() + offset);
+  }
+}
+
+void
+RingBuffer::Flush()
+{
+  if (persistent_ || unflushed_ == 0) {
+    return;
+  }
+  // at most two ranges when wrapped
+  Bind();
+  if (flushed_ + unflushed_ <= size_) {
+    Upload(flushed_, unflushed_);
+  } else {
+    Upload(flushed_, size_ - flushed_);
+    Upload(0, flushed_ + unflushed_ - size_);
+  }
+  flushed_ = head_;
+  unflushed_ = 0;
+}
+
+void
+RingBuffer::EndFrame()
+{
+  Flush();
+  if (persistent_) {
+    ReleaseSignaledFrames();
+    if (frameBytes_) {
+      auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      fences_.push_back({ sync, frameBytes_ });
+    }
+  }
+  frameBegin_ = head_;
+  frameBytes_ = 0;
+}
+
+void
+RingBuffer::Bind()
+{
+  auto& state = StateCache::Current();
+  if (target_ == GL_ELEMENT_ARRAY_BUFFER) {
+    // not into the element buffer of a bound vao
+    state.BindVertexArray(0);
+  }
+  state.BindBuffer(target_, buffer_);
+}
+void
+RingBuffer::Unbind()
+{
+  StateCache::Current().BindBuffer(target_, 0);
+}
+void
+RingBuffer::BindRange(uint32_t bindingPoint, uint32_t offset, uint32_t size)
+{
+  StateCache::Current().BindBufferRange(
+    target_, bindingPoint, buffer_, offset, size);
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,125 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT. glBindBufferRange offsets for a uniform
+// buffer are multiples of this. 256 on most desktop drivers.
+uint32_t
+UniformBufferOffsetAlignment();
+
+//
+// per frame dynamic data in one large buffer.
+//
+// persistent: glBufferStorage and mapped once. writes go straight to the
+//             buffer. each EndFrame inserts a fence and a wrapped Allocate
+//             waits only for the frame that still uses the range.
+// fallback:   a cpu copy of the buffer. Flush uploads the written range with
+//             glBufferSubData, and a full ring orphans the storage instead of
+//             waiting.
+//
+//   auto block = ring->Allocate(sizeof(LocalVars));
+//   memcpy(block->Data, &vars, sizeof(vars));
+//   ...
+//   ring->Flush(); // before the draws that read it
+//   ring->BindRange(1, *block);
+//   ...
+//   ring->EndFrame();
+//
+struct RingBlock
+{
+  // write only
+  uint8_t* Data;
+  // for glBindBufferRange or a vertex attribute offset
+  uint32_t Offset;
+  uint32_t Size;
+};
+
+class RingBuffer
+{
+  struct FrameFence
+  {
+    // GLsync
+    void* Sync;
+    uint32_t Bytes;
+  };
+
+  uint32_t buffer_ = 0;
+  uint32_t target_ = 0;
+  uint32_t size_ = 0;
+  uint32_t alignment_ = 0;
+  bool persistent_ = false;
+  uint8_t* mapped_ = nullptr;
+  std::vector<uint8_t> shadow_;
+
+  uint32_t head_ = 0;
+  // allocated and not released yet, including the padding
+  uint32_t used_ = 0;
+  uint32_t frameBegin_ = 0;
+  uint32_t frameBytes_ = 0;
+  // fallback. [flushed_, head_) is not uploaded yet
+  uint32_t flushed_ = 0;
+  uint32_t unflushed_ = 0;
+  std::deque<FrameFence> fences_;
+
+  RingBuffer(uint32_t buffer, uint32_t target, uint32_t size);
+
+  bool WaitOldestFrame();
+  void ReleaseSignaledFrames();
+  void Orphan();
+  void Upload(uint32_t offset, uint32_t size);
+
+public:
+  uint32_t WaitCount = 0;
+  uint32_t OrphanCount = 0;
+
+  ~RingBuffer();
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  // target is GL_UNIFORM_BUFFER, GL_ARRAY_BUFFER...
+  // persistent mapping when requested and ARB_buffer_storage is available.
+  static std::shared_ptr<RingBuffer> Create(uint32_t target,
+                                            uint32_t size,
+                                            bool persistent = true);
+
+  uint32_t Handle() const { return buffer_; }
+  uint32_t Size() const { return size_; }
+  bool IsPersistent() const { return persistent_; }
+  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for a uniform buffer
+  uint32_t Alignment() const { return alignment_; }
+
+  // nullopt if size does not fit in the frames not yet fenced.
+  // alignment 0 uses Alignment().
+  std::optional<RingBlock> Allocate(uint32_t size, uint32_t alignment = 0);
+  template<typename T>
+  std::optional<RingBlock> Push(const T& value, uint32_t alignment = 0)
+  {
+    auto block = Allocate(sizeof(T), alignment);
+    if (block) {
+      *reinterpret_cast<T*>(block->Data) = value;
+    }
+    return block;
+  }
+
+  // no op for persistent
+  void Flush();
+  // fence the allocations since the last EndFrame
+  void EndFrame();
+
+  void Bind();
+  void Unbind();
+  void BindRange(uint32_t bindingPoint, uint32_t offset, uint32_t size);
+  void BindRange(uint32_t bindingPoint, const RingBlock& block)
+  {
+    BindRange(bindingPoint, block.Offset, block.Size);
+  }
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,93 @@
+#include <GL/glew.h>
+
+#include "sampler.h"
+#include "statecache.h"
+#include <algorithm>
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+uint64_t
+SamplerDesc::Key() const
+{
+  uint32_t anisotropy;
+  memcpy(&anisotropy, &Anisotropy, 4);
+  return (static_cast<uint64_t>(anisotropy) << 32) |
+         (static_cast<uint32_t>(Filter) << 8) | static_cast<uint32_t>(Wrap);
+}
+
+static GLint
+GLWrap(SamplerWrap wrap)
+{
+  switch (wrap) {
+    case SamplerWrap::Repeat:
+      return GL_REPEAT;
+    case SamplerWrap::Mirror:
+      return GL_MIRRORED_REPEAT;
+    default:
+      return GL_CLAMP_TO_EDGE;
+  }
+}
+
+Sampler::Sampler(const SamplerDesc& desc)
+{
+  glGenSamplers(1, &handle_);
+  switch (desc.Filter) {
+    case SamplerFilter::Point:
+      glSamplerParameteri(handle_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glSamplerParameteri(handle_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      break;
+    case SamplerFilter::Linear:
+      glSamplerParameteri(handle_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glSamplerParameteri(handle_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      break;
+    case SamplerFilter::Trilinear:
+      glSamplerParameteri(
+        handle_, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glSamplerParameteri(handle_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      break;
+  }
+  auto wrap = GLWrap(desc.Wrap);
+  glSamplerParameteri(handle_, GL_TEXTURE_WRAP_S, wrap);
+  glSamplerParameteri(handle_, GL_TEXTURE_WRAP_T, wrap);
+  glSamplerParameteri(handle_, GL_TEXTURE_WRAP_R, wrap);
+  if (desc.Anisotropy > 1 && GLEW_EXT_texture_filter_anisotropic) {
+    float limit = 1;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &limit);
+    glSamplerParameterf(handle_,
+                        GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                        std::min(desc.Anisotropy, limit));
+  }
+}
+
+Sampler::~Sampler()
+{
+  glDeleteSamplers(1, &handle_);
+  StateCache::Current().DeletedSampler(handle_);
+}
+
+void
+Sampler::Bind(uint32_t unit) const
+{
+  StateCache::Current().BindSampler(unit, handle_);
+}
+
+void
+Sampler::Unbind(uint32_t unit)
+{
+  StateCache::Current().BindSampler(unit, 0);
+}
+
+const std::shared_ptr<Sampler>&
+SamplerPool::Get(const SamplerDesc& desc)
+{
+  auto& sampler = samplers_[desc.Key()];
+  if (!sampler) {
+    sampler = Sampler::Create(desc);
+  }
+  return sampler;
+}
+
+} // namespace
+} // namespace
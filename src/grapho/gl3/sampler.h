@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace grapho {
+namespace gl3 {
+
+enum class SamplerFilter
+{
+  Point,
+  Linear,
+  // linear between linear mipmaps
+  Trilinear,
+};
+
+enum class SamplerWrap
+{
+  Clamp,
+  Repeat,
+  Mirror,
+};
+
+struct SamplerDesc
+{
+  SamplerFilter Filter = SamplerFilter::Linear;
+  SamplerWrap Wrap = SamplerWrap::Clamp;
+  // 1 is off. clamped to the limit of EXT_texture_filter_anisotropic
+  float Anisotropy = 1;
+
+  uint64_t Key() const;
+};
+
+//
+// the sampling state of a texture unit, apart from the textures.
+//
+// while bound to a unit it replaces the filter and wrap parameters of the
+// texture on that unit, so one texture can be sampled in several ways and a
+// filter change touches no texture.
+//
+class Sampler
+{
+  uint32_t handle_ = 0;
+
+public:
+  Sampler(const SamplerDesc& desc);
+  ~Sampler();
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  static std::shared_ptr<Sampler> Create(const SamplerDesc& desc)
+  {
+    return std::make_shared<Sampler>(desc);
+  }
+
+  uint32_t Handle() const { return handle_; }
+  void Bind(uint32_t unit) const;
+  // back to the texture parameters
+  static void Unbind(uint32_t unit);
+};
+
+//
+// a sampler per distinct SamplerDesc, shared by all the textures of a
+// context. a few exist at most, e.g. a trilinear repeat for the materials.
+//
+//   auto& sampler = pool->Get({ .Filter = SamplerFilter::Trilinear,
+//                               .Wrap = SamplerWrap::Repeat,
+//                               .Anisotropy = 8 });
+//   queue.AddMaterial({ { 3, GL_TEXTURE_2D, albedo, sampler->Handle() } });
+//
+class SamplerPool
+{
+  std::unordered_map<uint64_t, std::shared_ptr<Sampler>> samplers_;
+
+public:
+  static std::shared_ptr<SamplerPool> Create()
+  {
+    return std::make_shared<SamplerPool>();
+  }
+
+  const std::shared_ptr<Sampler>& Get(const SamplerDesc& desc);
+  uint32_t Size() const { return samplers_.size(); }
+};
+
+} // namespace
+} // namespace
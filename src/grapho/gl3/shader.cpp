@@ -1,9 +1,10 @@
 #include "shader.h"
+#include "error_check.h"
 
 namespace grapho::gl3 {
 
-std::optional<GLuint>
-compile(GLenum shaderType, std::span<std::u8string_view> srcs)
+GLuint
+submitCompile(GLenum shaderType, std::span<std::u8string_view> srcs)
 {
   auto shader = glCreateShader(shaderType);
 
@@ -15,6 +16,12 @@ compile(GLenum shaderType, std::span<std::u8string_view> srcs)
   }
   glShaderSource(shader, srcs.size(), string.data(), length.data());
   glCompileShader(shader);
+  return shader;
+}
+
+std::optional<GLuint>
+compileStatus(GLuint shader)
+{
   GLint isCompiled = 0;
   glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
   if (isCompiled == GL_FALSE) {
@@ -28,17 +35,25 @@ compile(GLenum shaderType, std::span<std::u8string_view> srcs)
 
     glDeleteShader(shader); // Don't leak the shader.
 
-    // Provide the infolog in whatever manor you deem best.
-    // return std::unexpected{ errorLog };
+    SetErrorMessage(errorLog.c_str());
     return {};
   }
   return shader;
 }
 
 std::optional<GLuint>
-link(GLuint vs, GLuint fs, GLuint gs)
+compile(GLenum shaderType, std::span<std::u8string_view> srcs)
+{
+  return compileStatus(submitCompile(shaderType, srcs));
+}
+
+GLuint
+submitLink(GLuint vs, GLuint fs, GLuint gs, bool retrievable)
 {
   GLuint program = glCreateProgram();
+  if (retrievable) {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
 
   // Attach shaders as necessary.
   glAttachShader(program, vs);
@@ -49,7 +64,12 @@ link(GLuint vs, GLuint fs, GLuint gs)
 
   // Link the program.
   glLinkProgram(program);
+  return program;
+}
 
+std::optional<GLuint>
+linkStatus(GLuint program)
+{
   GLint isLinked = 0;
   glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
   if (isLinked == GL_FALSE) {
@@ -64,11 +84,27 @@ link(GLuint vs, GLuint fs, GLuint gs)
     // The program is useless now. So delete it.
     glDeleteProgram(program);
 
-    // Provide the infolog in whatever manner you deem best.
-    // return std::unexpected{ infoLog };
+    SetErrorMessage(infoLog.c_str());
     return {};
   }
   return program;
 }
 
+std::optional<GLuint>
+link(GLuint vs, GLuint fs, GLuint gs, bool retrievable)
+{
+  return linkStatus(submitLink(vs, fs, gs, retrievable));
+}
+
+bool
+isLinkCompleted(GLuint program)
+{
+  if (!GLEW_KHR_parallel_shader_compile) {
+    return true;
+  }
+  GLint completed = GL_TRUE;
+  glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+  return completed == GL_TRUE;
+}
+
 } // namespace
@@ -2,6 +2,9 @@
 #include <GL/glew.h>
 
 #include "../fileutil.h"
+#include "../hash.h"
+#include "programcache.h"
+#include "statecache.h"
 #include <fstream>
 #include <memory>
 #include <optional>
@@ -10,14 +13,36 @@
 #include <stdint.h>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
 namespace grapho::gl3 {
 
 std::optional<GLuint>
 compile(GLenum shaderType, std::span<std::u8string_view> srcs);
 
+// retrievable for a ProgramCache::Store
 std::optional<GLuint>
-link(GLuint vs, GLuint fs, GLuint gs = 0);
+link(GLuint vs, GLuint fs, GLuint gs = 0, bool retrievable = false);
+
+// compile and link in two halves. the submit returns without waiting for
+// the driver, the status waits. see ShaderBatch
+GLuint
+submitCompile(GLenum shaderType, std::span<std::u8string_view> srcs);
+
+// the info log with SetErrorMessage and the shader deleted on a failure
+std::optional<GLuint>
+compileStatus(GLuint shader);
+
+GLuint
+submitLink(GLuint vs, GLuint fs, GLuint gs = 0, bool retrievable = false);
+
+// the info log with SetErrorMessage and the program deleted on a failure
+std::optional<GLuint>
+linkStatus(GLuint program);
+
+// linkStatus would not wait. true without KHR_parallel_shader_compile
+bool
+isLinkCompleted(GLuint program);
 
 template<typename T>
 concept Float3 = sizeof(T) == sizeof(float) * 3;
@@ -68,6 +93,25 @@ struct UniformVariable
   }
 };
 
+// Fnv1a64 of a uniform name. a literal is hashed at compile time
+struct UniformName
+{
+  uint64_t Hash;
+
+  constexpr UniformName(std::string_view name)
+    : Hash(Fnv1a64(name))
+  {
+  }
+};
+
+// a uniform of one program. an index in ShaderProgram::Uniforms
+struct UniformHandle
+{
+  uint32_t Index = UINT32_MAX;
+
+  explicit operator bool() const { return Index != UINT32_MAX; }
+};
+
 inline void
 DebugWrite(const std::string& path, std::span<std::u8string_view> srcs)
 {
@@ -83,7 +127,11 @@ DebugWrite(const std::string& path, std::span<std::u8string_view> srcs)
 
 class ShaderProgram
 {
+  friend class ShaderBatch;
+
   uint32_t program_ = 0;
+  // name hash to an index in Uniforms. block members have no location
+  std::unordered_map<uint64_t, uint32_t> uniformIndices_;
 
   ShaderProgram(uint32_t program)
     : program_(program)
@@ -115,6 +163,15 @@ class ShaderProgram
         .Name = name,
         .Type = type,
       });
+      if (location >= 0) {
+        // an array is "name[0]". found by "name" as well
+        std::string_view key(name, length);
+        uniformIndices_[Fnv1a64(key)] = i;
+        if (key.ends_with("[0]")) {
+          key.remove_suffix(3);
+          uniformIndices_[Fnv1a64(key)] = i;
+        }
+      }
       //
       // if (location == -1) {
       // // UBO
@@ -130,11 +187,21 @@ class ShaderProgram
 public:
   std::vector<UniformVariable> Uniforms;
   ~ShaderProgram() { glDeleteProgram(program_); }
+  // through ProgramCache::Current() if set
   static std::shared_ptr<ShaderProgram> Create(
     std::span<std::u8string_view> vs_srcs,
     std::span<std::u8string_view> fs_srcs,
     std::span<std::u8string_view> gs_srcs = {})
   {
+    auto& cache = ProgramCache::Current();
+    uint64_t key = 0;
+    if (cache) {
+      key = cache->Key(vs_srcs, fs_srcs, gs_srcs);
+      if (auto program = cache->Load(key)) {
+        return std::shared_ptr<ShaderProgram>(new ShaderProgram(*program));
+      }
+    }
+
     auto vs = compile(GL_VERTEX_SHADER, vs_srcs);
     if (!vs) {
       DebugWrite("debug.vert", vs_srcs);
@@ -159,11 +226,14 @@ public:
       gs = *_gs;
     }
 
-    auto program = link(*vs, *fs, gs);
+    auto program = link(*vs, *fs, gs, cache != nullptr);
     if (!program) {
       // return std::unexpected{ program.error() };
       return {};
     }
+    if (cache) {
+      cache->Store(key, *program);
+    }
 
     return std::shared_ptr<ShaderProgram>(new ShaderProgram(*program));
   }
@@ -214,8 +284,9 @@ public:
     }
   }
 
-  void Use() { glUseProgram(program_); }
-  void UnUse() { glUseProgram(0); }
+  uint32_t Handle() const { return program_; }
+  void Use() { StateCache::Current().UseProgram(program_); }
+  void UnUse() { StateCache::Current().UseProgram(0); }
 
   std::optional<uint32_t> Attribute(const char* name) const
   {
@@ -226,8 +297,42 @@ public:
     return static_cast<uint32_t>(location);
   }
 
+  // resolve once, then set with no string work or gl query
+  //
+  //   constexpr UniformName VIEW("view");
+  //   auto view = shader->FindUniform(VIEW);
+  //   shader->SetUniform(view, matrix);
+  //
+  UniformHandle FindUniform(UniformName name) const
+  {
+    auto found = uniformIndices_.find(name.Hash);
+    if (found == uniformIndices_.end()) {
+      return {};
+    }
+    return { found->second };
+  }
+
+  template<typename T>
+  void SetUniform(UniformHandle handle, const T& value) const
+  {
+    if (handle) {
+      Uniforms[handle.Index].Set(value);
+    }
+  }
+
+  // a table lookup. no gl query
+  template<typename T>
+  void SetUniform(UniformName name, const T& value) const
+  {
+    SetUniform(FindUniform(name), value);
+  }
+
   std::optional<UniformVariable> Uniform(const std::string& name) const
   {
+    if (auto handle = FindUniform(UniformName(name))) {
+      return UniformVariable{ Uniforms[handle.Index].Location };
+    }
+    // not enumerated, e.g. an element "lights[1]"
     auto location = glGetUniformLocation(program_, name.c_str());
     if (location < 0) {
       return std::nullopt;
@@ -260,7 +365,7 @@ public:
   std::optional<uint32_t> UboBlockIndex(const char* name)
   {
     auto blockIndex = glGetUniformBlockIndex(program_, name);
-    if (blockIndex < 0) {
+    if (blockIndex == GL_INVALID_INDEX) {
       return std::nullopt;
     }
     return blockIndex;
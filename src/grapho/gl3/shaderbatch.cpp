@@ -0,0 +1,141 @@
+#include <GL/glew.h>
+
+#include "error_check.h"
+#include "shaderbatch.h"
+
+namespace grapho {
+namespace gl3 {
+
+// by the index of Pending::Shaders
+static const char* STAGE_NAMES[] = { "vs", "fs", "gs" };
+static const char* DEBUG_PATHS[] = { "debug.vert", "debug.frag", "debug.geom" };
+
+static std::u8string
+Join(std::span<std::u8string_view> srcs)
+{
+  std::u8string joined;
+  for (auto src : srcs) {
+    joined += src;
+  }
+  return joined;
+}
+
+ShaderBatch::ShaderBatch()
+{
+  if (GLEW_KHR_parallel_shader_compile) {
+    // as many threads as the driver likes
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  }
+}
+
+ShaderBatch::~ShaderBatch()
+{
+  // not resolved
+  for (auto& pending : m_pending) {
+    for (auto shader : pending.Shaders) {
+      if (shader) {
+        glDeleteShader(shader);
+      }
+    }
+    if (pending.Program) {
+      glDeleteProgram(pending.Program);
+    }
+  }
+}
+
+uint32_t
+ShaderBatch::Add(std::span<std::u8string_view> vs,
+                 std::span<std::u8string_view> fs,
+                 std::span<std::u8string_view> gs)
+{
+  auto index = static_cast<uint32_t>(m_pending.size());
+  auto& pending = m_pending.emplace_back();
+
+  auto& cache = ProgramCache::Current();
+  if (cache) {
+    pending.Key = cache->Key(vs, fs, gs);
+    if (auto program = cache->Load(pending.Key)) {
+      pending.Loaded =
+        std::shared_ptr<ShaderProgram>(new ShaderProgram(*program));
+      pending.Key = 0;
+      return index;
+    }
+  }
+
+  // no status query until Resolve
+  pending.Shaders[0] = submitCompile(GL_VERTEX_SHADER, vs);
+  pending.Shaders[1] = submitCompile(GL_FRAGMENT_SHADER, fs);
+  if (!gs.empty()) {
+    pending.Shaders[2] = submitCompile(GL_GEOMETRY_SHADER, gs);
+  }
+  pending.Sources[0] = Join(vs);
+  pending.Sources[1] = Join(fs);
+  pending.Sources[2] = Join(gs);
+  pending.Program = submitLink(pending.Shaders[0],
+                               pending.Shaders[1],
+                               pending.Shaders[2],
+                               cache != nullptr);
+  return index;
+}
+
+bool
+ShaderBatch::IsCompleted() const
+{
+  for (auto& pending : m_pending) {
+    if (pending.Program && !isLinkCompleted(pending.Program)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<std::shared_ptr<ShaderProgram>>
+ShaderBatch::Resolve()
+{
+  auto& cache = ProgramCache::Current();
+  std::vector<std::shared_ptr<ShaderProgram>> programs;
+  programs.reserve(m_pending.size());
+  for (auto& pending : m_pending) {
+    if (pending.Loaded) {
+      programs.push_back(pending.Loaded);
+      continue;
+    }
+
+    // a failed compile fails the link
+    auto program = linkStatus(pending.Program);
+    if (!program) {
+      auto linkLog = GetErrorString();
+      std::string error;
+      for (int i = 0; i < 3; ++i) {
+        if (pending.Shaders[i] && !compileStatus(pending.Shaders[i])) {
+          // deleted by compileStatus
+          pending.Shaders[i] = 0;
+          error += std::string(STAGE_NAMES[i]) + ": " + GetErrorString() + "\n";
+          std::u8string_view src = pending.Sources[i];
+          DebugWrite(DEBUG_PATHS[i], { &src, 1 });
+        }
+      }
+      SetErrorMessage(error + "link: " + linkLog);
+    }
+    for (auto shader : pending.Shaders) {
+      if (shader) {
+        // released with the program
+        glDeleteShader(shader);
+      }
+    }
+    if (!program) {
+      programs.push_back(nullptr);
+      continue;
+    }
+    if (cache && pending.Key) {
+      cache->Store(pending.Key, *program);
+    }
+    programs.push_back(
+      std::shared_ptr<ShaderProgram>(new ShaderProgram(*program)));
+  }
+  m_pending.clear();
+  return programs;
+}
+
+} // namespace
+} // namespace
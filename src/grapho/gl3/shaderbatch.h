@@ -0,0 +1,84 @@
+#pragma once
+#include "shader.h"
+#include <memory>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+//
+// compiles and links several programs at once.
+//
+// ShaderProgram::Create waits for the status of each shader before the next
+// is submitted, so the driver works on one at a time. Add submits the
+// compiles and the link and returns. with KHR_parallel_shader_compile the
+// driver runs them on its own threads, otherwise it can at least defer the
+// work to the first status query. Resolve does all of the status queries,
+// in the order of Add.
+//
+// goes through ProgramCache::Current() like ShaderProgram::Create. a cached
+// program is loaded in Add.
+//
+//   ShaderBatch batch;
+//   auto pbr = batch.Add(PBR_VS, PBR_FS);
+//   auto background = batch.Add(BACKGROUND_VS, BACKGROUND_FS);
+//   // other work while the driver compiles
+//   auto programs = batch.Resolve();
+//   programs[pbr]->Use();
+//
+class ShaderBatch
+{
+  struct Pending
+  {
+    uint32_t Program = 0;
+    uint32_t Shaders[3] = {};
+    // for DebugWrite on a failure. the sources of Add may be released
+    std::u8string Sources[3];
+    // ProgramCache key of a program to store. 0 if not
+    uint64_t Key = 0;
+    // from the ProgramCache
+    std::shared_ptr<ShaderProgram> Loaded;
+  };
+  std::vector<Pending> m_pending;
+
+public:
+  ShaderBatch();
+  ~ShaderBatch();
+  ShaderBatch(const ShaderBatch&) = delete;
+  ShaderBatch& operator=(const ShaderBatch&) = delete;
+
+  // an index in the Resolve result. the sources may be released on return
+  uint32_t Add(std::span<std::u8string_view> vs,
+               std::span<std::u8string_view> fs,
+               std::span<std::u8string_view> gs = {});
+
+  uint32_t Add(std::u8string_view vs,
+               std::u8string_view fs,
+               std::u8string_view gs = {})
+  {
+    std::u8string_view vss[] = { vs };
+    std::u8string_view fss[] = { fs };
+    if (gs.empty()) {
+      return Add(vss, fss);
+    } else {
+      std::u8string_view gss[] = { gs };
+      return Add(vss, fss, gss);
+    }
+  }
+
+  uint32_t Size() const { return m_pending.size(); }
+
+  // Resolve would not wait. polls GL_COMPLETION_STATUS_KHR. always true
+  // without the extension, there is no way to ask
+  bool IsCompleted() const;
+
+  // nullptr for a program that failed to compile or link, with the compile
+  // and link logs in SetErrorMessage of the last failure and the sources of
+  // a failed stage written as ShaderProgram::Create does. empties the batch
+  std::vector<std::shared_ptr<ShaderProgram>> Resolve();
+};
+
+} // namespace
+} // namespace
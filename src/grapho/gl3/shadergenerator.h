@@ -5,72 +5,139 @@
 namespace grapho {
 namespace gl3 {
 
+// all of required in features
+inline bool
+IsEnabled(uint32_t required, uint32_t features)
+{
+  return (required & features) == required;
+}
+
+/// #version 330 core
+/// #define NAME
+inline void
+GenerateHeader(std::ostream& os,
+               const ShaderSnippet& shader,
+               uint32_t features,
+               std::string_view version)
+{
+  os << version << std::endl;
+  for (size_t i = 0; i < shader.Features.size(); ++i) {
+    if (features & (1u << i)) {
+      os << "#define " << shader.Features[i] << std::endl;
+    }
+  }
+  os << std::endl;
+}
+
 /// layout (location=0) in vec3 pos;
 /// out VS_OUT{
 /// } vs_out;
 /// uniform mat4 view;
 inline std::string
 GenerateVS(const ShaderSnippet& shader,
+           uint32_t features,
            std::string_view version = "#version 330 core")
 {
   std::stringstream ss;
-  ss << version << std::endl << std::endl;
+  GenerateHeader(ss, shader, features, version);
 
+  // a disabled input keeps its location. the same vertex layout for all
+  // variants
   int i = 0;
   for (auto& var : shader.Inputs) {
-    ss << "layout (location = " << (i++) << ") in " << var << ";" << std::endl;
+    auto location = i++;
+    if (IsEnabled(var.Features, features)) {
+      ss << "layout (location = " << location << ") in " << var << ";"
+         << std::endl;
+    }
   }
   ss << std::endl;
 
   ss << "out VS_OUT {" << std::endl;
   for (auto& var : shader.Outputs) {
-    ss << "    " << var << ";" << std::endl;
+    if (IsEnabled(var.Features, features)) {
+      ss << "    " << var << ";" << std::endl;
+    }
   }
   ss << "} vs_out;" << std::endl << std::endl;
 
   for (auto& var : shader.Uniforms) {
-    ss << "uniform " << var << ";" << std::endl;
+    if (IsEnabled(var.Features, features)) {
+      ss << "uniform " << var << ";" << std::endl;
+    }
   }
   ss << std::endl;
 
   for (auto& code : shader.Codes) {
-    ss << code << std::endl << std::endl;
+    if (IsEnabled(code.Features, features)) {
+      ss << code << std::endl << std::endl;
+    }
   }
   return ss.str();
 }
 
+inline std::string
+GenerateVS(const ShaderSnippet& shader,
+           std::string_view version = "#version 330 core")
+{
+  return GenerateVS(shader, 0, version);
+}
+
 /// out vec4 FragColor;
 /// in VS_OUT {
 /// } fs_in;
 /// uniform vec4 color;
 inline std::string
 GenerateFS(const ShaderSnippet& shader,
+           uint32_t features,
            std::string_view version = "#version 330 core")
 {
   std::stringstream ss;
-  ss << version << std::endl << std::endl;
+  GenerateHeader(ss, shader, features, version);
 
   for (auto& var : shader.Outputs) {
-    ss << "out " << var << ";" << std::endl;
+    if (IsEnabled(var.Features, features)) {
+      ss << "out " << var << ";" << std::endl;
+    }
   }
 
   ss << "in VS_OUT {" << std::endl;
   for (auto& var : shader.Inputs) {
-    ss << "    " << var << ";" << std::endl;
+    if (IsEnabled(var.Features, features)) {
+      ss << "    " << var << ";" << std::endl;
+    }
   }
   ss << "} fs_in;" << std::endl << std::endl;
 
   for (auto& var : shader.Uniforms) {
-    ss << "uniform " << var << ";" << std::endl;
+    if (IsEnabled(var.Features, features)) {
+      ss << "uniform " << var << ";" << std::endl;
+    }
   }
   ss << std::endl;
 
   for (auto& code : shader.Codes) {
-    ss << code << std::endl << std::endl;
+    if (IsEnabled(code.Features, features)) {
+      ss << code << std::endl << std::endl;
+    }
   }
   return ss.str();
 }
 
+inline std::string
+GenerateFS(const ShaderSnippet& shader,
+           std::string_view version = "#version 330 core")
+{
+  return GenerateFS(shader, 0, version);
+}
+
+inline std::string
+GenerateVS(const VertexAndFragment& vsfs,
+           uint32_t features,
+           std::string_view version = "#version 330 core")
+{
+  return GenerateVS(vsfs.VS, features, version);
+}
 inline std::string
 GenerateVS(const VertexAndFragment& vsfs,
            std::string_view version = "#version 330 core")
@@ -78,6 +145,13 @@ GenerateVS(const VertexAndFragment& vsfs,
   return GenerateVS(vsfs.VS, version);
 }
 inline std::string
+GenerateFS(const VertexAndFragment& vsfs,
+           uint32_t features,
+           std::string_view version = "#version 330 core")
+{
+  return GenerateFS(vsfs.FS, features, version);
+}
+inline std::string
 GenerateFS(const VertexAndFragment& vsfs,
            std::string_view version = "#version 330 core")
 {
@@ -0,0 +1,11 @@
+auto OCTAHEDRAL_GLSL=u8R"(
+// normal from mesh::Quantize. snorm16 x 2 read as vec2 in [-1, 1]
+vec3
+octDecode(vec2 e)
+{
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+  return normalize(n);
+}
+)";
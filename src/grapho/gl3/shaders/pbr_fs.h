@@ -5,7 +5,16 @@ layout(location = 2) in vec3 WorldPos;
 layout(location = 0) out vec4 FragColor;
 
 // IBL 0-2
+#ifdef SH_IRRADIANCE
+// L2 spherical harmonics. see grapho::ibl::SH9
+layout(binding = 2, std140) uniform SHVars
+{
+  vec4 coefficients[9];
+}
+SH;
+#else
 layout(binding = 0) uniform samplerCube irradianceMap;
+#endif
 layout(binding = 1) uniform samplerCube prefilterMap;
 layout(binding = 2) uniform sampler2D brdfLUT;
 
@@ -36,6 +45,22 @@ layout(binding = 1, std140) uniform ModelVars
 Model;
 
 const float PI = 3.14159265359;
+
+vec3
+getIrradiance(vec3 n)
+{
+#ifdef SH_IRRADIANCE
+  return SH.coefficients[0].rgb + SH.coefficients[1].rgb * n.y +
+         SH.coefficients[2].rgb * n.z + SH.coefficients[3].rgb * n.x +
+         SH.coefficients[4].rgb * (n.x * n.y) +
+         SH.coefficients[5].rgb * (n.y * n.z) +
+         SH.coefficients[6].rgb * (3.0 * n.z * n.z - 1.0) +
+         SH.coefficients[7].rgb * (n.x * n.z) +
+         SH.coefficients[8].rgb * (n.x * n.x - n.y * n.y);
+#else
+  return texture(irradianceMap, n).rgb;
+#endif
+}
 // ----------------------------------------------------------------------------
 // Easy trick to get tangent-normals to world-space to keep PBR code simplified.
 // Don't worry if you don't get what's going on; you generally want to do normal
@@ -177,7 +202,7 @@ main()
   vec3 kD = 1.0 - kS;
   kD *= 1.0 - metallic;
 
-  vec3 irradiance = texture(irradianceMap, N).rgb;
+  vec3 irradiance = getIrradiance(N);
   vec3 diffuse = irradiance * albedo;
 
   // sample both the pre-filter map and the BRDF lut and combine them together
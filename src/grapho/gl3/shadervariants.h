@@ -0,0 +1,105 @@
+#pragma once
+#include "../shadersnippet.h"
+#include "shaderbatch.h"
+#include "shadergenerator.h"
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+//
+// the programs of the variants of a VertexAndFragment, keyed by the
+// Feature bits. a variant is generated and compiled on the first Get, a
+// material picks the specialized program instead of branching at runtime.
+//
+//   VertexAndFragment snippet;
+//   auto NORMAL_MAP = snippet.Feature("NORMAL_MAP");
+//   ...
+//   auto variants = ShaderVariants::Create(snippet);
+//   auto shader = variants->Get(hasNormalMap ? NORMAL_MAP : 0);
+//
+// goes through ProgramCache::Current() like ShaderProgram::Create.
+//
+class ShaderVariants
+{
+  VertexAndFragment m_snippet;
+  std::string m_version;
+  // nullptr for a variant that failed. not retried
+  std::unordered_map<uint32_t, std::shared_ptr<ShaderProgram>> m_programs;
+
+  ShaderVariants(const VertexAndFragment& snippet, std::string_view version)
+    : m_snippet(snippet)
+    , m_version(version)
+  {
+  }
+
+public:
+  static std::shared_ptr<ShaderVariants> Create(
+    const VertexAndFragment& snippet,
+    std::string_view version = "#version 330 core")
+  {
+    return std::shared_ptr<ShaderVariants>(
+      new ShaderVariants(snippet, version));
+  }
+
+  const VertexAndFragment& Snippet() const { return m_snippet; }
+
+  // compiled variants
+  uint32_t Size() const { return m_programs.size(); }
+
+  // bits of undefined features are ignored
+  uint32_t Key(uint32_t features) const
+  {
+    return features & m_snippet.FeatureMask();
+  }
+
+  std::shared_ptr<ShaderProgram> Get(uint32_t features)
+  {
+    auto key = Key(features);
+    auto found = m_programs.find(key);
+    if (found != m_programs.end()) {
+      return found->second;
+    }
+    auto vs = GenerateVS(m_snippet, key, m_version);
+    auto fs = GenerateFS(m_snippet, key, m_version);
+    auto program = ShaderProgram::Create(vs, fs);
+    m_programs.insert({ key, program });
+    return program;
+  }
+
+  // compiles the variants not yet in one ShaderBatch, e.g. at load. Get
+  // afterwards does not compile
+  void Prepare(std::span<const uint32_t> features)
+  {
+    ShaderBatch batch;
+    std::vector<uint32_t> keys;
+    for (auto f : features) {
+      auto key = Key(f);
+      if (m_programs.contains(key) ||
+          std::find(keys.begin(), keys.end(), key) != keys.end()) {
+        continue;
+      }
+      auto vs = GenerateVS(m_snippet, key, m_version);
+      auto fs = GenerateFS(m_snippet, key, m_version);
+      batch.Add(std::u8string_view((const char8_t*)vs.data(), vs.size()),
+                std::u8string_view((const char8_t*)fs.data(), fs.size()));
+      keys.push_back(key);
+    }
+    if (keys.empty()) {
+      return;
+    }
+    auto programs = batch.Resolve();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      m_programs.insert({ keys[i], programs[i] });
+    }
+  }
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,301 @@
+#include <GL/glew.h>
+
+#include "statecache.h"
+
+namespace grapho {
+namespace gl3 {
+
+static int
+BufferTargetIndex(uint32_t target)
+{
+  switch (target) {
+    case GL_ARRAY_BUFFER:
+      return 0;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      return 1;
+    case GL_UNIFORM_BUFFER:
+      return 2;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return 3;
+    case GL_PIXEL_PACK_BUFFER:
+      return 4;
+    case GL_COPY_READ_BUFFER:
+      return 5;
+    case GL_COPY_WRITE_BUFFER:
+      return 6;
+    case GL_DRAW_INDIRECT_BUFFER:
+      return 7;
+    default:
+      return -1;
+  }
+}
+
+static int
+TextureTargetIndex(uint32_t target)
+{
+  switch (target) {
+    case GL_TEXTURE_2D:
+      return 0;
+    case GL_TEXTURE_CUBE_MAP:
+      return 1;
+    default:
+      return -1;
+  }
+}
+
+StateCache::StateCache()
+{
+  Invalidate();
+}
+
+StateCache&
+StateCache::Current()
+{
+  thread_local StateCache s_cache;
+  return s_cache;
+}
+
+void
+StateCache::Invalidate()
+{
+  program_ = UNKNOWN;
+  vertexArray_ = UNKNOWN;
+  for (auto& buffer : buffers_) {
+    buffer = UNKNOWN;
+  }
+  for (auto& binding : uniformBindings_) {
+    binding = { UNKNOWN, 0, 0 };
+  }
+  activeUnit_ = UNKNOWN;
+  for (auto& unit : textures_) {
+    for (auto& texture : unit) {
+      texture = UNKNOWN;
+    }
+  }
+  for (auto& sampler : samplers_) {
+    sampler = UNKNOWN;
+  }
+  drawFramebuffer_ = UNKNOWN;
+  readFramebuffer_ = UNKNOWN;
+}
+
+void
+StateCache::UseProgram(uint32_t program)
+{
+  ++Counters.Program.Calls;
+  if (program_ == program) {
+    ++Counters.Program.Filtered;
+    return;
+  }
+  glUseProgram(program);
+  program_ = program;
+}
+
+void
+StateCache::BindVertexArray(uint32_t vertexArray)
+{
+  ++Counters.VertexArray.Calls;
+  if (vertexArray_ == vertexArray) {
+    ++Counters.VertexArray.Filtered;
+    return;
+  }
+  glBindVertexArray(vertexArray);
+  vertexArray_ = vertexArray;
+  buffers_[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void
+StateCache::BindBuffer(uint32_t target, uint32_t buffer)
+{
+  ++Counters.Buffer.Calls;
+  auto index = BufferTargetIndex(target);
+  if (index < 0) {
+    glBindBuffer(target, buffer);
+    return;
+  }
+  if (buffers_[index] == buffer) {
+    ++Counters.Buffer.Filtered;
+    return;
+  }
+  glBindBuffer(target, buffer);
+  buffers_[index] = buffer;
+}
+
+void
+StateCache::BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer)
+{
+  // the whole buffer. size 0 never matches a range
+  ++Counters.IndexedBuffer.Calls;
+  if (target == GL_UNIFORM_BUFFER && index < UNIFORM_BINDINGS) {
+    auto& binding = uniformBindings_[index];
+    if (binding.Buffer == buffer && binding.Offset == 0 && binding.Size == 0) {
+      ++Counters.IndexedBuffer.Filtered;
+      return;
+    }
+    binding = { buffer, 0, 0 };
+  }
+  glBindBufferBase(target, index, buffer);
+  // also binds the generic target
+  auto targetIndex = BufferTargetIndex(target);
+  if (targetIndex >= 0) {
+    buffers_[targetIndex] = buffer;
+  }
+}
+
+void
+StateCache::BindBufferRange(uint32_t target,
+                            uint32_t index,
+                            uint32_t buffer,
+                            uint32_t offset,
+                            uint32_t size)
+{
+  ++Counters.IndexedBuffer.Calls;
+  if (target == GL_UNIFORM_BUFFER && index < UNIFORM_BINDINGS) {
+    auto& binding = uniformBindings_[index];
+    if (binding.Buffer == buffer && binding.Offset == offset &&
+        binding.Size == size) {
+      ++Counters.IndexedBuffer.Filtered;
+      return;
+    }
+    binding = { buffer, offset, size };
+  }
+  glBindBufferRange(target, index, buffer, offset, size);
+  auto targetIndex = BufferTargetIndex(target);
+  if (targetIndex >= 0) {
+    buffers_[targetIndex] = buffer;
+  }
+}
+
+void
+StateCache::ActiveTexture(uint32_t unit)
+{
+  if (activeUnit_ == unit) {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  activeUnit_ = unit;
+}
+
+void
+StateCache::BindTexture(uint32_t target, uint32_t texture)
+{
+  if (activeUnit_ == UNKNOWN) {
+    ActiveTexture(0);
+  }
+  BindTexture(activeUnit_, target, texture);
+}
+
+void
+StateCache::BindTexture(uint32_t unit, uint32_t target, uint32_t texture)
+{
+  ++Counters.Texture.Calls;
+  auto index = TextureTargetIndex(target);
+  if (index < 0 || unit >= TEXTURE_UNITS) {
+    ActiveTexture(unit);
+    glBindTexture(target, texture);
+    return;
+  }
+  if (textures_[unit][index] == texture) {
+    ++Counters.Texture.Filtered;
+    return;
+  }
+  ActiveTexture(unit);
+  glBindTexture(target, texture);
+  textures_[unit][index] = texture;
+}
+
+void
+StateCache::BindSampler(uint32_t unit, uint32_t sampler)
+{
+  ++Counters.Sampler.Calls;
+  if (unit < TEXTURE_UNITS) {
+    if (samplers_[unit] == sampler) {
+      ++Counters.Sampler.Filtered;
+      return;
+    }
+    samplers_[unit] = sampler;
+  }
+  // no active unit
+  glBindSampler(unit, sampler);
+}
+
+void
+StateCache::BindFramebuffer(uint32_t target, uint32_t framebuffer)
+{
+  ++Counters.Framebuffer.Calls;
+  bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+  bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+  if ((!draw || drawFramebuffer_ == framebuffer) &&
+      (!read || readFramebuffer_ == framebuffer)) {
+    ++Counters.Framebuffer.Filtered;
+    return;
+  }
+  glBindFramebuffer(target, framebuffer);
+  if (draw) {
+    drawFramebuffer_ = framebuffer;
+  }
+  if (read) {
+    readFramebuffer_ = framebuffer;
+  }
+}
+
+void
+StateCache::DeletedVertexArray(uint32_t vertexArray)
+{
+  if (vertexArray_ == vertexArray) {
+    vertexArray_ = 0;
+    buffers_[BufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+  }
+}
+
+void
+StateCache::DeletedBuffer(uint32_t buffer)
+{
+  for (auto& bound : buffers_) {
+    if (bound == buffer) {
+      bound = 0;
+    }
+  }
+  // indexed bindings may or may not be reset by the driver
+  for (auto& binding : uniformBindings_) {
+    if (binding.Buffer == buffer) {
+      binding = { UNKNOWN, 0, 0 };
+    }
+  }
+}
+
+void
+StateCache::DeletedTexture(uint32_t texture)
+{
+  for (auto& unit : textures_) {
+    for (auto& bound : unit) {
+      if (bound == texture) {
+        bound = 0;
+      }
+    }
+  }
+}
+
+void
+StateCache::DeletedSampler(uint32_t sampler)
+{
+  for (auto& bound : samplers_) {
+    if (bound == sampler) {
+      bound = 0;
+    }
+  }
+}
+
+void
+StateCache::DeletedFramebuffer(uint32_t framebuffer)
+{
+  if (drawFramebuffer_ == framebuffer) {
+    drawFramebuffer_ = 0;
+  }
+  if (readFramebuffer_ == framebuffer) {
+    readFramebuffer_ = 0;
+  }
+}
+
+} // namespace
+} // namespace
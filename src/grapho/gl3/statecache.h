@@ -0,0 +1,123 @@
+#pragma once
+#include <stdint.h>
+
+namespace grapho {
+namespace gl3 {
+
+struct StateCounter
+{
+  // binds requested
+  uint32_t Calls = 0;
+  // of them skipped as already bound
+  uint32_t Filtered = 0;
+};
+
+struct StateCounters
+{
+  StateCounter Program;
+  StateCounter VertexArray;
+  StateCounter Buffer;
+  // glBindBufferBase, glBindBufferRange of uniform buffers
+  StateCounter IndexedBuffer;
+  // glBindTexture only. the glActiveTexture switches are not counted
+  StateCounter Texture;
+  StateCounter Sampler;
+  StateCounter Framebuffer;
+
+  uint32_t Calls() const
+  {
+    return Program.Calls + VertexArray.Calls + Buffer.Calls +
+           IndexedBuffer.Calls + Texture.Calls + Sampler.Calls +
+           Framebuffer.Calls;
+  }
+  uint32_t Filtered() const
+  {
+    return Program.Filtered + VertexArray.Filtered + Buffer.Filtered +
+           IndexedBuffer.Filtered + Texture.Filtered + Sampler.Filtered +
+           Framebuffer.Filtered;
+  }
+};
+
+//
+// the last bound objects of a context. gl3 wrappers bind through this and a
+// bind of the already bound object is skipped.
+//
+// one per thread, as a context is current on one thread. call Invalidate
+// after switching the context or after GL calls outside of grapho that
+// change these bindings.
+//
+class StateCache
+{
+  static constexpr uint32_t UNKNOWN = 0xFFFFFFFF;
+  static constexpr uint32_t BUFFER_TARGETS = 8;
+  static constexpr uint32_t TEXTURE_TARGETS = 2;
+  static constexpr uint32_t TEXTURE_UNITS = 32;
+  static constexpr uint32_t UNIFORM_BINDINGS = 16;
+
+  struct IndexedBinding
+  {
+    uint32_t Buffer;
+    uint32_t Offset;
+    uint32_t Size;
+  };
+
+  uint32_t program_ = UNKNOWN;
+  uint32_t vertexArray_ = UNKNOWN;
+  uint32_t buffers_[BUFFER_TARGETS];
+  IndexedBinding uniformBindings_[UNIFORM_BINDINGS];
+  uint32_t activeUnit_ = UNKNOWN;
+  uint32_t textures_[TEXTURE_UNITS][TEXTURE_TARGETS];
+  uint32_t samplers_[TEXTURE_UNITS];
+  uint32_t drawFramebuffer_ = UNKNOWN;
+  uint32_t readFramebuffer_ = UNKNOWN;
+
+public:
+  StateCounters Counters;
+
+  StateCache();
+  StateCache(const StateCache&) = delete;
+  StateCache& operator=(const StateCache&) = delete;
+
+  static StateCache& Current();
+
+  // forget everything. the next binds are all issued.
+  void Invalidate();
+  // per frame
+  StateCounters TakeCounters()
+  {
+    auto counters = Counters;
+    Counters = {};
+    return counters;
+  }
+
+  void UseProgram(uint32_t program);
+  // the element array buffer binding is a part of the vertex array
+  void BindVertexArray(uint32_t vertexArray);
+  void BindBuffer(uint32_t target, uint32_t buffer);
+  void BindBufferBase(uint32_t target, uint32_t index, uint32_t buffer);
+  void BindBufferRange(uint32_t target,
+                       uint32_t index,
+                       uint32_t buffer,
+                       uint32_t offset,
+                       uint32_t size);
+  void ActiveTexture(uint32_t unit);
+  // to the active unit. for uploads and parameters
+  void BindTexture(uint32_t target, uint32_t texture);
+  // glActiveTexture only when the unit needs the bind
+  void BindTexture(uint32_t unit, uint32_t target, uint32_t texture);
+  // 0 for the parameters of the texture
+  void BindSampler(uint32_t unit, uint32_t sampler);
+  // GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER
+  void BindFramebuffer(uint32_t target, uint32_t framebuffer);
+
+  // glDelete* unbinds the object. call after the delete so a recycled name
+  // is bound again.
+  void DeletedVertexArray(uint32_t vertexArray);
+  void DeletedBuffer(uint32_t buffer);
+  void DeletedTexture(uint32_t texture);
+  void DeletedSampler(uint32_t sampler);
+  void DeletedFramebuffer(uint32_t framebuffer);
+};
+
+} // namespace
+} // namespace
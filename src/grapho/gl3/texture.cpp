@@ -1,27 +1,75 @@
 // #include <Windows.h>
 #include <GL/glew.h>
 
+#include "error_check.h"
+#include "sampler.h"
+#include "statecache.h"
 #include "texture.h"
+#include <algorithm>
 #include <assert.h>
+#include <vector>
 
 namespace grapho {
 namespace gl3 {
 
+// nullopt without the extension
+static std::optional<uint32_t>
+GLCompressedFormat(PixelFormat format, ColorSpace colorspace)
+{
+  bool srgb = colorspace == ColorSpace::sRGB;
+  switch (format) {
+    case PixelFormat::bc1_RGB:
+      if (!GLEW_EXT_texture_compression_s3tc) {
+        break;
+      }
+      return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                  : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case PixelFormat::bc3_RGBA:
+      if (!GLEW_EXT_texture_compression_s3tc) {
+        break;
+      }
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                  : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case PixelFormat::bc4_R:
+      // rgtc is core in 3.0. no srgb
+      return srgb ? std::nullopt
+                  : std::optional<uint32_t>(GL_COMPRESSED_RED_RGTC1);
+    case PixelFormat::bc5_RG:
+      return srgb ? std::nullopt
+                  : std::optional<uint32_t>(GL_COMPRESSED_RG_RGTC2);
+    case PixelFormat::bc7_RGBA:
+      if (!GLEW_ARB_texture_compression_bptc) {
+        break;
+      }
+      return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+                  : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+      break;
+  }
+  return std::nullopt;
+}
+
 std::optional<uint32_t>
 GLImageFormat(PixelFormat format, ColorSpace colorspace)
 {
+  if (IsCompressed(format)) {
+    return GLCompressedFormat(format, colorspace);
+  }
+
   if (colorspace == ColorSpace::Linear) {
     switch (format) {
       case PixelFormat::f32_RGB:
         return GL_RGB32F;
       case PixelFormat::f16_RGB:
         return GL_RGB16F;
+      case PixelFormat::f16_RG:
+        return GL_RG16F;
       case PixelFormat::u8_RGBA:
-        return GL_RGBA;
+        return GL_RGBA8;
       case PixelFormat::u8_RGB:
-        return GL_RGB;
+        return GL_RGB8;
       case PixelFormat::u8_R:
-        return GL_RED;
+        return GL_R8;
       default:
         break;
     }
@@ -50,12 +98,149 @@ GLInternalFormat(PixelFormat format)
     case PixelFormat::u8_R:
       return GL_RED;
 
+    case PixelFormat::f16_RG:
+      return GL_RG;
+
     default:
       break;
   }
   return GL_RGB;
 }
 
+uint32_t
+GLPixelType(PixelFormat format)
+{
+  switch (format) {
+    case PixelFormat::f16_RGB:
+    case PixelFormat::f32_RGB:
+    case PixelFormat::f16_RG:
+      // float pixels
+      return GL_FLOAT;
+
+    default:
+      break;
+  }
+  return GL_UNSIGNED_BYTE;
+}
+
+void
+GLTexImage2D(uint32_t target,
+             int level,
+             uint32_t internalFormat,
+             PixelFormat format,
+             int width,
+             int height,
+             uint32_t type,
+             const void* pixels)
+{
+  if (IsCompressed(format)) {
+    glCompressedTexImage2D(target,
+                           level,
+                           internalFormat,
+                           width,
+                           height,
+                           0,
+                           ImageSize(format, width, height),
+                           pixels);
+  } else {
+    glTexImage2D(target,
+                 level,
+                 internalFormat,
+                 width,
+                 height,
+                 0,
+                 GLInternalFormat(format),
+                 type,
+                 pixels);
+  }
+}
+
+void
+GLTexSubImage2D(uint32_t target,
+                int level,
+                uint32_t internalFormat,
+                PixelFormat format,
+                int width,
+                int height,
+                uint32_t type,
+                const void* pixels)
+{
+  if (IsCompressed(format)) {
+    glCompressedTexSubImage2D(target,
+                              level,
+                              0,
+                              0,
+                              width,
+                              height,
+                              internalFormat,
+                              ImageSize(format, width, height),
+                              pixels);
+  } else {
+    glTexSubImage2D(target,
+                    level,
+                    0,
+                    0,
+                    width,
+                    height,
+                    GLInternalFormat(format),
+                    type,
+                    pixels);
+  }
+}
+
+void
+GLTexStorage2D(uint32_t target,
+               int levels,
+               uint32_t internalFormat,
+               PixelFormat format,
+               int width,
+               int height)
+{
+  if (GLEW_ARB_texture_storage) {
+    glTexStorage2D(target, levels, internalFormat, width, height);
+    return;
+  }
+  for (int i = 0; i < levels; ++i) {
+    auto w = std::max(width >> i, 1);
+    auto h = std::max(height >> i, 1);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+      for (int face = 0; face < 6; ++face) {
+        GLTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+                     i,
+                     internalFormat,
+                     format,
+                     w,
+                     h,
+                     GLPixelType(format),
+                     nullptr);
+      }
+    } else {
+      GLTexImage2D(
+        target, i, internalFormat, format, w, h, GLPixelType(format), nullptr);
+    }
+  }
+}
+
+bool
+IsTextureSizeSupported(uint32_t target, int width, int height)
+{
+  GLint maxSize = 0;
+  glGetIntegerv(target == GL_TEXTURE_CUBE_MAP ? GL_MAX_CUBE_MAP_TEXTURE_SIZE
+                                              : GL_MAX_TEXTURE_SIZE,
+                &maxSize);
+  return width > 0 && height > 0 && width <= maxSize && height <= maxSize;
+}
+
+static int
+FullLevelCount(int width, int height)
+{
+  int levels = 1;
+  while ((std::max(width, height) >> levels) > 0) {
+    ++levels;
+  }
+  return levels;
+}
+
 Texture::Texture()
 {
   glGenTextures(1, &m_handle);
@@ -64,25 +249,32 @@ Texture::Texture()
 Texture::~Texture()
 {
   glDeleteTextures(1, &m_handle);
+  StateCache::Current().DeletedTexture(m_handle);
 }
 
 void
 Texture::Bind() const
 {
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  StateCache::Current().BindTexture(GL_TEXTURE_2D, m_handle);
 }
 
 void
 Texture::Unbind() const
 {
-  glBindTexture(GL_TEXTURE_2D, 0);
+  StateCache::Current().BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void
 Texture::Activate(uint32_t unit) const
 {
-  glActiveTexture(GL_TEXTURE0 + unit);
-  glBindTexture(GL_TEXTURE_2D, m_handle);
+  StateCache::Current().BindTexture(unit, GL_TEXTURE_2D, m_handle);
+}
+
+void
+Texture::Activate(uint32_t unit, const Sampler& sampler) const
+{
+  Activate(unit);
+  sampler.Bind(unit);
 }
 
 void
@@ -91,27 +283,116 @@ Texture::Deactivate(uint32_t unit)
   glDisable(GL_TEXTURE0 + unit);
 }
 
-void
+bool
+Texture::Allocate(uint32_t internalFormat,
+                  PixelFormat format,
+                  int levels,
+                  int width,
+                  int height)
+{
+  Bind();
+  if (m_immutable) {
+    // can not be respecified. the levels are replaced by glTexSubImage2D
+    if (internalFormat == m_internalFormat && levels == m_levels &&
+        width == m_width && height == m_height) {
+      return true;
+    }
+    SetErrorMessage("immutable texture " + std::to_string(m_width) + "x" +
+                    std::to_string(m_height) + " can not be reallocated as " +
+                    std::to_string(width) + "x" + std::to_string(height));
+    return false;
+  }
+  GLTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, format, width, height);
+  m_immutable = GLEW_ARB_texture_storage;
+  m_internalFormat = internalFormat;
+  m_levels = levels;
+  m_width = width;
+  m_height = height;
+  return true;
+}
+
+bool
 Texture::Upload(const Image& data, bool useFloat)
 {
+  auto format = GLImageFormat(data.Format, data.ColorSpace);
+  if (!format) {
+    SamplingLinear();
+    WrapClamp();
+    return false;
+  }
+  // no mipmap generation for blocks. upload a MipChain instead
+  auto compressed = IsCompressed(data.Format);
+  if (!Allocate(*format,
+                data.Format,
+                compressed ? 1 : FullLevelCount(data.Width, data.Height),
+                data.Width,
+                data.Height)) {
+    return false;
+  }
   SamplingLinear();
   WrapClamp();
-  Bind();
-  if (auto format = GLImageFormat(data.Format, data.ColorSpace)) {
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,
-                 *format,
-                 data.Width,
-                 data.Height,
-                 0,
-                 GLInternalFormat(data.Format),
-                 useFloat ? GL_FLOAT : GL_UNSIGNED_BYTE,
-                 data.Pixels);
+  if (data.Pixels) {
+    GLTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    *format,
+                    data.Format,
+                    data.Width,
+                    data.Height,
+                    useFloat ? GL_FLOAT : GL_UNSIGNED_BYTE,
+                    data.Pixels);
+  }
+  if (compressed) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  } else {
     glGenerateMipmap(GL_TEXTURE_2D);
-    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &m_width);
-    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_height);
   }
-  Unbind();
+  return true;
+}
+
+bool
+Texture::Upload(const MipChain& chain)
+{
+  std::vector<Image> levels;
+  for (uint32_t i = 0; i < chain.LevelCount(); ++i) {
+    levels.push_back(chain.Level(i));
+  }
+  return Upload(levels);
+}
+
+bool
+Texture::Upload(std::span<const Image> levels)
+{
+  if (levels.empty()) {
+    return false;
+  }
+  auto& base = levels[0];
+  auto format = GLImageFormat(base.Format, base.ColorSpace);
+  if (!format ||
+      !IsTextureSizeSupported(GL_TEXTURE_2D, base.Width, base.Height)) {
+    return false;
+  }
+  if (!Allocate(
+        *format, base.Format, levels.size(), base.Width, base.Height)) {
+    return false;
+  }
+  SamplingLinear(levels.size() > 1);
+  WrapClamp();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (uint32_t i = 0; i < levels.size(); ++i) {
+    auto& level = levels[i];
+    GLTexSubImage2D(GL_TEXTURE_2D,
+                    i,
+                    *format,
+                    base.Format,
+                    level.Width,
+                    level.Height,
+                    GLPixelType(base.Format),
+                    level.Pixels);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+  return true;
 }
 
 void
@@ -120,7 +401,6 @@ Texture::WrapClamp()
   Bind();
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  Unbind();
 }
 
 void
@@ -129,7 +409,6 @@ Texture::WrapRepeat()
   Bind();
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  Unbind();
 }
 
 void
@@ -138,7 +417,6 @@ Texture::SamplingPoint()
   Bind();
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  Unbind();
 }
 
 void
@@ -153,7 +431,6 @@ Texture::SamplingLinear(bool mip)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   }
-  Unbind();
 }
 
 } // namespace
@@ -1,8 +1,10 @@
 #pragma once
 #include "../image.h"
+#include "../mipchain.h"
 #include <memory>
-#include <stdint.h>
 #include <optional>
+#include <span>
+#include <stdint.h>
 
 namespace grapho {
 namespace gl3 {
@@ -13,11 +15,70 @@ GLImageFormat(PixelFormat format, ColorSpace colorspace);
 uint32_t
 GLInternalFormat(PixelFormat format);
 
+// GL_FLOAT or GL_UNSIGNED_BYTE
+uint32_t
+GLPixelType(PixelFormat format);
+
+// glCompressedTexImage2D for a compressed format, that ignores the type.
+// pixels may be null
+void
+GLTexImage2D(uint32_t target,
+             int level,
+             uint32_t internalFormat,
+             PixelFormat format,
+             int width,
+             int height,
+             uint32_t type,
+             const void* pixels);
+
+// the whole level
+void
+GLTexSubImage2D(uint32_t target,
+                int level,
+                uint32_t internalFormat,
+                PixelFormat format,
+                int width,
+                int height,
+                uint32_t type,
+                const void* pixels);
+
+// immutable glTexStorage2D with ARB_texture_storage, else glTexImage2D of
+// every level and face. internalFormat must be sized, as GLImageFormat
+void
+GLTexStorage2D(uint32_t target,
+               int levels,
+               uint32_t internalFormat,
+               PixelFormat format,
+               int width,
+               int height);
+
+// within GL_MAX_TEXTURE_SIZE, or GL_MAX_CUBE_MAP_TEXTURE_SIZE for
+// GL_TEXTURE_CUBE_MAP. e.g. for the size read from a file
+bool
+IsTextureSizeSupported(uint32_t target, int width, int height);
+
+class Sampler;
+
 class Texture
 {
   uint32_t m_handle;
   int m_width = 0;
   int m_height = 0;
+  bool m_immutable = false;
+  uint32_t m_internalFormat = 0;
+  int m_levels = 0;
+  // allocates the streamed levels
+  friend class TextureStreamer;
+
+  // the storage for all the levels, bound. the Handle never changes, it may
+  // be held by an Fbo, a CommandQueue material or imgui. immutable storage
+  // is reused if the size, format and levels match, otherwise false with
+  // SetErrorMessage
+  bool Allocate(uint32_t internalFormat,
+                PixelFormat format,
+                int levels,
+                int width,
+                int height);
 
 public:
   Texture();
@@ -25,6 +86,8 @@ public:
   void Bind() const;
   void Unbind() const;
   void Activate(uint32_t unit) const;
+  // the sampler replaces the parameters below while bound to the unit
+  void Activate(uint32_t unit, const Sampler& sampler) const;
   static void Deactivate(uint32_t unit);
   const uint32_t& Handle() const { return m_handle; }
   int Width() const { return m_width; }
@@ -38,7 +101,36 @@ public:
     return ptr;
   }
 
-  void Upload(const Image& data, bool useFloat);
+  static std::shared_ptr<Texture> Create(const MipChain& chain)
+  {
+    auto ptr = std::shared_ptr<Texture>(new Texture());
+    if (!ptr->Upload(chain)) {
+      return {};
+    }
+    return ptr;
+  }
+
+  static std::shared_ptr<Texture> Create(std::span<const Image> levels)
+  {
+    auto ptr = std::shared_ptr<Texture>(new Texture());
+    if (!ptr->Upload(levels)) {
+      return {};
+    }
+    return ptr;
+  }
+
+  // Upload and the parameter setters leave the texture bound to the active
+  // unit. the storage is immutable where supported, a second Upload must
+  // have the same size and format. false if not
+  bool Upload(const Image& data, bool useFloat);
+
+  // all the levels of the chain as they are, no glGenerateMipmap.
+  // false for an unsupported format, or a mismatch of immutable storage
+  bool Upload(const MipChain& chain);
+
+  // level 0 first, the format of level 0. e.g. TextureFileView::Images.
+  // false for a size over GL_MAX_TEXTURE_SIZE
+  bool Upload(std::span<const Image> levels);
 
   void WrapClamp();
 
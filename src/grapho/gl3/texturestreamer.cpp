@@ -0,0 +1,169 @@
+#include <GL/glew.h>
+
+#include "ringbuffer.h"
+#include "statecache.h"
+#include "texture.h"
+#include "texturestreamer.h"
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+TextureStreamer::TextureStreamer(uint32_t budgetBytes,
+                                 uint32_t stagingBytes,
+                                 uint32_t threadCount)
+  : budget_(budgetBytes)
+  , staging_(RingBuffer::Create(GL_PIXEL_UNPACK_BUFFER, stagingBytes))
+  , pool_(threadCount)
+{
+}
+
+std::shared_ptr<TextureStreamer>
+TextureStreamer::Create(uint32_t budgetBytes,
+                        uint32_t stagingBytes,
+                        uint32_t threadCount)
+{
+  return std::make_shared<TextureStreamer>(
+    budgetBytes, stagingBytes, threadCount);
+}
+
+std::shared_ptr<Texture>
+TextureStreamer::Load(Decoder decode, const TextureStreamOptions& options)
+{
+  auto texture = std::shared_ptr<Texture>(new Texture());
+  texture->SamplingLinear();
+  texture->WrapClamp();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glTexImage2D(GL_TEXTURE_2D,
+               0,
+               GL_RGBA8,
+               1,
+               1,
+               0,
+               GL_RGBA,
+               GL_UNSIGNED_BYTE,
+               options.Placeholder);
+  texture->m_width = 1;
+  texture->m_height = 1;
+
+  ++decoding_;
+  std::weak_ptr<Texture> weak = texture;
+  pool_.Push([this, decode, weak, options]() {
+    if (auto chain = decode()) {
+      if (options.GenerateMips && chain->LevelCount() == 1) {
+        // already on a worker. one thread per texture
+        chain->Generate(options.Filter, 1);
+      }
+      std::lock_guard lock(mutex_);
+      decoded_.push_back({ .Target = weak, .Chain = std::move(*chain) });
+    }
+    --decoding_;
+  });
+  return texture;
+}
+
+bool
+TextureStreamer::Allocate(Request& request, Texture& texture)
+{
+  auto& chain = request.Chain;
+  auto format = GLImageFormat(chain.Format, chain.ColorSpace);
+  if (!format || chain.Levels.empty()) {
+    return false;
+  }
+  // the placeholder is mutable, this is the first storage
+  if (!texture.Allocate(*format,
+                        chain.Format,
+                        chain.LevelCount(),
+                        chain.Levels[0].Width,
+                        chain.Levels[0].Height)) {
+    return false;
+  }
+  request.Format = *format;
+  request.Level = chain.LevelCount() - 1;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, request.Level);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, request.Level);
+  request.Allocated = true;
+  return true;
+}
+
+void
+TextureStreamer::UploadLevel(Request& request, Texture& texture)
+{
+  auto& chain = request.Chain;
+  auto& level = chain.Levels[request.Level];
+  const void* pixels = chain.Pixels.data() + level.Offset;
+  auto block = staging_->Allocate(level.Size, 4);
+  if (block) {
+    memcpy(block->Data, pixels, level.Size);
+    staging_->Flush();
+    staging_->Bind();
+    pixels =
+      reinterpret_cast<const void*>(static_cast<uint64_t>(block->Offset));
+  } else {
+    staging_->Unbind();
+  }
+  texture.Bind();
+  GLTexSubImage2D(GL_TEXTURE_2D,
+                  request.Level,
+                  request.Format,
+                  chain.Format,
+                  level.Width,
+                  level.Height,
+                  GLPixelType(chain.Format),
+                  pixels);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, request.Level);
+}
+
+TextureStreamStatistics
+TextureStreamer::Update()
+{
+  {
+    std::lock_guard lock(mutex_);
+    for (auto& request : decoded_) {
+      uploads_.push_back(std::move(request));
+    }
+    decoded_.clear();
+  }
+
+  TextureStreamStatistics stats;
+  if (!uploads_.empty()) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    while (!uploads_.empty()) {
+      auto& request = uploads_.front();
+      auto texture = request.Target.lock();
+      if (!texture) {
+        // released while loading
+        uploads_.pop_front();
+        continue;
+      }
+      if (!request.Allocated && !Allocate(request, *texture)) {
+        // keeps the placeholder
+        uploads_.pop_front();
+        continue;
+      }
+      auto size = request.Chain.Levels[request.Level].Size;
+      if (stats.UploadedLevels && stats.UploadedBytes + size > budget_) {
+        break;
+      }
+      UploadLevel(request, *texture);
+      stats.UploadedBytes += size;
+      ++stats.UploadedLevels;
+      if (request.Level == 0) {
+        uploads_.pop_front();
+        ++stats.CompletedTextures;
+      } else {
+        --request.Level;
+      }
+    }
+    staging_->Unbind();
+    staging_->EndFrame();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
+  stats.Decoding = decoding_;
+  stats.Uploading = uploads_.size();
+  return stats;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,109 @@
+#pragma once
+#include "../mipchain.h"
+#include "../parallel.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+class Texture;
+class RingBuffer;
+
+struct TextureStreamOptions
+{
+  // RGBA of the 1x1 texture until the first level arrives
+  uint8_t Placeholder[4] = { 128, 128, 128, 255 };
+  // on the worker when the decoder returns level 0 only
+  bool GenerateMips = true;
+  MipFilter Filter = MipFilter::Box;
+};
+
+struct TextureStreamStatistics
+{
+  // on the workers
+  uint32_t Decoding = 0;
+  // decoded and not fully uploaded
+  uint32_t Uploading = 0;
+  // this Update
+  uint32_t UploadedBytes = 0;
+  uint32_t UploadedLevels = 0;
+  uint32_t CompletedTextures = 0;
+};
+
+//
+// textures loaded in the background.
+//
+// Load returns a texture at once, a 1x1 placeholder. the decoder and the mip
+// generation run on a ThreadPool. Update, once a frame on the GL thread,
+// uploads the decoded levels through a pixel unpack RingBuffer within a byte
+// budget, the smallest level first. GL_TEXTURE_BASE_LEVEL follows the
+// uploaded levels, so the texture sharpens over a few frames and the handle
+// stays the same, e.g. for a CommandQueue material.
+//
+//   auto texture = streamer->Load([path]() -> std::optional<MipChain> {
+//     ... decode
+//     return MipChain::FromImage(image);
+//   });
+//   ...
+//   streamer->Update(); // per frame
+//
+class TextureStreamer
+{
+  struct Request
+  {
+    std::weak_ptr<gl3::Texture> Target;
+    MipChain Chain;
+    bool Allocated = false;
+    // GLImageFormat
+    uint32_t Format = 0;
+    // uploaded next. from the last level to 0
+    uint32_t Level = 0;
+  };
+
+  uint32_t budget_;
+  std::shared_ptr<RingBuffer> staging_;
+  std::deque<Request> uploads_;
+
+  std::mutex mutex_;
+  std::vector<Request> decoded_;
+  std::atomic<uint32_t> decoding_ = 0;
+
+  // last. joins before the members the jobs use are destroyed
+  ThreadPool pool_;
+
+  bool Allocate(Request& request, Texture& texture);
+  void UploadLevel(Request& request, Texture& texture);
+
+public:
+  using Decoder = std::function<std::optional<MipChain>()>;
+
+  TextureStreamer(uint32_t budgetBytes,
+                  uint32_t stagingBytes,
+                  uint32_t threadCount);
+  TextureStreamer(const TextureStreamer&) = delete;
+  TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+  // budgetBytes per Update. a level larger than the budget goes alone.
+  // stagingBytes of pixel unpack buffer. a larger level is uploaded from
+  // client memory.
+  static std::shared_ptr<TextureStreamer> Create(
+    uint32_t budgetBytes = 4 * 1024 * 1024,
+    uint32_t stagingBytes = 16 * 1024 * 1024,
+    uint32_t threadCount = 0);
+
+  // decode is called on a worker. nullopt keeps the placeholder
+  std::shared_ptr<Texture> Load(Decoder decode,
+                                const TextureStreamOptions& options = {});
+
+  TextureStreamStatistics Update();
+};
+
+} // namespace
+} // namespace
@@ -1,5 +1,10 @@
 #pragma once
+#include "statecache.h"
+#include <algorithm>
+#include <memory>
 #include <stdint.h>
+#include <string.h>
+#include <type_traits>
 
 namespace grapho {
 namespace gl3 {
@@ -13,13 +18,13 @@ struct Ubo
     auto ptr = std::make_shared<Ubo>();
 
     glGenBuffers(1, &ptr->ubo_);
-    glBindBuffer(GL_UNIFORM_BUFFER, ptr->ubo_);
+    ptr->Bind();
     if (data) {
       glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW);
     } else {
       glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
     }
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    ptr->Unbind();
 
     return ptr;
   }
@@ -29,22 +34,93 @@ struct Ubo
     return Create(sizeof(T), nullptr);
   }
 
-  void Bind() { glBindBuffer(GL_UNIFORM_BUFFER, ubo_); }
-  void Unbind() { glBindBuffer(GL_UNIFORM_BUFFER, 0); }
+  void Bind() { StateCache::Current().BindBuffer(GL_UNIFORM_BUFFER, ubo_); }
+  void Unbind() { StateCache::Current().BindBuffer(GL_UNIFORM_BUFFER, 0); }
   void Upload(uint32_t size, const void* data)
   {
     Bind();
     glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
-    Unbind();
   }
   template<typename T>
   void Upload(const T& data)
   {
     Upload(sizeof(T), &data);
   }
+  // bytes [offset, offset + size) of the buffer
+  void Upload(uint32_t offset, uint32_t size, const void* data)
+  {
+    Bind();
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+  }
   void SetBindingPoint(uint32_t binding_point)
   {
-    glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, ubo_);
+    StateCache::Current().BindBufferBase(
+      GL_UNIFORM_BUFFER, binding_point, ubo_);
+  }
+};
+
+//
+// a cpu copy of a block and the bytes changed since the last Flush. Flush
+// uploads one range from the first to the last changed byte, e.g. the
+// camera of a WorldVars every frame and the lights only when they move.
+// T is described by a Std140Layout, see MatchUniformBlock.
+//
+//   world->Set(&WorldVars::view, camera.ViewMatrix);
+//   world->Flush();
+//   world->Buffer()->SetBindingPoint(0);
+//
+template<typename T>
+class ShadowUbo
+{
+  std::shared_ptr<Ubo> ubo_;
+  T value_;
+  // dirty [begin_, end_). all of it until the first Flush
+  uint32_t begin_ = 0;
+  uint32_t end_ = sizeof(T);
+
+public:
+  ShadowUbo(const T& value)
+    : ubo_(Ubo::Create<T>())
+    , value_(value)
+  {
+  }
+
+  static std::shared_ptr<ShadowUbo> Create(const T& value = {})
+  {
+    return std::make_shared<ShadowUbo>(value);
+  }
+
+  const std::shared_ptr<Ubo>& Buffer() const { return ubo_; }
+  const T& Value() const { return value_; }
+
+  // an equal value keeps the member clean
+  template<typename M>
+  void Set(M T::*member, const std::type_identity_t<M>& value)
+  {
+    auto& dst = value_.*member;
+    if (memcmp(&dst, &value, sizeof(M)) == 0) {
+      return;
+    }
+    memcpy(&dst, &value, sizeof(M));
+    MarkDirty((const uint8_t*)&dst - (const uint8_t*)&value_, sizeof(M));
+  }
+
+  void MarkDirty(uint32_t offset, uint32_t size)
+  {
+    begin_ = std::min(begin_, offset);
+    end_ = std::max(end_, offset + size);
+  }
+
+  // bytes to upload by the next Flush
+  uint32_t DirtySize() const { return begin_ < end_ ? end_ - begin_ : 0; }
+
+  void Flush()
+  {
+    if (begin_ < end_) {
+      ubo_->Upload(begin_, end_ - begin_, (const uint8_t*)&value_ + begin_);
+    }
+    begin_ = sizeof(T);
+    end_ = 0;
   }
 };
 
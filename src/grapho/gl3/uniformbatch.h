@@ -0,0 +1,92 @@
+#pragma once
+#include <GL/glew.h>
+
+#include "ringbuffer.h"
+#include <string.h>
+
+namespace grapho {
+namespace gl3 {
+
+//
+// per object uniform blocks of a frame packed in one RingBuffer allocation.
+// an entry per draw at a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+// selected with glBindBufferRange instead of an upload per draw.
+//
+//   batch->Begin(objects.size());
+//   for (i...) batch->Set(i, objects[i].Vars);
+//   batch->Flush();
+//   for (i...) { batch->BindRange(1, i); draw... }
+//   batch->EndFrame();
+//
+template<typename T>
+class UniformBatch
+{
+  std::shared_ptr<RingBuffer> ring_;
+  uint32_t stride_;
+  RingBlock block_ = {};
+  uint32_t count_ = 0;
+
+public:
+  UniformBatch(const std::shared_ptr<RingBuffer>& ring, uint32_t stride)
+    : ring_(ring)
+    , stride_(stride)
+  {
+  }
+
+  // room for maxCount objects in each of framesInFlight frames
+  static std::shared_ptr<UniformBatch> Create(uint32_t maxCount,
+                                              uint32_t framesInFlight = 3,
+                                              bool persistent = true)
+  {
+    auto alignment = UniformBufferOffsetAlignment();
+    auto stride = (sizeof(T) + alignment - 1) / alignment * alignment;
+    auto ring = RingBuffer::Create(
+      GL_UNIFORM_BUFFER, stride * maxCount * framesInFlight, persistent);
+    return std::make_shared<UniformBatch>(ring, stride);
+  }
+
+  const std::shared_ptr<RingBuffer>& Ring() const { return ring_; }
+  uint32_t Stride() const { return stride_; }
+  uint32_t Count() const { return count_; }
+
+  // false if count entries do not fit
+  bool Begin(uint32_t count)
+  {
+    count_ = 0;
+    if (count == 0) {
+      return true;
+    }
+    auto block = ring_->Allocate(stride_ * count);
+    if (!block) {
+      return false;
+    }
+    block_ = *block;
+    count_ = count;
+    return true;
+  }
+
+  // the mapped memory is write only. fill the value on the stack and copy.
+  void Set(uint32_t index, const T& value)
+  {
+    memcpy(block_.Data + index * stride_, &value, sizeof(T));
+  }
+
+  void Flush() { ring_->Flush(); }
+
+  // the range of index, e.g. for DrawItem::ObjectBuffer
+  uint32_t Buffer() const { return ring_->Handle(); }
+  uint32_t Offset(uint32_t index) const
+  {
+    return block_.Offset + index * stride_;
+  }
+
+  void BindRange(uint32_t bindingPoint, uint32_t index)
+  {
+    ring_->BindRange(bindingPoint, Offset(index), stride_);
+  }
+
+  void EndFrame() { ring_->EndFrame(); }
+};
+
+} // namespace
+} // namespace
@@ -0,0 +1,199 @@
+#include <GL/glew.h>
+// for glsl_type_name.h
+#include <assert.h>
+
+#include "error_check.h"
+#include "glsl_type_name.h"
+#include "uniformblock.h"
+#include <algorithm>
+
+namespace grapho {
+namespace gl3 {
+
+static GLenum
+GLType(Std140Type type)
+{
+  switch (type) {
+    case Std140Type::Float:
+      return GL_FLOAT;
+    case Std140Type::Int:
+      return GL_INT;
+    case Std140Type::UInt:
+      return GL_UNSIGNED_INT;
+    case Std140Type::Vec2:
+      return GL_FLOAT_VEC2;
+    case Std140Type::Vec3:
+      return GL_FLOAT_VEC3;
+    case Std140Type::Vec4:
+      return GL_FLOAT_VEC4;
+    case Std140Type::IVec4:
+      return GL_INT_VEC4;
+    case Std140Type::UVec4:
+      return GL_UNSIGNED_INT_VEC4;
+    case Std140Type::Mat3:
+      return GL_FLOAT_MAT3;
+    case Std140Type::Mat4:
+      return GL_FLOAT_MAT4;
+  }
+  return 0;
+}
+
+// "EnvVars.lightPositions[0]" to "lightPositions"
+static std::string
+MemberName(std::string_view name, std::string_view block)
+{
+  if (name.starts_with(block) && name.size() > block.size() &&
+      name[block.size()] == '.') {
+    name.remove_prefix(block.size() + 1);
+  }
+  if (name.ends_with("[0]")) {
+    name.remove_suffix(3);
+  }
+  return { name.begin(), name.end() };
+}
+
+static std::vector<GLint>
+GetUniforms(GLuint program, std::span<const GLuint> indices, GLenum pname)
+{
+  std::vector<GLint> values(indices.size());
+  glGetActiveUniformsiv(
+    program, indices.size(), indices.data(), pname, values.data());
+  return values;
+}
+
+std::vector<UniformBlock>
+ReflectUniformBlocks(uint32_t program)
+{
+  GLint count = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  GLint maxBlockName = 0;
+  glGetProgramiv(
+    program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockName);
+  GLint maxName = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxName);
+  std::string buf(std::max(maxBlockName, maxName) + 1, '\0');
+
+  std::vector<UniformBlock> blocks;
+  for (GLint i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(program, i, buf.size(), &length, buf.data());
+    UniformBlock block{
+      .Name = buf.substr(0, length),
+      .Index = static_cast<uint32_t>(i),
+    };
+    GLint value = 0;
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &value);
+    block.Binding = value;
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &value);
+    block.DataSize = value;
+
+    GLint memberCount = 0;
+    glGetActiveUniformBlockiv(
+      program, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+    std::vector<GLint> indices(memberCount);
+    glGetActiveUniformBlockiv(
+      program, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+    std::vector<GLuint> uindices(indices.begin(), indices.end());
+
+    auto types = GetUniforms(program, uindices, GL_UNIFORM_TYPE);
+    auto offsets = GetUniforms(program, uindices, GL_UNIFORM_OFFSET);
+    auto sizes = GetUniforms(program, uindices, GL_UNIFORM_SIZE);
+    auto arrayStrides = GetUniforms(program, uindices, GL_UNIFORM_ARRAY_STRIDE);
+    auto matrixStrides =
+      GetUniforms(program, uindices, GL_UNIFORM_MATRIX_STRIDE);
+    auto rowMajors = GetUniforms(program, uindices, GL_UNIFORM_IS_ROW_MAJOR);
+    for (size_t j = 0; j < uindices.size(); ++j) {
+      glGetActiveUniformName(
+        program, uindices[j], buf.size(), &length, buf.data());
+      block.Members.push_back({
+        .Name = MemberName({ buf.data(), static_cast<size_t>(length) },
+                           block.Name),
+        .Type = static_cast<uint32_t>(types[j]),
+        .Offset = static_cast<uint32_t>(offsets[j]),
+        .ArraySize = static_cast<uint32_t>(sizes[j]),
+        .ArrayStride = static_cast<uint32_t>(arrayStrides[j]),
+        .MatrixStride = static_cast<uint32_t>(matrixStrides[j]),
+        .IsRowMajor = rowMajors[j] != 0,
+      });
+    }
+    std::sort(block.Members.begin(),
+              block.Members.end(),
+              [](auto& lhs, auto& rhs) { return lhs.Offset < rhs.Offset; });
+    blocks.push_back(std::move(block));
+  }
+  return blocks;
+}
+
+std::optional<UniformBlock>
+ReflectUniformBlock(uint32_t program, std::string_view name)
+{
+  for (auto& block : ReflectUniformBlocks(program)) {
+    if (block.Name == name) {
+      return block;
+    }
+  }
+  SetErrorMessage(std::string(name) + ": no active uniform block");
+  return std::nullopt;
+}
+
+bool
+MatchUniformBlock(const UniformBlock& block,
+                  std::span<const Std140Member> members,
+                  uint32_t size)
+{
+  if (block.DataSize > size) {
+    SetErrorMessage(block.Name + ": " + std::to_string(block.DataSize) +
+                    " bytes, the struct " + std::to_string(size));
+    return false;
+  }
+  for (auto& member : block.Members) {
+    auto found = std::find_if(
+      members.begin(), members.end(), [&member](const Std140Member& m) {
+        return m.Name == member.Name;
+      });
+    auto name = block.Name + "." + member.Name;
+    if (found == members.end()) {
+      SetErrorMessage(name + ": not in the struct");
+      return false;
+    }
+    if (GLType(found->Type) != member.Type) {
+      SetErrorMessage(name + ": " + ShaderTypeName(member.Type) +
+                      " in the shader");
+      return false;
+    }
+    if (found->Offset != member.Offset) {
+      SetErrorMessage(name + ": offset " + std::to_string(member.Offset) +
+                      ", the struct " + std::to_string(found->Offset));
+      return false;
+    }
+    if (std::max(found->ArraySize, 1u) != member.ArraySize) {
+      SetErrorMessage(name + ": " + std::to_string(member.ArraySize) +
+                      " elements, the struct " +
+                      std::to_string(found->ArraySize));
+      return false;
+    }
+    // a shared or packed block may pad differently with the same offsets
+    if (found->ArraySize &&
+        member.ArrayStride != Std140Stride(found->Type)) {
+      SetErrorMessage(name + ": array stride " +
+                      std::to_string(member.ArrayStride) + ", std140 " +
+                      std::to_string(Std140Stride(found->Type)));
+      return false;
+    }
+    if (found->Type == Std140Type::Mat3 || found->Type == Std140Type::Mat4) {
+      if (member.IsRowMajor) {
+        SetErrorMessage(name + ": row_major");
+        return false;
+      }
+      if (member.MatrixStride != 16) {
+        SetErrorMessage(name + ": matrix stride " +
+                        std::to_string(member.MatrixStride) + ", std140 16");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,67 @@
+#pragma once
+#include "../std140.h"
+#include <optional>
+#include <span>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace grapho {
+namespace gl3 {
+
+struct UniformBlockMember
+{
+  // without the block name and "[0]". "lightPositions"
+  std::string Name;
+  // GLenum. GL_FLOAT_VEC4...
+  uint32_t Type;
+  uint32_t Offset;
+  // 1 if not an array
+  uint32_t ArraySize;
+  // 0 if not an array
+  uint32_t ArrayStride;
+  // 0 if not a matrix
+  uint32_t MatrixStride;
+  bool IsRowMajor;
+};
+
+// an active uniform block of a linked program
+struct UniformBlock
+{
+  std::string Name;
+  uint32_t Index;
+  uint32_t Binding;
+  // the minimum buffer range to bind
+  uint32_t DataSize;
+  // in the order of Offset
+  std::vector<UniformBlockMember> Members;
+};
+
+std::vector<UniformBlock>
+ReflectUniformBlocks(uint32_t program);
+
+std::optional<UniformBlock>
+ReflectUniformBlock(uint32_t program, std::string_view name);
+
+// every member of block in members with the same type, offset, array size
+// and std140 strides, column major, and DataSize not over size. members may
+// have more, the block may not. false with SetErrorMessage on the first
+// difference
+bool
+MatchUniformBlock(const UniformBlock& block,
+                  std::span<const Std140Member> members,
+                  uint32_t size);
+
+// e.g. at load. MatchUniformBlock<WorldVars>(shader->Handle(), "EnvVars")
+template<typename T>
+bool
+MatchUniformBlock(uint32_t program, std::string_view name)
+{
+  auto block = ReflectUniformBlock(program, name);
+  return block &&
+         MatchUniformBlock(*block, Std140Layout<T>::Members, sizeof(T));
+}
+
+} // namespace
+} // namespace
@@ -1,6 +1,8 @@
 #include <GL/glew.h>
+#include <algorithm>
 #include <stdexcept>
 
+#include "statecache.h"
 #include "vao.h"
 
 namespace grapho {
@@ -28,6 +30,13 @@ GLType(ValueType type)
       return GL_UNSIGNED_SHORT;
     case ValueType::UInt32:
       return GL_UNSIGNED_INT;
+
+    case ValueType::Half:
+      return GL_HALF_FLOAT;
+    case ValueType::Int2_10_10_10:
+      return GL_INT_2_10_10_10_REV;
+    case ValueType::UInt2_10_10_10:
+      return GL_UNSIGNED_INT_2_10_10_10_REV;
   }
 
   return {};
@@ -74,6 +83,7 @@ Vbo::Vbo(uint32_t vbo)
 Vbo::~Vbo()
 {
   glDeleteBuffers(1, &vbo_);
+  StateCache::Current().DeletedBuffer(vbo_);
 }
 std::shared_ptr<Vbo>
 Vbo::Create(uint32_t size, const void* data)
@@ -94,19 +104,30 @@ Vbo::Create(uint32_t size, const void* data)
 void
 Vbo::Bind()
 {
-  glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+  StateCache::Current().BindBuffer(GL_ARRAY_BUFFER, vbo_);
 }
 void
 Vbo::Unbind()
 {
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  StateCache::Current().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 void
 Vbo::Upload(uint32_t size, const void* data)
 {
   Bind();
   glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
-  Unbind();
+}
+void
+Vbo::Upload(uint32_t offset, uint32_t size, const void* data)
+{
+  Bind();
+  glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+void
+Vbo::Orphan(uint32_t size, const void* data)
+{
+  Bind();
+  glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
 }
 
 Ibo::Ibo(uint32_t ibo, uint32_t valuetype)
@@ -117,6 +138,7 @@ Ibo::Ibo(uint32_t ibo, uint32_t valuetype)
 Ibo::~Ibo()
 {
   glDeleteBuffers(1, &ibo_);
+  StateCache::Current().DeletedBuffer(ibo_);
 }
 std::shared_ptr<Ibo>
 Ibo::Create(uint32_t size, const void* data, uint32_t valuetype)
@@ -124,6 +146,8 @@ Ibo::Create(uint32_t size, const void* data, uint32_t valuetype)
   GLuint ibo;
   glGenBuffers(1, &ibo);
   auto ptr = std::shared_ptr<Ibo>(new Ibo(ibo, valuetype));
+  // a vertex array may be left bound by Vao::Draw. keep its element buffer.
+  StateCache::Current().BindVertexArray(0);
   ptr->Bind();
   if (data) {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
@@ -137,12 +161,19 @@ Ibo::Create(uint32_t size, const void* data, uint32_t valuetype)
 void
 Ibo::Bind()
 {
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+  StateCache::Current().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
 }
 void
 Ibo::Unbind()
 {
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  StateCache::Current().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+void
+Ibo::Upload(uint32_t offset, uint32_t size, const void* data)
+{
+  StateCache::Current().BindVertexArray(0);
+  Bind();
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, data);
 }
 
 Vao::Vao(uint32_t vao,
@@ -166,7 +197,7 @@ Vao::Vao(uint32_t vao,
       layout.Id.AttributeLocation,
       layout.Count,
       *GLType(layout.Type),
-      GL_FALSE,
+      layout.Normalized ? GL_TRUE : GL_FALSE,
       layout.Stride,
       reinterpret_cast<void*>(static_cast<uint64_t>(layout.Offset)));
     if (layout.Divisor) {
@@ -178,12 +209,13 @@ Vao::Vao(uint32_t vao,
   if (ibo_) {
     ibo_->Unbind();
   }
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  StateCache::Current().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 Vao::~Vao()
 {
   glDeleteVertexArrays(1, &vao_);
+  StateCache::Current().DeletedVertexArray(vao_);
 }
 
 std::shared_ptr<Vao>
@@ -200,8 +232,12 @@ Vao::Create(SpanModoki<VertexLayout> layouts,
 std::shared_ptr<Vao>
 Vao::Create(const std::shared_ptr<Mesh>& mesh)
 {
-  std::shared_ptr<Vbo> slots[1] = { Vbo::Create(mesh->Vertices.Size(),
-                                                mesh->Vertices.Data()) };
+  // one vbo per stream
+  std::vector<std::shared_ptr<Vbo>> slots;
+  for (uint32_t i = 0; i < mesh->SlotCount(); ++i) {
+    auto& stream = mesh->Slot(i);
+    slots.push_back(Vbo::Create(stream.Size(), stream.Data()));
+  }
   std::shared_ptr<Ibo> ibo;
   if (mesh->Indices.Size()) {
     ibo = Ibo::Create(mesh->Indices.Size(),
@@ -210,15 +246,46 @@ Vao::Create(const std::shared_ptr<Mesh>& mesh)
   }
   return Create(make_span(mesh->Layouts), make_span(slots), ibo);
 }
+
+std::shared_ptr<Vao>
+Vao::CreateSubset(std::span<const uint32_t> attributeLocations) const
+{
+  std::vector<VertexLayout> layouts;
+  for (auto& layout : layouts_) {
+    if (std::find(attributeLocations.begin(),
+                  attributeLocations.end(),
+                  layout.Id.AttributeLocation) != attributeLocations.end()) {
+      layouts.push_back(layout);
+    }
+  }
+  return Create(make_span(layouts), make_span(slots_), ibo_);
+}
+
+std::shared_ptr<Vao>
+Vao::CreateInstanced(SpanModoki<VertexLayout> instanceLayouts,
+                     const std::shared_ptr<Vbo>& instances) const
+{
+  auto layouts = layouts_;
+  uint32_t slot = slots_.size();
+  for (auto layout : instanceLayouts) {
+    layout.Id.Slot = slot;
+    layout.Divisor = std::max(layout.Divisor, 1u);
+    layouts.push_back(layout);
+  }
+  auto slots = slots_;
+  slots.push_back(instances);
+  return Create(make_span(layouts), make_span(slots), ibo_);
+}
+
 void
 Vao::Bind()
 {
-  glBindVertexArray(vao_);
+  StateCache::Current().BindVertexArray(vao_);
 }
 void
 Vao::Unbind()
 {
-  glBindVertexArray(0);
+  StateCache::Current().BindVertexArray(0);
 }
 void
 Vao::Draw(uint32_t mode, uint32_t count, uint32_t offsetBytes)
@@ -232,23 +299,43 @@ Vao::Draw(uint32_t mode, uint32_t count, uint32_t offsetBytes)
   } else {
     glDrawArrays(mode, offsetBytes, count);
   }
-  Unbind();
+  // stays bound. the next draw of the same vao skips the bind
 }
 void
-Vao::DrawInstance(uint32_t primcount, uint32_t count, uint32_t offsetBytes)
+Vao::DrawInstance(uint32_t mode,
+                  uint32_t primcount,
+                  uint32_t count,
+                  uint32_t offsetBytes)
 {
   Bind();
   if (ibo_) {
     glDrawElementsInstanced(
-      GL_TRIANGLES,
+      mode,
       count,
       ibo_->valuetype_,
       reinterpret_cast<void*>(static_cast<uint64_t>(offsetBytes)),
       primcount);
   } else {
-    throw std::runtime_error("not implemented");
+    glDrawArraysInstanced(mode, offsetBytes, count, primcount);
+  }
+}
+void
+Vao::DrawBaseVertex(uint32_t mode,
+                    uint32_t count,
+                    uint32_t offsetBytes,
+                    int32_t baseVertex)
+{
+  Bind();
+  if (ibo_) {
+    glDrawElementsBaseVertex(
+      mode,
+      count,
+      ibo_->valuetype_,
+      reinterpret_cast<void*>(static_cast<uint64_t>(offsetBytes)),
+      baseVertex);
+  } else {
+    glDrawArrays(mode, offsetBytes + baseVertex, count);
   }
-  Unbind();
 }
 
 } // namespace
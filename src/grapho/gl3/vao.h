@@ -3,6 +3,7 @@
 #include <assert.h>
 #include <memory>
 #include <optional>
+#include <span>
 #include <stdint.h>
 #include <vector>
 
@@ -26,6 +27,7 @@ class Vbo
 
 public:
   ~Vbo();
+  uint32_t Handle() const { return vbo_; }
   static std::shared_ptr<Vbo> Create(uint32_t size, const void* data);
 
   template<typename T>
@@ -43,6 +45,9 @@ public:
   void Bind();
   void Unbind();
   void Upload(uint32_t size, const void* data);
+  void Upload(uint32_t offset, uint32_t size, const void* data);
+  // new storage. draws still reading the old one are not waited for.
+  void Orphan(uint32_t size, const void* data);
 };
 
 class Ibo
@@ -54,6 +59,7 @@ class Ibo
 public:
   uint32_t valuetype_ = 0;
   ~Ibo();
+  uint32_t Handle() const { return ibo_; }
   static std::shared_ptr<Ibo> Create(uint32_t size,
                                      const void* data,
                                      uint32_t valuetype);
@@ -77,6 +83,8 @@ public:
   }
   void Bind();
   void Unbind();
+  // binds vertex array 0 to keep the element buffer of a bound vao
+  void Upload(uint32_t offset, uint32_t size, const void* data);
 };
 
 struct Vao
@@ -96,12 +104,28 @@ struct Vao
                                      SpanModoki<std::shared_ptr<Vbo>> slots,
                                      const std::shared_ptr<Ibo>& ibo = {});
   static std::shared_ptr<Vao> Create(const std::shared_ptr<Mesh>& mesh);
+  // the same buffers with the given attributes only.
+  // e.g. { 0 } for a depth pass of a mesh with positions in its own stream.
+  std::shared_ptr<Vao> CreateSubset(
+    std::span<const uint32_t> attributeLocations) const;
+  // the same buffers and instances as one more slot. Divisor 0 is taken as 1.
+  std::shared_ptr<Vao> CreateInstanced(
+    SpanModoki<VertexLayout> instanceLayouts,
+    const std::shared_ptr<Vbo>& instances) const;
   void Bind();
   void Unbind();
   void Draw(uint32_t mode, uint32_t count, uint32_t offsetBytes = 0);
-  void DrawInstance(uint32_t primcount,
+  // glDrawElementsInstanced or glDrawArraysInstanced.
+  // offsetBytes is the first vertex for a vao without indices, as in Draw.
+  void DrawInstance(uint32_t mode,
+                    uint32_t primcount,
                     uint32_t count,
                     uint32_t offsetBytes = 0);
+  // glDrawElementsBaseVertex. e.g. a MeshRange of a GeometryArena
+  void DrawBaseVertex(uint32_t mode,
+                      uint32_t count,
+                      uint32_t offsetBytes,
+                      int32_t baseVertex);
 };
 
 } // namespace
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+namespace grapho {
+
+// IEEE 754 binary16. round to nearest even, inf/nan kept.
+inline uint16_t
+FloatToHalf(float value)
+{
+  uint32_t f;
+  memcpy(&f, &value, 4);
+  uint32_t sign = (f >> 16) & 0x8000;
+  uint32_t exponent = (f >> 23) & 0xff;
+  uint32_t mantissa = f & 0x7fffff;
+
+  if (exponent == 0xff) {
+    // inf, nan
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  }
+  int e = static_cast<int>(exponent) - 127 + 15;
+  if (e >= 0x1f) {
+    // overflow
+    return sign | 0x7c00;
+  }
+  if (e <= 0) {
+    // subnormal or zero
+    if (e < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    auto shift = 14 - e;
+    uint32_t half = mantissa >> shift;
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) {
+      ++half;
+    }
+    return sign | half;
+  }
+  uint32_t half = (e << 10) | (mantissa >> 13);
+  uint32_t rest = mantissa & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+    // may carry into the exponent, which is still correct
+    ++half;
+  }
+  return sign | half;
+}
+
+inline float
+HalfToFloat(uint16_t value)
+{
+  uint32_t sign = (value & 0x8000u) << 16;
+  uint32_t exponent = (value >> 10) & 0x1f;
+  uint32_t mantissa = value & 0x3ff;
+  uint32_t f;
+  if (exponent == 0) {
+    if (mantissa == 0) {
+      f = sign;
+    } else {
+      // subnormal
+      exponent = 127 - 15 + 1;
+      while (!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        --exponent;
+      }
+      mantissa &= 0x3ff;
+      f = sign | (exponent << 23) | (mantissa << 13);
+    }
+  } else if (exponent == 0x1f) {
+    f = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+  float result;
+  memcpy(&result, &f, 4);
+  return result;
+}
+
+}
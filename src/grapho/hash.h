@@ -0,0 +1,49 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+
+namespace grapho {
+
+const uint64_t FNV1A64_OFFSET = 0xcbf29ce484222325ull;
+const uint64_t FNV1A64_PRIME = 0x100000001b3ull;
+
+// byte wise. usable in constant expressions for names.
+constexpr uint64_t
+Fnv1a64(std::string_view bytes, uint64_t hash = FNV1A64_OFFSET)
+{
+  for (auto c : bytes) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= FNV1A64_PRIME;
+  }
+  return hash;
+}
+
+// 8 bytes per step for large buffers such as image pixels.
+inline uint64_t
+HashBytes(const void* data, size_t size, uint64_t hash = FNV1A64_OFFSET)
+{
+  auto p = static_cast<const uint8_t*>(data);
+  hash ^= size * FNV1A64_PRIME;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t k;
+    memcpy(&k, p, 8);
+    k *= 0x9e3779b97f4a7c15ull;
+    k ^= k >> 32;
+    hash = (hash ^ k) * FNV1A64_PRIME;
+  }
+  for (; size; --size, ++p) {
+    hash = (hash ^ *p) * FNV1A64_PRIME;
+  }
+  return hash;
+}
+
+template<typename T>
+inline uint64_t
+HashValue(const T& value, uint64_t hash = FNV1A64_OFFSET)
+{
+  return HashBytes(&value, sizeof(T), hash);
+}
+
+}
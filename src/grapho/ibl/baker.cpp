@@ -0,0 +1,546 @@
+#include "baker.h"
+#include "../parallel.h"
+#include "../simd.h"
+#include <algorithm>
+#include <math.h>
+
+namespace grapho {
+namespace ibl {
+
+using simd::Float4;
+
+static const float PI = 3.14159265359f;
+
+struct Vec3
+{
+  float x, y, z;
+};
+
+static Vec3
+operator*(const Vec3& a, float s)
+{
+  return { a.x * s, a.y * s, a.z * s };
+}
+
+static float
+dot(const Vec3& a, const Vec3& b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vec3
+cross(const Vec3& a, const Vec3& b)
+{
+  return {
+    a.y * b.z - a.z * b.y,
+    a.z * b.x - a.x * b.z,
+    a.x * b.y - a.y * b.x,
+  };
+}
+
+static Vec3
+normalize(const Vec3& v)
+{
+  return v * (1.0f / sqrtf(dot(v, v)));
+}
+
+static float
+SrgbToLinear(float c)
+{
+  return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+// direction through the texel center of face (GL cubemap convention)
+static Vec3
+FaceDirection(int face, int x, int y, int size)
+{
+  float sc = 2.0f * (x + 0.5f) / size - 1.0f;
+  float tc = 2.0f * (y + 0.5f) / size - 1.0f;
+  switch (face) {
+    case 0:
+      return normalize({ 1.0f, -tc, -sc });
+    case 1:
+      return normalize({ -1.0f, -tc, sc });
+    case 2:
+      return normalize({ sc, 1.0f, tc });
+    case 3:
+      return normalize({ sc, -1.0f, -tc });
+    case 4:
+      return normalize({ sc, -tc, 1.0f });
+    default:
+      return normalize({ -sc, -tc, -1.0f });
+  }
+}
+
+XMFLOAT3
+CubemapTexelDirection(int face, int x, int y, int size)
+{
+  auto d = FaceDirection(face, x, y, size);
+  return { d.x, d.y, d.z };
+}
+
+// bilinear, clamp to edge
+static Float4
+SampleBilinear(const FloatImage& image, float u, float v)
+{
+  float fx = std::clamp(u * image.Width - 0.5f, 0.0f, image.Width - 1.0f);
+  float fy = std::clamp(v * image.Height - 0.5f, 0.0f, image.Height - 1.0f);
+  int x0 = static_cast<int>(fx);
+  int y0 = static_cast<int>(fy);
+  int x1 = std::min(x0 + 1, image.Width - 1);
+  int y1 = std::min(y0 + 1, image.Height - 1);
+  float tx = fx - x0;
+  float ty = fy - y0;
+
+  auto texel = [&image](int x, int y) {
+    auto p = image.Texel(x, y);
+    return Float4(p[0], p[1], p[2], 0);
+  };
+  auto top = texel(x0, y0) * Float4(1 - tx) + texel(x1, y0) * Float4(tx);
+  auto bottom = texel(x0, y1) * Float4(1 - tx) + texel(x1, y1) * Float4(tx);
+  return top * Float4(1 - ty) + bottom * Float4(ty);
+}
+
+static Float4
+SampleCube(const CubemapImage& cube, const Vec3& d, int level)
+{
+  float ax = fabsf(d.x);
+  float ay = fabsf(d.y);
+  float az = fabsf(d.z);
+  int face;
+  float sc, tc, ma;
+  if (ax >= ay && ax >= az) {
+    face = d.x > 0 ? 0 : 1;
+    sc = d.x > 0 ? -d.z : d.z;
+    tc = -d.y;
+    ma = ax;
+  } else if (ay >= az) {
+    face = d.y > 0 ? 2 : 3;
+    sc = d.x;
+    tc = d.y > 0 ? d.z : -d.z;
+    ma = ay;
+  } else {
+    face = d.z > 0 ? 4 : 5;
+    sc = d.z > 0 ? d.x : -d.x;
+    tc = -d.y;
+    ma = az;
+  }
+  return SampleBilinear(cube.Mips[level][face],
+                        (sc / ma + 1.0f) * 0.5f,
+                        (tc / ma + 1.0f) * 0.5f);
+}
+
+// trilinear
+static Float4
+SampleCubeLod(const CubemapImage& cube, const Vec3& d, float lod)
+{
+  lod = std::clamp(lod, 0.0f, cube.MipCount() - 1.0f);
+  int level = static_cast<int>(lod);
+  float t = lod - level;
+  auto a = SampleCube(cube, d, level);
+  if (t == 0 || level + 1 >= cube.MipCount()) {
+    return a;
+  }
+  auto b = SampleCube(cube, d, level + 1);
+  return a * Float4(1 - t) + b * Float4(t);
+}
+
+static CubemapImage
+AllocateCubemap(int size, int mipCount)
+{
+  CubemapImage cube;
+  cube.Mips.resize(mipCount);
+  for (int mip = 0; mip < mipCount; ++mip) {
+    auto mipSize = std::max(size >> mip, 1);
+    for (auto& face : cube.Mips[mip]) {
+      face = FloatImage(mipSize, mipSize);
+    }
+  }
+  return cube;
+}
+
+struct Rgb
+{
+  Float4 Value;
+  void Store3(float* p) const
+  {
+    p[0] = Value[0];
+    p[1] = Value[1];
+    p[2] = Value[2];
+  }
+};
+
+// fill every texel of every face of one mip. rows are the unit of work.
+template<typename F>
+static void
+ForEachTexel(CubemapImage& cube, int mip, uint32_t threadCount, const F& func)
+{
+  auto size = cube.Mips[mip][0].Width;
+  ParallelFor(
+    6 * size,
+    [&cube, mip, size, &func](uint32_t i) {
+      int face = i / size;
+      int y = i % size;
+      auto& image = cube.Mips[mip][face];
+      for (int x = 0; x < size; ++x) {
+        func(FaceDirection(face, x, y, size)).Store3(image.Texel(x, y));
+      }
+    },
+    threadCount);
+}
+
+// http://holger.dammertz.org/stuff/notes_HammersleyOnHemisphere.html
+static float
+RadicalInverse_VdC(uint32_t bits)
+{
+  bits = (bits << 16u) | (bits >> 16u);
+  bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+  bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+  bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+  bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+  return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+}
+
+// GGX halfway vector around +Z
+static Vec3
+ImportanceSampleGGX(uint32_t i, uint32_t n, float roughness)
+{
+  float a = roughness * roughness;
+  float xi_x = float(i) / float(n);
+  float xi_y = RadicalInverse_VdC(i);
+  float phi = 2.0f * PI * xi_x;
+  float cosTheta = sqrtf((1.0f - xi_y) / (1.0f + (a * a - 1.0f) * xi_y));
+  float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+  return { cosf(phi) * sinTheta, sinf(phi) * sinTheta, cosTheta };
+}
+
+// tangent space sample directions in SoA, padded to 4 with zero weight.
+struct SampleTable
+{
+  std::vector<float> X;
+  std::vector<float> Y;
+  std::vector<float> Z;
+  std::vector<float> Weight;
+  std::vector<float> Lod;
+
+  void Push(const Vec3& d, float weight, float lod = 0)
+  {
+    X.push_back(d.x);
+    Y.push_back(d.y);
+    Z.push_back(d.z);
+    Weight.push_back(weight);
+    Lod.push_back(lod);
+  }
+  void Pad()
+  {
+    while (X.size() % 4) {
+      Push({ 0, 0, 1 }, 0);
+    }
+  }
+  size_t Size() const { return X.size(); }
+
+  // sum(env(tangent frame * sample) * weight)
+  Float4 Integrate(const CubemapImage& env,
+                   const Vec3& t,
+                   const Vec3& b,
+                   const Vec3& n,
+                   bool useLod,
+                   float fixedLod) const
+  {
+    Float4 tx(t.x), ty(t.y), tz(t.z);
+    Float4 bx(b.x), by(b.y), bz(b.z);
+    Float4 nx(n.x), ny(n.y), nz(n.z);
+    Float4 sum(0.0f);
+    alignas(16) float wx[4], wy[4], wz[4];
+    for (size_t i = 0; i < Size(); i += 4) {
+      auto sx = Float4::Load(&X[i]);
+      auto sy = Float4::Load(&Y[i]);
+      auto sz = Float4::Load(&Z[i]);
+      (tx * sx + bx * sy + nx * sz).Store(wx);
+      (ty * sx + by * sy + ny * sz).Store(wy);
+      (tz * sx + bz * sy + nz * sz).Store(wz);
+      for (int j = 0; j < 4; ++j) {
+        auto w = Weight[i + j];
+        if (w <= 0) {
+          continue;
+        }
+        Vec3 d{ wx[j], wy[j], wz[j] };
+        auto color = useLod ? SampleCubeLod(env, d, Lod[i + j])
+                            : SampleCubeLod(env, d, fixedLod);
+        sum += color * Float4(w);
+      }
+    }
+    return sum;
+  }
+};
+
+static Float4
+SampleEquirectangular(const FloatImage& image, const Vec3& d)
+{
+  // equirectangular_to_cubemap_fs.h
+  float u = atan2f(d.z, d.x) * 0.1591f + 0.5f;
+  float v = asinf(std::clamp(d.y, -1.0f, 1.0f)) * 0.3183f + 0.5f;
+  return SampleBilinear(image, u, v);
+}
+
+static std::optional<FloatImage>
+ToFloatImage(const Image& src)
+{
+  if (!src.Pixels || src.Width <= 0 || src.Height <= 0) {
+    return std::nullopt;
+  }
+  FloatImage image(src.Width, src.Height);
+  auto count = src.Width * src.Height;
+  auto dst = image.Pixels.data();
+  switch (src.Format) {
+    case PixelFormat::f16_RGB:
+    case PixelFormat::f32_RGB: {
+      // float pixels. see ImageLoader::LoadHdr
+      auto p = (const float*)src.Pixels;
+      std::copy(p, p + count * 3, dst);
+      return image;
+    }
+
+    case PixelFormat::u8_RGBA:
+    case PixelFormat::u8_RGB:
+    case PixelFormat::u8_R: {
+      int channels = src.Format == PixelFormat::u8_RGBA  ? 4
+                     : src.Format == PixelFormat::u8_RGB ? 3
+                                                         : 1;
+      for (int i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+          float v = src.Pixels[i * channels + std::min(c, channels - 1)] /
+                    255.0f;
+          dst[i * 3 + c] =
+            src.ColorSpace == ColorSpace::sRGB ? SrgbToLinear(v) : v;
+        }
+      }
+      return image;
+    }
+
+    default:
+      return std::nullopt;
+  }
+}
+
+// 2x2 box like glGenerateMipmap
+static void
+Downsample(const FloatImage& src, FloatImage& dst)
+{
+  for (int y = 0; y < dst.Height; ++y) {
+    int y0 = std::min(y * 2, src.Height - 1);
+    int y1 = std::min(y * 2 + 1, src.Height - 1);
+    for (int x = 0; x < dst.Width; ++x) {
+      int x0 = std::min(x * 2, src.Width - 1);
+      int x1 = std::min(x * 2 + 1, src.Width - 1);
+      auto a = src.Texel(x0, y0);
+      auto b = src.Texel(x1, y0);
+      auto c = src.Texel(x0, y1);
+      auto d = src.Texel(x1, y1);
+      auto p = dst.Texel(x, y);
+      for (int i = 0; i < 3; ++i) {
+        p[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+      }
+    }
+  }
+}
+
+std::optional<CubemapImage>
+BakeEnvCubemap(const Image& equirectangular, int size, uint32_t threadCount)
+{
+  auto src = ToFloatImage(equirectangular);
+  if (!src) {
+    return std::nullopt;
+  }
+
+  auto mipCount = FullMipCount(size);
+  auto cube = AllocateCubemap(size, mipCount);
+  ForEachTexel(cube, 0, threadCount, [&src](const Vec3& d) {
+    return Rgb{ SampleEquirectangular(*src, d) };
+  });
+  for (int mip = 1; mip < mipCount; ++mip) {
+    ParallelFor(
+      6,
+      [&cube, mip](uint32_t face) {
+        Downsample(cube.Mips[mip - 1][face], cube.Mips[mip][face]);
+      },
+      threadCount);
+  }
+  return cube;
+}
+
+CubemapImage
+BakeIrradianceMap(const CubemapImage& env,
+                  int size,
+                  float sampleDelta,
+                  uint32_t threadCount)
+{
+  SampleTable samples;
+  for (float phi = 0.0f; phi < 2.0f * PI; phi += sampleDelta) {
+    for (float theta = 0.0f; theta < 0.5f * PI; theta += sampleDelta) {
+      samples.Push(
+        { sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta) },
+        cosf(theta) * sinf(theta));
+    }
+  }
+  auto sampleCount = static_cast<float>(samples.Size());
+  samples.Pad();
+
+  // fetch from the mip that covers one output texel, as the gpu derivative
+  // based lod would.
+  auto lod = log2f(static_cast<float>(env.Size()) / size);
+
+  auto cube = AllocateCubemap(size, 1);
+  ForEachTexel(cube, 0, threadCount, [&](const Vec3& n) {
+    auto right = normalize(cross({ 0, 1, 0 }, n));
+    auto up = normalize(cross(n, right));
+    auto sum = samples.Integrate(env, right, up, n, false, lod);
+    return Rgb{ sum * Float4(PI / sampleCount) };
+  });
+  return cube;
+}
+
+static float
+DistributionGGX(float NdotH, float roughness)
+{
+  float a = roughness * roughness;
+  float a2 = a * a;
+  float NdotH2 = NdotH * NdotH;
+  float denom = (NdotH2 * (a2 - 1.0f) + 1.0f);
+  return a2 / (PI * denom * denom);
+}
+
+CubemapImage
+BakePrefilterMap(const CubemapImage& env,
+                 int size,
+                 int mipCount,
+                 uint32_t sampleCount,
+                 uint32_t threadCount)
+{
+  auto cube = AllocateCubemap(size, mipCount);
+  float resolution = static_cast<float>(env.Size());
+  float saTexel = 4.0f * PI / (6.0f * resolution * resolution);
+  for (int mip = 0; mip < mipCount; ++mip) {
+    float roughness = mipCount > 1 ? (float)mip / (float)(mipCount - 1) : 0;
+
+    // V = R = N. in tangent space the light directions, weights and lods do
+    // not depend on N.
+    SampleTable samples;
+    for (uint32_t i = 0; i < sampleCount; ++i) {
+      auto h = ImportanceSampleGGX(i, sampleCount, roughness);
+      Vec3 l{ 2.0f * h.z * h.x, 2.0f * h.z * h.y, 2.0f * h.z * h.z - 1.0f };
+      float NdotL = l.z;
+      if (NdotL <= 0) {
+        continue;
+      }
+      float D = DistributionGGX(h.z, roughness);
+      float pdf = D * h.z / (4.0f * h.z) + 0.0001f;
+      float saSample = 1.0f / (float(sampleCount) * pdf + 0.0001f);
+      float lod = roughness == 0.0f ? 0.0f : 0.5f * log2f(saSample / saTexel);
+      samples.Push(normalize(l), NdotL, lod);
+    }
+    float totalWeight = 0;
+    for (auto w : samples.Weight) {
+      totalWeight += w;
+    }
+    samples.Pad();
+
+    ForEachTexel(cube, mip, threadCount, [&](const Vec3& n) {
+      Vec3 up = fabsf(n.z) < 0.999f ? Vec3{ 0, 0, 1 } : Vec3{ 1, 0, 0 };
+      auto tangent = normalize(cross(up, n));
+      auto bitangent = cross(n, tangent);
+      auto sum = samples.Integrate(env, tangent, bitangent, n, true, 0);
+      return Rgb{ sum * Float4(1.0f / totalWeight) };
+    });
+  }
+  return cube;
+}
+
+FloatImage
+BakeBrdfLUT(int size, uint32_t sampleCount, uint32_t threadCount)
+{
+  FloatImage lut(size, size);
+  auto padded = (sampleCount + 3) / 4 * 4;
+  ParallelFor(
+    size,
+    [&lut, size, sampleCount, padded](uint32_t y) {
+      float roughness = (y + 0.5f) / size;
+
+      // halfway vectors for this row. N = +Z, so ImportanceSampleGGX's
+      // tangent frame is (0,-1,0), (1,0,0).
+      std::vector<float> hx(padded), hy(padded), hz(padded), mask(padded);
+      for (uint32_t i = 0; i < padded; ++i) {
+        if (i < sampleCount) {
+          auto h = ImportanceSampleGGX(i, sampleCount, roughness);
+          hx[i] = h.y;
+          hy[i] = -h.x;
+          hz[i] = h.z;
+          mask[i] = 1;
+        } else {
+          hz[i] = 1;
+        }
+      }
+
+      // IBL k
+      Float4 k(roughness * roughness / 2.0f);
+      Float4 zero(0.0f);
+      Float4 one(1.0f);
+      for (int x = 0; x < size; ++x) {
+        float NdotV = (x + 0.5f) / size;
+        Float4 vx(sqrtf(1.0f - NdotV * NdotV));
+        Float4 vz(NdotV);
+        auto ggxV = vz / (vz * (one - k) + k);
+        Float4 a(0.0f);
+        Float4 b(0.0f);
+        for (uint32_t i = 0; i < padded; i += 4) {
+          auto h_x = Float4::Load(&hx[i]);
+          auto h_z = Float4::Load(&hz[i]);
+          auto VdotH = Max(vx * h_x + vz * h_z, zero);
+          auto NdotL = Max(Float4(2.0f) * VdotH * h_z - vz, zero);
+          auto ggxL = NdotL / (NdotL * (one - k) + k);
+          // G is 0 when NdotL is 0, so no branch is needed
+          auto G_Vis = ggxL * ggxV * VdotH / (h_z * vz) *
+                       Float4::Load(&mask[i]);
+          auto f = one - VdotH;
+          auto f2 = f * f;
+          auto Fc = f2 * f2 * f;
+          a += (one - Fc) * G_Vis;
+          b += Fc * G_Vis;
+        }
+        auto p = lut.Texel(x, y);
+        p[0] = (a[0] + a[1] + a[2] + a[3]) / sampleCount;
+        p[1] = (b[0] + b[1] + b[2] + b[3]) / sampleCount;
+        p[2] = 0;
+      }
+    },
+    threadCount);
+  return lut;
+}
+
+std::optional<BakedPbrEnv>
+BakePbrEnv(const Image& equirectangular, const BakeSettings& settings)
+{
+  auto env =
+    BakeEnvCubemap(equirectangular, settings.EnvSize, settings.ThreadCount);
+  if (!env) {
+    return std::nullopt;
+  }
+
+  BakedPbrEnv baked;
+  baked.IrradianceMap = BakeIrradianceMap(*env,
+                                          settings.IrradianceSize,
+                                          settings.IrradianceSampleDelta,
+                                          settings.ThreadCount);
+  baked.PrefilterMap = BakePrefilterMap(*env,
+                                        settings.PrefilterSize,
+                                        settings.PrefilterMipCount,
+                                        settings.PrefilterSampleCount,
+                                        settings.ThreadCount);
+  baked.BrdfLUT = BakeBrdfLUT(
+    settings.BrdfLutSize, settings.BrdfSampleCount, settings.ThreadCount);
+  baked.EnvCubemap = std::move(*env);
+  return baked;
+}
+
+}
+}
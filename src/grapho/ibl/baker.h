@@ -0,0 +1,124 @@
+#pragma once
+#include "../image.h"
+#include "../vertexlayout.h"
+#include <array>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace ibl {
+
+// rgb float pixels. row 0 first, same order as glTexImage2D.
+struct FloatImage
+{
+  int Width = 0;
+  int Height = 0;
+  std::vector<float> Pixels;
+
+  FloatImage() {}
+  FloatImage(int width, int height)
+    : Width(width)
+    , Height(height)
+    , Pixels(width * height * 3)
+  {
+  }
+  float* Texel(int x, int y) { return Pixels.data() + (y * Width + x) * 3; }
+  const float* Texel(int x, int y) const
+  {
+    return Pixels.data() + (y * Width + x) * 3;
+  }
+
+  // float pixels for Texture::Create(image, true).
+  // format is the gpu side storage, f16_RGB like the hdr texture.
+  Image ToImage(PixelFormat format = PixelFormat::f16_RGB) const
+  {
+    return {
+      Width,
+      Height,
+      format,
+      ColorSpace::Linear,
+      (const uint8_t*)Pixels.data(),
+    };
+  }
+};
+
+// Mips[level][face]. face order is GL_TEXTURE_CUBE_MAP_POSITIVE_X + i.
+struct CubemapImage
+{
+  std::vector<std::array<FloatImage, 6>> Mips;
+
+  int Size() const { return Mips.empty() ? 0 : Mips[0][0].Width; }
+  int MipCount() const { return static_cast<int>(Mips.size()); }
+};
+
+// normalized direction through the texel center. GL cubemap convention.
+XMFLOAT3
+CubemapTexelDirection(int face, int x, int y, int size);
+
+// 1 + log2(size)
+inline int
+FullMipCount(int size)
+{
+  int count = 1;
+  while ((size >> count) > 0) {
+    ++count;
+  }
+  return count;
+}
+
+// defaults match the gl3 PbrEnv render passes.
+struct BakeSettings
+{
+  int EnvSize = 512;
+  int IrradianceSize = 32;
+  float IrradianceSampleDelta = 0.025f;
+  int PrefilterSize = 128;
+  int PrefilterMipCount = 5;
+  uint32_t PrefilterSampleCount = 1024;
+  int BrdfLutSize = 512;
+  uint32_t BrdfSampleCount = 1024;
+  // 0: std::thread::hardware_concurrency
+  uint32_t ThreadCount = 0;
+};
+
+struct BakedPbrEnv
+{
+  CubemapImage EnvCubemap;
+  CubemapImage IrradianceMap;
+  CubemapImage PrefilterMap;
+  // r: scale, g: bias, b: 0
+  FloatImage BrdfLUT;
+};
+
+// equirectangular to cubemap with a full box filtered mip chain.
+// u8 and float rgb images. float pixels as stbi_loadf.
+std::optional<CubemapImage>
+BakeEnvCubemap(const Image& equirectangular,
+               int size,
+               uint32_t threadCount = 0);
+
+// diffuse irradiance. irradiance_convolution_fs.h
+CubemapImage
+BakeIrradianceMap(const CubemapImage& env,
+                  int size,
+                  float sampleDelta = 0.025f,
+                  uint32_t threadCount = 0);
+
+// specular prefilter. roughness = mip / (mipCount - 1). prefilter_fs.h
+CubemapImage
+BakePrefilterMap(const CubemapImage& env,
+                 int size,
+                 int mipCount = 5,
+                 uint32_t sampleCount = 1024,
+                 uint32_t threadCount = 0);
+
+// split sum brdf. x: NdotV, y: roughness. brdf_fs.h
+FloatImage
+BakeBrdfLUT(int size, uint32_t sampleCount = 1024, uint32_t threadCount = 0);
+
+std::optional<BakedPbrEnv>
+BakePbrEnv(const Image& equirectangular, const BakeSettings& settings = {});
+
+}
+}
@@ -0,0 +1,174 @@
+#include "cache.h"
+#include "../hash.h"
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+#include <vector>
+
+namespace grapho {
+namespace ibl {
+
+uint64_t
+CacheKey(const Image& hdr, const BakeSettings& settings, uint32_t variant)
+{
+  auto hash = HashValue(CACHE_VERSION);
+  hash = HashValue(hdr.Width, hash);
+  hash = HashValue(hdr.Height, hash);
+  hash = HashValue(hdr.Format, hash);
+  hash = HashValue(hdr.ColorSpace, hash);
+  if (hdr.Pixels) {
+    hash = HashBytes(
+      hdr.Pixels, hdr.Width * hdr.Height * BytesPerPixel(hdr.Format), hash);
+  }
+  hash = HashValue(settings.EnvSize, hash);
+  hash = HashValue(settings.IrradianceSize, hash);
+  hash = HashValue(settings.IrradianceSampleDelta, hash);
+  hash = HashValue(settings.PrefilterSize, hash);
+  hash = HashValue(settings.PrefilterMipCount, hash);
+  hash = HashValue(settings.PrefilterSampleCount, hash);
+  hash = HashValue(settings.BrdfLutSize, hash);
+  hash = HashValue(settings.BrdfSampleCount, hash);
+  hash = HashValue(variant, hash);
+  return hash;
+}
+
+std::string
+CacheFileName(uint64_t key)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%016llx.pbrenv", (unsigned long long)key);
+  return buf;
+}
+
+static uint32_t
+FullLevelCount(uint32_t width, uint32_t height)
+{
+  uint32_t levels = 1;
+  while ((std::max(width, height) >> levels) > 0) {
+    ++levels;
+  }
+  return levels;
+}
+
+static uint64_t
+Align16(uint64_t offset)
+{
+  return (offset + 15) & ~15ull;
+}
+
+bool
+WriteCache(const std::string& path, uint64_t key, const BakedPbrEnv& baked)
+{
+  std::vector<CacheEntry> entries;
+  std::vector<const FloatImage*> images;
+  auto push = [&entries, &images](CacheMap map,
+                                  uint32_t face,
+                                  uint32_t mip,
+                                  const FloatImage& image) {
+    entries.push_back({
+      .Map = map,
+      .Face = face,
+      .Mip = mip,
+      .Width = static_cast<uint32_t>(image.Width),
+      .Height = static_cast<uint32_t>(image.Height),
+      .Format = PixelFormat::f32_RGB,
+      .Size = image.Pixels.size() * sizeof(float),
+    });
+    images.push_back(&image);
+  };
+  auto pushCube = [&push](CacheMap map, const CubemapImage& cube) {
+    for (uint32_t mip = 0; mip < cube.Mips.size(); ++mip) {
+      for (uint32_t face = 0; face < 6; ++face) {
+        push(map, face, mip, cube.Mips[mip][face]);
+      }
+    }
+  };
+  pushCube(CacheMap::EnvCubemap, baked.EnvCubemap);
+  pushCube(CacheMap::IrradianceMap, baked.IrradianceMap);
+  pushCube(CacheMap::PrefilterMap, baked.PrefilterMap);
+  push(CacheMap::BrdfLUT, 0, 0, baked.BrdfLUT);
+
+  auto offset =
+    Align16(sizeof(CacheHeader) + sizeof(CacheEntry) * entries.size());
+  for (auto& entry : entries) {
+    entry.Offset = offset;
+    offset = Align16(offset + entry.Size);
+  }
+
+  // write to a temporary and rename, so a reader never maps a partial file
+  auto tmp = path + ".tmp";
+  {
+    std::ofstream os(tmp, std::ios::binary);
+    if (!os) {
+      return false;
+    }
+    CacheHeader header{
+      .Magic = CACHE_MAGIC,
+      .Version = CACHE_VERSION,
+      .Key = key,
+      .EntryCount = static_cast<uint32_t>(entries.size()),
+    };
+    os.write((const char*)&header, sizeof(header));
+    os.write((const char*)entries.data(), sizeof(CacheEntry) * entries.size());
+    uint64_t pos = sizeof(header) + sizeof(CacheEntry) * entries.size();
+    const char zero[16] = {};
+    for (size_t i = 0; i < entries.size(); ++i) {
+      os.write(zero, entries[i].Offset - pos);
+      os.write((const char*)images[i]->Pixels.data(), entries[i].Size);
+      pos = entries[i].Offset + entries[i].Size;
+    }
+    if (!os) {
+      return false;
+    }
+  }
+  remove(path.c_str());
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+std::optional<CacheView>
+OpenCache(const std::string& path, uint64_t key)
+{
+  auto file = MappedFile::Open(path);
+  if (!file || file->Size() < sizeof(CacheHeader)) {
+    return std::nullopt;
+  }
+  auto header = (const CacheHeader*)file->Data();
+  if (header->Magic != CACHE_MAGIC || header->Version != CACHE_VERSION ||
+      header->Key != key) {
+    return std::nullopt;
+  }
+  if (sizeof(CacheHeader) + sizeof(CacheEntry) * header->EntryCount >
+      file->Size()) {
+    return std::nullopt;
+  }
+  std::span<const CacheEntry> entries{
+    (const CacheEntry*)(file->Data() + sizeof(CacheHeader)),
+    header->EntryCount,
+  };
+  // level 0 of each map
+  const CacheEntry* bases[4] = {};
+  for (auto& entry : entries) {
+    if (static_cast<uint32_t>(entry.Map) > 3 ||
+        entry.Format != PixelFormat::f32_RGB ||
+        entry.Size != uint64_t(entry.Width) * entry.Height * 12 ||
+        entry.Offset > file->Size() ||
+        entry.Size > file->Size() - entry.Offset) {
+      return std::nullopt;
+    }
+    if (entry.Mip == 0) {
+      bases[static_cast<uint32_t>(entry.Map)] = &entry;
+    }
+  }
+  for (auto& entry : entries) {
+    auto base = bases[static_cast<uint32_t>(entry.Map)];
+    if (!base || entry.Face >= 6 ||
+        (entry.Map == CacheMap::BrdfLUT && entry.Face != 0) ||
+        entry.Mip >= FullLevelCount(base->Width, base->Height)) {
+      return std::nullopt;
+    }
+  }
+  return CacheView{ file, entries };
+}
+
+}
+}
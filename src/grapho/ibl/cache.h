@@ -0,0 +1,110 @@
+#pragma once
+#include "../mappedfile.h"
+#include "baker.h"
+#include <optional>
+#include <span>
+#include <string>
+
+namespace grapho {
+namespace ibl {
+
+// file layout
+//
+// CacheHeader
+// CacheEntry[EntryCount]
+// pixels. each entry 16 byte aligned at Offset from the file head.
+//
+// pixels are rgb float, row 0 first. can be passed to glTexImage2D as is.
+
+const uint32_t CACHE_MAGIC = 0x52425047; // "GPBR"
+const uint32_t CACHE_VERSION = 1;
+
+enum class CacheMap : uint32_t
+{
+  EnvCubemap,
+  IrradianceMap,
+  PrefilterMap,
+  BrdfLUT,
+};
+
+struct CacheHeader
+{
+  uint32_t Magic;
+  uint32_t Version;
+  uint64_t Key;
+  uint32_t EntryCount;
+  uint32_t Reserved;
+};
+static_assert(sizeof(CacheHeader) == 24);
+
+struct CacheEntry
+{
+  CacheMap Map;
+  // 0 for BrdfLUT
+  uint32_t Face;
+  uint32_t Mip;
+  uint32_t Width;
+  uint32_t Height;
+  // f32_RGB
+  PixelFormat Format;
+  uint64_t Offset;
+  uint64_t Size;
+};
+static_assert(sizeof(CacheEntry) == 40);
+
+// hash of the hdr pixels, the bake settings and variant. variant tells
+// apart the files of the same hdr that hold different maps, e.g. the
+// gl3::PbrIrradiance of the PbrEnv
+uint64_t
+CacheKey(const Image& hdr,
+         const BakeSettings& settings = {},
+         uint32_t variant = 0);
+
+std::string
+CacheFileName(uint64_t key);
+
+bool
+WriteCache(const std::string& path, uint64_t key, const BakedPbrEnv& baked);
+
+struct CacheView
+{
+  std::shared_ptr<MappedFile> File;
+  std::span<const CacheEntry> Entries;
+
+  const float* Pixels(const CacheEntry& entry) const
+  {
+    return (const float*)(File->Data() + entry.Offset);
+  }
+
+  Image ToImage(const CacheEntry& entry,
+                PixelFormat format = PixelFormat::f16_RGB) const
+  {
+    return {
+      static_cast<int>(entry.Width),
+      static_cast<int>(entry.Height),
+      format,
+      ColorSpace::Linear,
+      (const uint8_t*)Pixels(entry),
+    };
+  }
+
+  // number of mips stored for map
+  uint32_t MipCount(CacheMap map) const
+  {
+    uint32_t count = 0;
+    for (auto& entry : Entries) {
+      if (entry.Map == map && entry.Mip + 1 > count) {
+        count = entry.Mip + 1;
+      }
+    }
+    return count;
+  }
+};
+
+// nullopt if missing, broken or the key does not match. every entry range,
+// face and mip is checked
+std::optional<CacheView>
+OpenCache(const std::string& path, uint64_t key);
+
+}
+}
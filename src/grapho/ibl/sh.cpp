@@ -0,0 +1,147 @@
+#include "sh.h"
+#include "../parallel.h"
+#include "../simd.h"
+#include <math.h>
+#include <vector>
+
+namespace grapho {
+namespace ibl {
+
+using simd::Float4;
+
+// A_l / PI. cosine lobe convolution, divided by PI as the irradiance map
+static const float BAND_FACTOR[3] = { 1.0f, 2.0f / 3.0f, 1.0f / 4.0f };
+
+// area of the projection of [0, x] x [0, y] on the unit sphere
+static float
+AreaElement(float x, float y)
+{
+  return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+}
+
+static float
+TexelSolidAngle(int x, int y, int size)
+{
+  float inv = 1.0f / size;
+  float x0 = 2.0f * x * inv - 1.0f;
+  float y0 = 2.0f * y * inv - 1.0f;
+  float x1 = x0 + 2.0f * inv;
+  float y1 = y0 + 2.0f * inv;
+  return AreaElement(x0, y0) - AreaElement(x0, y1) - AreaElement(x1, y0) +
+         AreaElement(x1, y1);
+}
+
+// real SH basis up to l = 2
+static void
+Basis(const XMFLOAT3& n, float y[9])
+{
+  y[0] = 0.282095f;
+  y[1] = 0.488603f * n.y;
+  y[2] = 0.488603f * n.z;
+  y[3] = 0.488603f * n.x;
+  y[4] = 1.092548f * n.x * n.y;
+  y[5] = 1.092548f * n.y * n.z;
+  y[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+  y[7] = 1.092548f * n.x * n.z;
+  y[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+}
+
+// basis constant and band factor, folded into the coefficients
+static const float SCALE[9] = {
+  0.282095f * BAND_FACTOR[0], 0.488603f * BAND_FACTOR[1],
+  0.488603f * BAND_FACTOR[1], 0.488603f * BAND_FACTOR[1],
+  1.092548f * BAND_FACTOR[2], 1.092548f * BAND_FACTOR[2],
+  0.315392f * BAND_FACTOR[2], 1.092548f * BAND_FACTOR[2],
+  0.546274f * BAND_FACTOR[2],
+};
+
+XMFLOAT3
+SH9::Evaluate(const XMFLOAT3& n) const
+{
+  float poly[9] = {
+    1.0f,
+    n.y,
+    n.z,
+    n.x,
+    n.x * n.y,
+    n.y * n.z,
+    3.0f * n.z * n.z - 1.0f,
+    n.x * n.z,
+    n.x * n.x - n.y * n.y,
+  };
+  XMFLOAT3 result = { 0, 0, 0 };
+  for (int i = 0; i < 9; ++i) {
+    result.x += Coefficients[i].x * poly[i];
+    result.y += Coefficients[i].y * poly[i];
+    result.z += Coefficients[i].z * poly[i];
+  }
+  return result;
+}
+
+SH9
+ProjectSH9(const float* const faces[6], int size, uint32_t threadCount)
+{
+  // partial sum per row, then reduce. keeps the result deterministic.
+  struct Row
+  {
+    Float4 Sum[9];
+  };
+  std::vector<Row> rows(6 * size);
+  ParallelFor(
+    static_cast<uint32_t>(rows.size()),
+    [faces, size, &rows](uint32_t i) {
+      int face = i / size;
+      int y = i % size;
+      auto& row = rows[i];
+      for (auto& sum : row.Sum) {
+        sum = Float4(0);
+      }
+      auto src = faces[face] + y * size * 3;
+      for (int x = 0; x < size; ++x, src += 3) {
+        auto n = CubemapTexelDirection(face, x, y, size);
+        float basis[9];
+        Basis(n, basis);
+        auto weight = Float4(TexelSolidAngle(x, y, size));
+        auto radiance = Float4(src[0], src[1], src[2], 0) * weight;
+        for (int k = 0; k < 9; ++k) {
+          row.Sum[k] += radiance * Float4(basis[k]);
+        }
+      }
+    },
+    threadCount);
+
+  Float4 sum[9];
+  for (auto& s : sum) {
+    s = Float4(0);
+  }
+  for (auto& row : rows) {
+    for (int k = 0; k < 9; ++k) {
+      sum[k] += row.Sum[k];
+    }
+  }
+
+  SH9 sh;
+  for (int k = 0; k < 9; ++k) {
+    auto c = sum[k] * Float4(SCALE[k]);
+    sh.Coefficients[k] = { c[0], c[1], c[2], 0 };
+  }
+  return sh;
+}
+
+SH9
+ProjectSH9(const CubemapImage& env, int maxSize, uint32_t threadCount)
+{
+  int mip = 0;
+  while (mip + 1 < env.MipCount() && env.Mips[mip][0].Width > maxSize) {
+    ++mip;
+  }
+  auto& level = env.Mips[mip];
+  const float* faces[6];
+  for (int i = 0; i < 6; ++i) {
+    faces[i] = level[i].Pixels.data();
+  }
+  return ProjectSH9(faces, level[0].Width, threadCount);
+}
+
+}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "baker.h"
+
+namespace grapho {
+namespace ibl {
+
+// L2 spherical harmonics irradiance. layout of std140 vec4[9].
+//
+// Coefficients are already multiplied by the cosine lobe (A_l / PI) and the
+// basis constants, so the same value as the irradiance cubemap is
+//
+// c[0]
+// + c[1] * n.y + c[2] * n.z + c[3] * n.x
+// + c[4] * n.x * n.y + c[5] * n.y * n.z + c[6] * (3 * n.z * n.z - 1)
+// + c[7] * n.x * n.z + c[8] * (n.x * n.x - n.y * n.y)
+struct SH9
+{
+  // rgb, w is 0
+  XMFLOAT4 Coefficients[9];
+
+  XMFLOAT3 Evaluate(const XMFLOAT3& n) const;
+};
+static_assert(sizeof(SH9) == 144);
+
+// faces: GL_TEXTURE_CUBE_MAP_POSITIVE_X + i order, rgb float, size x size
+SH9
+ProjectSH9(const float* const faces[6], int size, uint32_t threadCount = 0);
+
+// uses the first mip not larger than maxSize. irradiance is low frequency.
+SH9
+ProjectSH9(const CubemapImage& env, int maxSize = 32, uint32_t threadCount = 0);
+
+}
+}
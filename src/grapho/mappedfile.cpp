@@ -0,0 +1,95 @@
+#include "mappedfile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace grapho {
+
+#ifdef _WIN32
+
+MappedFile::~MappedFile()
+{
+  if (m_data) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping) {
+    CloseHandle(m_mapping);
+  }
+  if (m_file && m_file != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_file);
+  }
+}
+
+std::shared_ptr<MappedFile>
+MappedFile::Open(const std::string& path)
+{
+  auto ptr = std::shared_ptr<MappedFile>(new MappedFile);
+  ptr->m_file = CreateFileA(path.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (ptr->m_file == INVALID_HANDLE_VALUE) {
+    return {};
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(ptr->m_file, &size) || size.QuadPart == 0) {
+    return {};
+  }
+  ptr->m_size = static_cast<size_t>(size.QuadPart);
+  ptr->m_mapping =
+    CreateFileMappingA(ptr->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!ptr->m_mapping) {
+    return {};
+  }
+  ptr->m_data =
+    (const uint8_t*)MapViewOfFile(ptr->m_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!ptr->m_data) {
+    return {};
+  }
+  return ptr;
+}
+
+#else
+
+MappedFile::~MappedFile()
+{
+  if (m_data) {
+    munmap((void*)m_data, m_size);
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+}
+
+std::shared_ptr<MappedFile>
+MappedFile::Open(const std::string& path)
+{
+  auto ptr = std::shared_ptr<MappedFile>(new MappedFile);
+  ptr->m_fd = open(path.c_str(), O_RDONLY);
+  if (ptr->m_fd < 0) {
+    return {};
+  }
+  struct stat st;
+  if (fstat(ptr->m_fd, &st) != 0 || st.st_size == 0) {
+    return {};
+  }
+  ptr->m_size = static_cast<size_t>(st.st_size);
+  auto data = mmap(nullptr, ptr->m_size, PROT_READ, MAP_PRIVATE, ptr->m_fd, 0);
+  if (data == MAP_FAILED) {
+    return {};
+  }
+  ptr->m_data = (const uint8_t*)data;
+  return ptr;
+}
+
+#endif
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace grapho {
+
+// read only memory map of a whole file
+class MappedFile
+{
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#else
+  int m_fd = -1;
+#endif
+
+  MappedFile() {}
+
+public:
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  static std::shared_ptr<MappedFile> Open(const std::string& path);
+
+  const uint8_t* Data() const { return m_data; }
+  size_t Size() const { return m_size; }
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "vertexlayout.h"
 #include <memory>
+#include <stddef.h>
 #include <vector>
 #include <cmath>
 
@@ -49,63 +50,63 @@ inline VertexLayout Vertex::Layouts[3] = {
   },
 };
 
-inline std::shared_ptr<Mesh>
-Sphere()
+// Tangent.w is the bitangent sign. B = Tangent.w * cross(Normal, Tangent.xyz)
+struct TangentVertex
 {
-  std::vector<XMFLOAT3> positions;
-  std::vector<XMFLOAT2> uv;
-  std::vector<XMFLOAT3> normals;
-  const unsigned int X_SEGMENTS = 64;
-  const unsigned int Y_SEGMENTS = 64;
-  const float PI = 3.14159265359f;
-  for (unsigned int x = 0; x <= X_SEGMENTS; ++x) {
-    for (unsigned int y = 0; y <= Y_SEGMENTS; ++y) {
-      float xSegment = (float)x / (float)X_SEGMENTS;
-      float ySegment = (float)y / (float)Y_SEGMENTS;
-      float xPos = std::cos(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-      float yPos = std::cos(ySegment * PI);
-      float zPos = std::sin(xSegment * 2.0f * PI) * std::sin(ySegment * PI);
-      positions.push_back({ xPos, yPos, zPos });
-      uv.push_back({ xSegment, ySegment });
-      normals.push_back({ xPos, yPos, zPos });
-    }
-  }
+  XMFLOAT3 Position;
+  XMFLOAT3 Normal;
+  XMFLOAT2 Uv;
+  XMFLOAT4 Tangent;
 
-  bool oddRow = false;
-  std::vector<uint16_t> indices;
-  for (unsigned int y = 0; y < Y_SEGMENTS; ++y) {
-    if (!oddRow) // even rows: y == 0, y == 2; and so on
-    {
-      for (unsigned int x = 0; x <= X_SEGMENTS; ++x) {
-        indices.push_back(y * (X_SEGMENTS + 1) + x);
-        indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-      }
-    } else {
-      for (int x = X_SEGMENTS; x >= 0; --x) {
-        indices.push_back((y + 1) * (X_SEGMENTS + 1) + x);
-        indices.push_back(y * (X_SEGMENTS + 1) + x);
-      }
-    }
-    oddRow = !oddRow;
-  }
+  static VertexLayout Layouts[4];
+};
 
-  std::vector<Vertex> vertices;
-  for (unsigned int i = 0; i < positions.size(); ++i) {
-    vertices.push_back({
-      positions[i],
-      normals[i],
-      uv[i],
-    });
-  }
+inline VertexLayout TangentVertex::Layouts[4] = {
+  {
+    .Id = {
+     .AttributeLocation=0,
+     .Slot=0,
+    },
+    .Type = grapho::ValueType::Float,
+    .Count = 3,
+    .Offset = offsetof(TangentVertex, Position),
+    .Stride = sizeof(TangentVertex),
+  },
+  {
+    .Id = {
+     .AttributeLocation=1,
+     .Slot=0,
+    },
+    .Type = grapho::ValueType::Float,
+    .Count = 3,
+    .Offset = offsetof(TangentVertex, Normal),
+    .Stride = sizeof(TangentVertex),
+  },
+  {
+    .Id = {
+     .AttributeLocation=2,
+     .Slot=0,
+    },
+    .Type = grapho::ValueType::Float,
+    .Count = 2,
+    .Offset = offsetof(TangentVertex, Uv),
+    .Stride = sizeof(TangentVertex),
+  },
+  {
+    .Id = {
+     .AttributeLocation=3,
+     .Slot=0,
+    },
+    .Type = grapho::ValueType::Float,
+    .Count = 4,
+    .Offset = offsetof(TangentVertex, Tangent),
+    .Stride = sizeof(TangentVertex),
+  },
+};
 
-  auto ptr = std::make_shared<Mesh>();
-  ptr->Layouts.assign(Vertex::Layouts,
-                      Vertex::Layouts + std::size(Vertex::Layouts));
-  ptr->Vertices.Assign(vertices);
-  ptr->Indices.Assign(indices);
-  ptr->Mode = DrawMode::TriangleStrip;
-  return ptr;
-}
+// y up, 64x64 uv sphere. see meshgenerator.h for the other shapes.
+std::shared_ptr<Mesh>
+Sphere();
 
 inline std::shared_ptr<Mesh>
 Cube(float s = 1.0f)
@@ -0,0 +1,475 @@
+#include "meshgenerator.h"
+#include "mesh.h"
+#include <math.h>
+#include <string.h>
+
+namespace grapho {
+namespace mesh {
+
+static const float PI = 3.14159265359f;
+
+struct Sample
+{
+  XMFLOAT3 Position;
+  XMFLOAT3 Normal;
+  XMFLOAT2 Uv;
+  // dP/du and dP/dv in the texture space. need not be normalized.
+  XMFLOAT3 Tangent;
+  XMFLOAT3 Bitangent;
+};
+
+static XMFLOAT3
+Sub(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+  return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static float
+Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static XMFLOAT3
+Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+{
+  return {
+    a.y * b.z - a.z * b.y,
+    a.z * b.x - a.x * b.z,
+    a.x * b.y - a.y * b.x,
+  };
+}
+
+// Gram-Schmidt against the normal and the handedness in w
+static XMFLOAT4
+OrthogonalTangent(const Sample& s)
+{
+  auto& n = s.Normal;
+  auto d = Dot(n, s.Tangent);
+  XMFLOAT3 t = {
+    s.Tangent.x - n.x * d,
+    s.Tangent.y - n.y * d,
+    s.Tangent.z - n.z * d,
+  };
+  auto len = sqrtf(Dot(t, t));
+  if (len > 0) {
+    t = { t.x / len, t.y / len, t.z / len };
+  }
+  float w = Dot(Cross(n, t), s.Bitangent) < 0 ? -1.0f : 1.0f;
+  return { t.x, t.y, t.z, w };
+}
+
+class Writer
+{
+  bool m_tangents;
+  uint8_t* m_vertices;
+  uint8_t* m_indices;
+  uint32_t m_indexStride;
+  uint32_t m_baseVertex;
+
+public:
+  Writer(bool tangents,
+         uint8_t* vertices,
+         uint8_t* indices,
+         uint32_t indexStride,
+         uint32_t baseVertex)
+    : m_tangents(tangents)
+    , m_vertices(vertices)
+    , m_indices(indices)
+    , m_indexStride(indexStride)
+    , m_baseVertex(baseVertex)
+  {
+  }
+
+  // index of the next vertex
+  uint32_t Base() const { return m_baseVertex; }
+
+  void Push(const Sample& s)
+  {
+    if (m_tangents) {
+      TangentVertex v{ s.Position, s.Normal, s.Uv, OrthogonalTangent(s) };
+      memcpy(m_vertices, &v, sizeof(v));
+      m_vertices += sizeof(v);
+    } else {
+      Vertex v{ s.Position, s.Normal, s.Uv };
+      memcpy(m_vertices, &v, sizeof(v));
+      m_vertices += sizeof(v);
+    }
+    ++m_baseVertex;
+  }
+
+  void Index(uint32_t i)
+  {
+    if (m_indexStride == 2) {
+      auto value = static_cast<uint16_t>(i);
+      memcpy(m_indices, &value, 2);
+    } else {
+      memcpy(m_indices, &i, 4);
+    }
+    m_indices += m_indexStride;
+  }
+
+  void Triangle(uint32_t a, uint32_t b, uint32_t c)
+  {
+    Index(a);
+    Index(b);
+    Index(c);
+  }
+};
+
+// a pole row collapses to a point. its degenerate triangles are skipped.
+struct Grid
+{
+  uint32_t Columns;
+  uint32_t Rows;
+  bool PoleStart = false;
+  bool PoleEnd = false;
+
+  ShapeSize Size() const
+  {
+    uint32_t poles = (PoleStart ? 1 : 0) + (PoleEnd ? 1 : 0);
+    return {
+      (Columns + 1) * (Rows + 1),
+      Columns * (Rows * 6 - poles * 3),
+    };
+  }
+
+  template<typename F>
+  void Write(Writer& w, const F& sample) const
+  {
+    // winding from the quad diagonals around the center. robust to a
+    // collapsed edge.
+    auto c = Columns / 2;
+    auto r = Rows / 2;
+    auto s00 = sample(c, r);
+    auto p11 = sample(c + 1, r + 1).Position;
+    auto p01 = sample(c, r + 1).Position;
+    auto p10 = sample(c + 1, r).Position;
+    auto n = Cross(Sub(p11, s00.Position), Sub(p01, p10));
+    bool flip = Dot(n, s00.Normal) < 0;
+
+    auto base = w.Base();
+    for (uint32_t y = 0; y <= Rows; ++y) {
+      for (uint32_t x = 0; x <= Columns; ++x) {
+        w.Push(sample(x, y));
+      }
+    }
+    auto tri = [&w, flip](uint32_t a, uint32_t b, uint32_t c) {
+      if (flip) {
+        w.Triangle(a, c, b);
+      } else {
+        w.Triangle(a, b, c);
+      }
+    };
+    for (uint32_t y = 0; y < Rows; ++y) {
+      for (uint32_t x = 0; x < Columns; ++x) {
+        auto i00 = base + y * (Columns + 1) + x;
+        auto i10 = i00 + 1;
+        auto i01 = i00 + Columns + 1;
+        auto i11 = i01 + 1;
+        if (!(PoleStart && y == 0)) {
+          tri(i00, i10, i11);
+        }
+        if (!(PoleEnd && y == Rows - 1)) {
+          tri(i00, i11, i01);
+        }
+      }
+    }
+  }
+};
+
+uint32_t
+GeneratedVertexStride(bool tangents)
+{
+  return tangents ? sizeof(TangentVertex) : sizeof(Vertex);
+}
+
+void
+SetGeneratedLayouts(Mesh& mesh, bool tangents)
+{
+  if (tangents) {
+    mesh.Layouts.assign(std::begin(TangentVertex::Layouts),
+                        std::end(TangentVertex::Layouts));
+  } else {
+    mesh.Layouts.assign(std::begin(Vertex::Layouts),
+                        std::end(Vertex::Layouts));
+  }
+}
+
+//
+// sphere
+//
+std::shared_ptr<Mesh>
+Sphere()
+{
+  return Generate(SphereShape{});
+}
+
+static Grid
+SphereGrid(const SphereShape& shape)
+{
+  return { shape.Slices, shape.Stacks, true, true };
+}
+
+ShapeSize
+Measure(const SphereShape& shape)
+{
+  return SphereGrid(shape).Size();
+}
+
+void
+Write(const SphereShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex)
+{
+  Writer w(tangents, vertices, indices, indexStride, baseVertex);
+  auto grid = SphereGrid(shape);
+  grid.Write(w, [&shape, &grid](uint32_t x, uint32_t y) {
+    float u = (float)x / grid.Columns;
+    float v = (float)y / grid.Rows;
+    float phi = u * 2.0f * PI;
+    float theta = v * PI;
+    XMFLOAT3 n = {
+      cosf(phi) * sinf(theta),
+      cosf(theta),
+      sinf(phi) * sinf(theta),
+    };
+    return Sample{
+      { n.x * shape.Radius, n.y * shape.Radius, n.z * shape.Radius },
+      n,
+      { u, v },
+      { -sinf(phi), 0, cosf(phi) },
+      { cosf(phi) * cosf(theta), -sinf(theta), sinf(phi) * cosf(theta) },
+    };
+  });
+}
+
+//
+// plane
+//
+static Grid
+PlaneGrid(const PlaneShape& shape)
+{
+  return { shape.Columns, shape.Rows };
+}
+
+ShapeSize
+Measure(const PlaneShape& shape)
+{
+  return PlaneGrid(shape).Size();
+}
+
+void
+Write(const PlaneShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex)
+{
+  Writer w(tangents, vertices, indices, indexStride, baseVertex);
+  auto grid = PlaneGrid(shape);
+  grid.Write(w, [&shape, &grid](uint32_t x, uint32_t y) {
+    float u = (float)x / grid.Columns;
+    float v = (float)y / grid.Rows;
+    return Sample{
+      { (u - 0.5f) * shape.Width, (v - 0.5f) * shape.Height, 0 },
+      { 0, 0, 1 },
+      { u, v },
+      { 1, 0, 0 },
+      { 0, 1, 0 },
+    };
+  });
+}
+
+//
+// cylinder
+//
+static Grid
+CylinderSideGrid(const CylinderShape& shape)
+{
+  return { shape.Slices, shape.Stacks };
+}
+
+// a disc from the center
+static Grid
+CylinderCapGrid(const CylinderShape& shape)
+{
+  return { shape.Slices, 1, true, false };
+}
+
+ShapeSize
+Measure(const CylinderShape& shape)
+{
+  auto size = CylinderSideGrid(shape).Size();
+  if (shape.Caps) {
+    auto cap = CylinderCapGrid(shape).Size();
+    size.VertexCount += cap.VertexCount * 2;
+    size.IndexCount += cap.IndexCount * 2;
+  }
+  return size;
+}
+
+void
+Write(const CylinderShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex)
+{
+  Writer w(tangents, vertices, indices, indexStride, baseVertex);
+  float half = shape.Height * 0.5f;
+
+  auto side = CylinderSideGrid(shape);
+  side.Write(w, [&shape, &side, half](uint32_t x, uint32_t y) {
+    float u = (float)x / side.Columns;
+    float v = (float)y / side.Rows;
+    float phi = u * 2.0f * PI;
+    XMFLOAT3 n = { cosf(phi), 0, sinf(phi) };
+    return Sample{
+      { n.x * shape.Radius, half - v * shape.Height, n.z * shape.Radius },
+      n,
+      { u, v },
+      { -n.z, 0, n.x },
+      { 0, -1, 0 },
+    };
+  });
+
+  if (!shape.Caps) {
+    return;
+  }
+  auto cap = CylinderCapGrid(shape);
+  for (float sign : { 1.0f, -1.0f }) {
+    // planar uv. seen from outside, u to +x and v up the screen.
+    cap.Write(w, [&shape, &cap, half, sign](uint32_t x, uint32_t y) {
+      float phi = (float)x / cap.Columns * 2.0f * PI;
+      float rho = (float)y / cap.Rows;
+      float cx = cosf(phi) * rho;
+      float cz = sinf(phi) * rho;
+      return Sample{
+        { cx * shape.Radius, half * sign, cz * shape.Radius },
+        { 0, sign, 0 },
+        { 0.5f + 0.5f * cx, 0.5f - 0.5f * cz * sign },
+        { 1, 0, 0 },
+        { 0, 0, -sign },
+      };
+    });
+  }
+}
+
+//
+// torus
+//
+static Grid
+TorusGrid(const TorusShape& shape)
+{
+  return { shape.Slices, shape.TubeSlices };
+}
+
+ShapeSize
+Measure(const TorusShape& shape)
+{
+  return TorusGrid(shape).Size();
+}
+
+void
+Write(const TorusShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex)
+{
+  Writer w(tangents, vertices, indices, indexStride, baseVertex);
+  auto grid = TorusGrid(shape);
+  grid.Write(w, [&shape, &grid](uint32_t x, uint32_t y) {
+    float u = (float)x / grid.Columns;
+    float v = (float)y / grid.Rows;
+    float phi = u * 2.0f * PI;
+    float theta = v * 2.0f * PI;
+    XMFLOAT3 n = {
+      cosf(theta) * cosf(phi),
+      sinf(theta),
+      cosf(theta) * sinf(phi),
+    };
+    float ring = shape.Radius + shape.TubeRadius * cosf(theta);
+    return Sample{
+      { ring * cosf(phi), shape.TubeRadius * sinf(theta), ring * sinf(phi) },
+      n,
+      { u, v },
+      { -sinf(phi), 0, cosf(phi) },
+      { -sinf(theta) * cosf(phi), cosf(theta), -sinf(theta) * sinf(phi) },
+    };
+  });
+}
+
+//
+// capsule
+//
+static Grid
+CapsuleGrid(const CapsuleShape& shape)
+{
+  // hemisphere, cylinder band, hemisphere
+  return { shape.Slices, shape.Stacks * 2 + 1, true, true };
+}
+
+ShapeSize
+Measure(const CapsuleShape& shape)
+{
+  return CapsuleGrid(shape).Size();
+}
+
+void
+Write(const CapsuleShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex)
+{
+  Writer w(tangents, vertices, indices, indexStride, baseVertex);
+  auto grid = CapsuleGrid(shape);
+  float half = shape.Height * 0.5f;
+  // v by the arc length of the profile
+  float length = shape.Radius * PI + shape.Height;
+  grid.Write(w, [&shape, &grid, half, length](uint32_t x, uint32_t y) {
+    float u = (float)x / grid.Columns;
+    float phi = u * 2.0f * PI;
+    float theta;
+    float center;
+    float arc;
+    if (y <= shape.Stacks) {
+      theta = (float)y / shape.Stacks * PI * 0.5f;
+      center = half;
+      arc = shape.Radius * theta;
+    } else {
+      auto k = y - shape.Stacks - 1;
+      theta = (1.0f + (float)k / shape.Stacks) * PI * 0.5f;
+      center = -half;
+      arc = shape.Height + shape.Radius * theta;
+    }
+    XMFLOAT3 n = {
+      cosf(phi) * sinf(theta),
+      cosf(theta),
+      sinf(phi) * sinf(theta),
+    };
+    return Sample{
+      {
+        n.x * shape.Radius,
+        center + n.y * shape.Radius,
+        n.z * shape.Radius,
+      },
+      n,
+      { u, arc / length },
+      { -sinf(phi), 0, cosf(phi) },
+      { cosf(phi) * cosf(theta), -sinf(theta), sinf(phi) * cosf(theta) },
+    };
+  });
+}
+
+}
+}
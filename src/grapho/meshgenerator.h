@@ -0,0 +1,238 @@
+#pragma once
+#include "vertexlayout.h"
+#include <algorithm>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace mesh {
+
+//
+// parametric shapes. every shape is one or a few grids of
+// (Columns + 1) x (Rows + 1) vertices, written as an indexed triangle list.
+// counter clockwise seen from outside.
+//
+// vertex layout is mesh::Vertex, or mesh::TangentVertex with Tangents.
+// the tangent follows the MikkTSpace convention. xyz along +u orthogonal to
+// the normal, w the sign of the bitangent: B = w * cross(N, T).
+//
+
+// y up, uv sphere. v = 0 at the north pole.
+struct SphereShape
+{
+  float Radius = 1.0f;
+  uint32_t Slices = 64;
+  uint32_t Stacks = 64;
+
+  SphereShape Lod(uint32_t level) const
+  {
+    return { Radius,
+             std::max(Slices >> level, 3u),
+             std::max(Stacks >> level, 2u) };
+  }
+};
+
+// xy plane facing +z. uv (0, 0) at (-Width/2, -Height/2).
+struct PlaneShape
+{
+  float Width = 2.0f;
+  float Height = 2.0f;
+  uint32_t Columns = 1;
+  uint32_t Rows = 1;
+
+  PlaneShape Lod(uint32_t level) const
+  {
+    return { Width,
+             Height,
+             std::max(Columns >> level, 1u),
+             std::max(Rows >> level, 1u) };
+  }
+};
+
+// y axis, centered. caps are separate grids with planar uv.
+struct CylinderShape
+{
+  float Radius = 1.0f;
+  float Height = 2.0f;
+  uint32_t Slices = 32;
+  uint32_t Stacks = 1;
+  bool Caps = true;
+
+  CylinderShape Lod(uint32_t level) const
+  {
+    return { Radius,
+             Height,
+             std::max(Slices >> level, 3u),
+             std::max(Stacks >> level, 1u),
+             Caps };
+  }
+};
+
+// ring on the xz plane
+struct TorusShape
+{
+  float Radius = 1.0f;
+  float TubeRadius = 0.25f;
+  uint32_t Slices = 64;
+  uint32_t TubeSlices = 32;
+
+  TorusShape Lod(uint32_t level) const
+  {
+    return { Radius,
+             TubeRadius,
+             std::max(Slices >> level, 3u),
+             std::max(TubeSlices >> level, 3u) };
+  }
+};
+
+// y axis, centered. Height is the cylinder part without the hemispheres.
+struct CapsuleShape
+{
+  float Radius = 0.5f;
+  float Height = 1.0f;
+  uint32_t Slices = 32;
+  // per hemisphere
+  uint32_t Stacks = 8;
+
+  CapsuleShape Lod(uint32_t level) const
+  {
+    return { Radius,
+             Height,
+             std::max(Slices >> level, 3u),
+             std::max(Stacks >> level, 1u) };
+  }
+};
+
+struct ShapeSize
+{
+  uint32_t VertexCount = 0;
+  uint32_t IndexCount = 0;
+};
+
+ShapeSize
+Measure(const SphereShape& shape);
+ShapeSize
+Measure(const PlaneShape& shape);
+ShapeSize
+Measure(const CylinderShape& shape);
+ShapeSize
+Measure(const TorusShape& shape);
+ShapeSize
+Measure(const CapsuleShape& shape);
+
+// write Measure(shape) vertices and indices to the preallocated memory.
+// indices are u16 or u32 by indexStride, baseVertex added.
+void
+Write(const SphereShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex = 0);
+void
+Write(const PlaneShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex = 0);
+void
+Write(const CylinderShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex = 0);
+void
+Write(const TorusShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex = 0);
+void
+Write(const CapsuleShape& shape,
+      bool tangents,
+      uint8_t* vertices,
+      uint8_t* indices,
+      uint32_t indexStride,
+      uint32_t baseVertex = 0);
+
+// sizeof(Vertex) or sizeof(TangentVertex)
+uint32_t
+GeneratedVertexStride(bool tangents);
+
+void
+SetGeneratedLayouts(Mesh& mesh, bool tangents);
+
+struct GenerateSettings
+{
+  bool Tangents = false;
+  // level i has 1/2^i of the segments
+  uint32_t LodCount = 1;
+};
+
+// a range of Mesh::Indices. draw with offset IndexOffset * Indices.Stride()
+struct MeshLod
+{
+  uint32_t IndexOffset;
+  uint32_t IndexCount;
+};
+
+// all levels into one vertex and index buffer. the buffers of mesh are
+// resized once and reused, so regenerating into the same mesh does not
+// allocate when the capacity is enough.
+template<typename S>
+inline void
+Generate(const S& shape,
+         const GenerateSettings& settings,
+         Mesh& mesh,
+         std::vector<MeshLod>& lods)
+{
+  auto lodCount = std::max(settings.LodCount, 1u);
+  lods.resize(lodCount);
+  ShapeSize total;
+  for (uint32_t i = 0; i < lodCount; ++i) {
+    auto size = Measure(shape.Lod(i));
+    lods[i] = { total.IndexCount, size.IndexCount };
+    total.VertexCount += size.VertexCount;
+    total.IndexCount += size.IndexCount;
+  }
+
+  auto stride = GeneratedVertexStride(settings.Tangents);
+  uint32_t indexStride = total.VertexCount <= 0x10000 ? 2 : 4;
+  mesh.Mode = DrawMode::Triangles;
+  SetGeneratedLayouts(mesh, settings.Tangents);
+  mesh.Vertices.Bytes.resize(total.VertexCount * stride);
+  mesh.Vertices.Count = total.VertexCount;
+  mesh.Streams.clear();
+  mesh.Indices.Bytes.resize(total.IndexCount * indexStride);
+  mesh.Indices.Count = total.IndexCount;
+
+  uint32_t baseVertex = 0;
+  for (uint32_t i = 0; i < lodCount; ++i) {
+    auto lod = shape.Lod(i);
+    Write(lod,
+          settings.Tangents,
+          mesh.Vertices.Bytes.data() + baseVertex * stride,
+          mesh.Indices.Bytes.data() + lods[i].IndexOffset * indexStride,
+          indexStride,
+          baseVertex);
+    baseVertex += Measure(lod).VertexCount;
+  }
+}
+
+// the first level only
+template<typename S>
+inline std::shared_ptr<Mesh>
+Generate(const S& shape, const GenerateSettings& settings = {})
+{
+  auto ptr = std::make_shared<Mesh>();
+  std::vector<MeshLod> lods;
+  Generate(shape, { settings.Tangents, 1 }, *ptr, lods);
+  return ptr;
+}
+
+}
+}
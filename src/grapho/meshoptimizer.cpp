@@ -0,0 +1,600 @@
+#include "meshoptimizer.h"
+#include "hash.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace grapho {
+namespace mesh {
+
+std::vector<uint32_t>
+TriangleIndices(const Mesh& mesh)
+{
+  std::vector<uint32_t> src;
+  if (mesh.Indices.Size()) {
+    auto count = mesh.Indices.Count;
+    auto stride = mesh.Indices.Stride();
+    src.resize(count);
+    auto p = mesh.Indices.Data();
+    for (uint32_t i = 0; i < count; ++i, p += stride) {
+      switch (stride) {
+        case 1:
+          src[i] = *p;
+          break;
+        case 2:
+          src[i] = *(const uint16_t*)p;
+          break;
+        default:
+          src[i] = *(const uint32_t*)p;
+          break;
+      }
+    }
+  } else {
+    src.resize(mesh.Vertices.Count);
+    for (uint32_t i = 0; i < src.size(); ++i) {
+      src[i] = i;
+    }
+  }
+
+  if (mesh.Mode == DrawMode::Triangles) {
+    src.resize(src.size() / 3 * 3);
+    return src;
+  }
+
+  std::vector<uint32_t> indices;
+  if (src.size() < 3) {
+    return indices;
+  }
+  indices.reserve((src.size() - 2) * 3);
+  for (size_t i = 0; i + 2 < src.size(); ++i) {
+    auto a = src[i];
+    auto b = src[i + 1];
+    auto c = src[i + 2];
+    if (a == b || b == c || c == a) {
+      continue;
+    }
+    // keep the winding of odd triangles
+    if (i & 1) {
+      std::swap(a, b);
+    }
+    indices.push_back(a);
+    indices.push_back(b);
+    indices.push_back(c);
+  }
+  return indices;
+}
+
+VertexCacheStatistics
+AnalyzeVertexCache(std::span<const uint32_t> indices,
+                   uint32_t vertexCount,
+                   uint32_t cacheSize)
+{
+  VertexCacheStatistics stats;
+  if (indices.size() < 3) {
+    // no triangle
+    return stats;
+  }
+
+  // timestamp of the insertion. in the cache while within cacheSize.
+  std::vector<uint32_t> inserted(vertexCount, 0);
+  std::vector<bool> used(vertexCount, false);
+  uint32_t time = cacheSize + 1;
+  uint32_t referenced = 0;
+  for (auto index : indices) {
+    if (time - inserted[index] > cacheSize) {
+      inserted[index] = time++;
+      ++stats.VerticesTransformed;
+    }
+    if (!used[index]) {
+      used[index] = true;
+      ++referenced;
+    }
+  }
+  stats.Acmr = (float)stats.VerticesTransformed / (indices.size() / 3);
+  stats.Atvr = (float)stats.VerticesTransformed / referenced;
+  return stats;
+}
+
+//
+// weld
+//
+uint32_t
+WeldVertices(std::vector<uint8_t>& vertices,
+             uint32_t stride,
+             std::vector<uint32_t>& remap)
+{
+  auto count = static_cast<uint32_t>(vertices.size() / stride);
+  remap.resize(count);
+
+  // open addressing. stores the new index of the first occurrence.
+  const uint32_t EMPTY = ~0u;
+  uint32_t tableSize = 1;
+  while (tableSize < count * 2) {
+    tableSize *= 2;
+  }
+  std::vector<uint32_t> table(tableSize, EMPTY);
+
+  uint32_t unique = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto vertex = vertices.data() + i * stride;
+    auto slot = HashBytes(vertex, stride) & (tableSize - 1);
+    for (;; slot = (slot + 1) & (tableSize - 1)) {
+      auto found = table[slot];
+      if (found == EMPTY) {
+        // new vertex. move to the compacted position.
+        table[slot] = unique;
+        if (unique != i) {
+          memcpy(vertices.data() + unique * stride, vertex, stride);
+        }
+        remap[i] = unique++;
+        break;
+      }
+      if (memcmp(vertices.data() + found * stride, vertex, stride) == 0) {
+        remap[i] = found;
+        break;
+      }
+    }
+  }
+  vertices.resize(unique * stride);
+  return unique;
+}
+
+//
+// Forsyth
+//
+const uint32_t FORSYTH_CACHE_SIZE = 32;
+const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const float FORSYTH_LAST_TRI_SCORE = 0.75f;
+const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+static float
+ForsythVertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+  if (remainingTriangles == 0) {
+    // no longer used
+    return -1.0f;
+  }
+  float score = 0;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // used by the last triangle. fixed score, so the strip direction
+      // does not matter.
+      score = FORSYTH_LAST_TRI_SCORE;
+    } else {
+      const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+      score = powf(1.0f - (cachePosition - 3) * scaler,
+                   FORSYTH_CACHE_DECAY_POWER);
+    }
+  }
+  // favour vertices with few triangles left, to finish them off
+  score += FORSYTH_VALENCE_BOOST_SCALE *
+           powf((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+  return score;
+}
+
+void
+OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount)
+{
+  auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // vertex -> triangles
+  std::vector<uint32_t> remaining(vertexCount, 0);
+  for (auto index : indices) {
+    ++remaining[index];
+  }
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  for (uint32_t i = 0; i < vertexCount; ++i) {
+    offsets[i + 1] = offsets[i] + remaining[i];
+  }
+  std::vector<uint32_t> adjacency(indices.size());
+  {
+    auto fill = offsets;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        adjacency[fill[indices[t * 3 + k]]++] = t;
+      }
+    }
+  }
+
+  std::vector<int> cachePosition(vertexCount, -1);
+  std::vector<float> vertexScore(vertexCount);
+  for (uint32_t i = 0; i < vertexCount; ++i) {
+    vertexScore[i] = ForsythVertexScore(-1, remaining[i]);
+  }
+  std::vector<bool> emitted(triangleCount, false);
+
+  // lru. +3 for the vertices pushed out by the new triangle.
+  uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+  uint32_t cacheCount = 0;
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  uint32_t cursor = 0;
+  int32_t best = -1;
+  for (uint32_t emitCount = 0; emitCount < triangleCount; ++emitCount) {
+    if (best < 0) {
+      // no candidate around the cache. take the next in the input order.
+      while (emitted[cursor]) {
+        ++cursor;
+      }
+      best = cursor;
+    }
+
+    // emit
+    emitted[best] = true;
+    uint32_t tri[3] = {
+      indices[best * 3],
+      indices[best * 3 + 1],
+      indices[best * 3 + 2],
+    };
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCount = 0;
+    for (auto v : tri) {
+      result.push_back(v);
+      if (std::find(newCache, newCache + newCount, v) == newCache + newCount) {
+        newCache[newCount++] = v;
+      }
+      // remove the triangle from the vertex
+      auto begin = adjacency.begin() + offsets[v];
+      auto end = begin + remaining[v];
+      *std::find(begin, end, (uint32_t)best) = *(end - 1);
+      --remaining[v];
+    }
+    for (uint32_t i = 0; i < cacheCount; ++i) {
+      auto v = cache[i];
+      if (v != tri[0] && v != tri[1] && v != tri[2]) {
+        newCache[newCount++] = v;
+      }
+    }
+
+    // rescore the vertices in the cache and their triangles
+    for (uint32_t i = 0; i < newCount; ++i) {
+      auto v = newCache[i];
+      cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+      vertexScore[v] = ForsythVertexScore(cachePosition[v], remaining[v]);
+    }
+    best = -1;
+    float bestScore = -1;
+    for (uint32_t i = 0; i < newCount; ++i) {
+      auto v = newCache[i];
+      for (uint32_t j = 0; j < remaining[v]; ++j) {
+        auto t = adjacency[offsets[v] + j];
+        auto score = vertexScore[indices[t * 3]] +
+                     vertexScore[indices[t * 3 + 1]] +
+                     vertexScore[indices[t * 3 + 2]];
+        if (score > bestScore) {
+          bestScore = score;
+          best = t;
+        }
+      }
+    }
+
+    cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+    std::copy(newCache, newCache + cacheCount, cache);
+  }
+
+  std::copy(result.begin(), result.end(), indices.begin());
+}
+
+//
+// overdraw
+//
+static XMFLOAT3
+LoadPosition(const uint8_t* positions, uint32_t stride, uint32_t index)
+{
+  XMFLOAT3 p;
+  memcpy(&p, positions + index * stride, sizeof(p));
+  return p;
+}
+
+void
+OptimizeOverdraw(std::span<uint32_t> indices,
+                 const uint8_t* positions,
+                 uint32_t stride,
+                 uint32_t vertexCount,
+                 float threshold)
+{
+  auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+  if (triangleCount == 0) {
+    return;
+  }
+
+  // misses of each triangle in the current order
+  const uint32_t cacheSize = 16;
+  std::vector<uint32_t> inserted(vertexCount, 0);
+  uint32_t time = cacheSize + 1;
+  auto simulate = [&inserted, &time, &indices](uint32_t t) {
+    uint32_t misses = 0;
+    for (int k = 0; k < 3; ++k) {
+      auto v = indices[t * 3 + k];
+      if (time - inserted[v] > cacheSize) {
+        inserted[v] = time++;
+        ++misses;
+      }
+    }
+    return misses;
+  };
+  auto flush = [&time]() { time += cacheSize + 1; };
+
+  // hard boundaries. a triangle of 3 misses starts from a cold cache anyway.
+  std::vector<uint32_t> hard;
+  uint32_t totalMisses = 0;
+  for (uint32_t t = 0; t < triangleCount; ++t) {
+    auto misses = simulate(t);
+    totalMisses += misses;
+    if (t == 0 || misses == 3) {
+      hard.push_back(t);
+    }
+  }
+  hard.push_back(triangleCount);
+  float acmrLimit = threshold * totalMisses / triangleCount;
+
+  // soft boundaries. split a hard cluster where restarting from a cold cache
+  // keeps the ACMR within the limit.
+  std::vector<uint32_t> clusters;
+  for (size_t h = 0; h + 1 < hard.size(); ++h) {
+    flush();
+    uint32_t start = hard[h];
+    uint32_t misses = 0;
+    clusters.push_back(start);
+    for (uint32_t t = start; t < hard[h + 1]; ++t) {
+      misses += simulate(t);
+      if (t + 1 < hard[h + 1] && misses <= acmrLimit * (t + 1 - start)) {
+        flush();
+        start = t + 1;
+        misses = 0;
+        clusters.push_back(start);
+      }
+    }
+  }
+  clusters.push_back(triangleCount);
+
+  // sort key. clusters facing away from the mesh center are drawn first and
+  // occlude the inner ones.
+  XMFLOAT3 center = { 0, 0, 0 };
+  float totalArea = 0;
+  struct Cluster
+  {
+    uint32_t Start;
+    uint32_t End;
+    XMFLOAT3 Center;
+    float Area;
+    XMFLOAT3 Normal;
+    float Key;
+  };
+  std::vector<Cluster> sorted(clusters.size() - 1);
+  for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+    auto& cluster = sorted[c];
+    cluster = { clusters[c], clusters[c + 1], { 0, 0, 0 }, 0, { 0, 0, 0 }, 0 };
+    for (auto t = cluster.Start; t < cluster.End; ++t) {
+      auto p0 = LoadPosition(positions, stride, indices[t * 3]);
+      auto p1 = LoadPosition(positions, stride, indices[t * 3 + 1]);
+      auto p2 = LoadPosition(positions, stride, indices[t * 3 + 2]);
+      XMFLOAT3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+      XMFLOAT3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+      XMFLOAT3 n = {
+        e1.y * e2.z - e1.z * e2.y,
+        e1.z * e2.x - e1.x * e2.z,
+        e1.x * e2.y - e1.y * e2.x,
+      };
+      // twice the area
+      float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+      cluster.Center.x += (p0.x + p1.x + p2.x) * area;
+      cluster.Center.y += (p0.y + p1.y + p2.y) * area;
+      cluster.Center.z += (p0.z + p1.z + p2.z) * area;
+      cluster.Area += area;
+      cluster.Normal.x += n.x;
+      cluster.Normal.y += n.y;
+      cluster.Normal.z += n.z;
+    }
+    center.x += cluster.Center.x;
+    center.y += cluster.Center.y;
+    center.z += cluster.Center.z;
+    totalArea += cluster.Area;
+    if (cluster.Area > 0) {
+      auto inv = 1.0f / (cluster.Area * 3);
+      cluster.Center = {
+        cluster.Center.x * inv,
+        cluster.Center.y * inv,
+        cluster.Center.z * inv,
+      };
+    }
+  }
+  if (totalArea > 0) {
+    auto inv = 1.0f / (totalArea * 3);
+    center = { center.x * inv, center.y * inv, center.z * inv };
+  }
+  for (auto& cluster : sorted) {
+    auto& n = cluster.Normal;
+    auto len = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+    if (len > 0) {
+      cluster.Key = ((cluster.Center.x - center.x) * n.x +
+                     (cluster.Center.y - center.y) * n.y +
+                     (cluster.Center.z - center.z) * n.z) /
+                    len;
+    }
+  }
+  std::stable_sort(
+    sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+      return a.Key > b.Key;
+    });
+
+  std::vector<uint32_t> result;
+  result.reserve(triangleCount * 3);
+  for (auto& cluster : sorted) {
+    result.insert(result.end(),
+                  indices.begin() + cluster.Start * 3,
+                  indices.begin() + cluster.End * 3);
+  }
+  std::copy(result.begin(), result.end(), indices.begin());
+}
+
+//
+// vertex fetch
+//
+uint32_t
+OptimizeVertexFetch(std::span<uint32_t> indices,
+                    std::vector<uint8_t>& vertices,
+                    uint32_t stride)
+{
+  auto count = static_cast<uint32_t>(vertices.size() / stride);
+  const uint32_t UNUSED = ~0u;
+  std::vector<uint32_t> remap(count, UNUSED);
+  std::vector<uint8_t> dst;
+  dst.reserve(vertices.size());
+  uint32_t next = 0;
+  for (auto& index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = next++;
+      dst.insert(dst.end(),
+                 vertices.begin() + index * stride,
+                 vertices.begin() + (index + 1) * stride);
+    }
+    index = remap[index];
+  }
+  vertices = std::move(dst);
+  return next;
+}
+
+//
+// pipeline
+//
+std::shared_ptr<Mesh>
+Optimize(const Mesh& mesh, const OptimizeSettings& settings)
+{
+  auto position =
+    std::find_if(mesh.Layouts.begin(),
+                 mesh.Layouts.end(),
+                 [location = settings.PositionLocation](const auto& layout) {
+                   return layout.Id.AttributeLocation == location;
+                 });
+  if (position == mesh.Layouts.end() || position->Type != ValueType::Float ||
+      position->Count < 3) {
+    return {};
+  }
+  if (mesh.Vertices.Count == 0 || !mesh.Streams.empty()) {
+    return {};
+  }
+  auto stride = mesh.Vertices.Stride();
+
+  auto indices = TriangleIndices(mesh);
+  std::vector<uint8_t> vertices = mesh.Vertices.Bytes;
+  auto vertexCount = mesh.Vertices.Count;
+
+  if (settings.Weld) {
+    std::vector<uint32_t> remap;
+    vertexCount = WeldVertices(vertices, stride, remap);
+    for (auto& index : indices) {
+      index = remap[index];
+    }
+  }
+  if (settings.VertexCache) {
+    OptimizeVertexCache(indices, vertexCount);
+  }
+  if (settings.Overdraw) {
+    OptimizeOverdraw(indices,
+                     vertices.data() + position->Offset,
+                     stride,
+                     vertexCount,
+                     settings.OverdrawThreshold);
+  }
+  if (settings.VertexFetch) {
+    vertexCount = OptimizeVertexFetch(indices, vertices, stride);
+  }
+
+  auto ptr = std::make_shared<Mesh>();
+  ptr->Mode = DrawMode::Triangles;
+  ptr->Layouts = mesh.Layouts;
+  ptr->Vertices.Bytes = std::move(vertices);
+  ptr->Vertices.Count = vertexCount;
+  if (settings.NarrowIndices && vertexCount <= 0x10000) {
+    std::vector<uint16_t> narrow(indices.begin(), indices.end());
+    ptr->Indices.Assign(narrow);
+  } else {
+    ptr->Indices.Assign(indices);
+  }
+  return ptr;
+}
+
+//
+// streams
+//
+std::shared_ptr<Mesh>
+SplitPositionStream(const Mesh& mesh, uint32_t positionLocation)
+{
+  if (mesh.Vertices.Count == 0 || !mesh.Streams.empty()) {
+    return {};
+  }
+  auto position = std::find_if(
+    mesh.Layouts.begin(),
+    mesh.Layouts.end(),
+    [positionLocation](const auto& layout) {
+      return layout.Id.AttributeLocation == positionLocation;
+    });
+  if (position == mesh.Layouts.end()) {
+    return {};
+  }
+
+  // new layouts. sizes from the offsets in the source vertex.
+  auto ptr = std::make_shared<Mesh>();
+  ptr->Mode = mesh.Mode;
+  ptr->Indices = mesh.Indices;
+  auto positionSize = ValueSize(position->Type, position->Count);
+  uint32_t attributeStride = 0;
+  for (auto layout : mesh.Layouts) {
+    if (layout.Id.AttributeLocation == positionLocation) {
+      continue;
+    }
+    attributeStride += ValueSize(layout.Type, layout.Count);
+  }
+  struct Copy
+  {
+    uint32_t Src;
+    uint32_t Dst;
+    uint32_t Size;
+  };
+  std::vector<Copy> copies;
+  uint32_t offset = 0;
+  for (auto layout : mesh.Layouts) {
+    auto size = ValueSize(layout.Type, layout.Count);
+    if (layout.Id.AttributeLocation == positionLocation) {
+      layout.Id.Slot = 0;
+      layout.Offset = 0;
+      layout.Stride = positionSize;
+    } else {
+      copies.push_back({ layout.Offset, offset, size });
+      layout.Id.Slot = 1;
+      layout.Offset = offset;
+      layout.Stride = attributeStride;
+      offset += size;
+    }
+    ptr->Layouts.push_back(layout);
+  }
+
+  auto count = mesh.Vertices.Count;
+  auto stride = mesh.Vertices.Stride();
+  ptr->Vertices.Bytes.resize(count * positionSize);
+  ptr->Vertices.Count = count;
+  auto& attributes = ptr->Streams.emplace_back();
+  attributes.Bytes.resize(count * attributeStride);
+  attributes.Count = count;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto src = mesh.Vertices.Data() + i * stride;
+    memcpy(ptr->Vertices.Bytes.data() + i * positionSize,
+           src + position->Offset,
+           positionSize);
+    for (auto& copy : copies) {
+      memcpy(attributes.Bytes.data() + i * attributeStride + copy.Dst,
+             src + copy.Src,
+             copy.Size);
+    }
+  }
+  return ptr;
+}
+
+}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "vertexlayout.h"
+#include <memory>
+#include <span>
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+namespace mesh {
+
+// triangle list as u32. generates 0, 1, 2... for a mesh without indices and
+// unrolls strips, dropping degenerate triangles.
+std::vector<uint32_t>
+TriangleIndices(const Mesh& mesh);
+
+struct VertexCacheStatistics
+{
+  uint32_t VerticesTransformed = 0;
+  // average cache miss ratio. transformed vertices per triangle. 0.5 - 3.0
+  float Acmr = 0;
+  // average transform to vertex ratio. transformed per referenced vertex. 1.0
+  // is optimal.
+  float Atvr = 0;
+};
+
+// simulate a fifo post-transform cache. zeros for less than a triangle
+VertexCacheStatistics
+AnalyzeVertexCache(std::span<const uint32_t> indices,
+                   uint32_t vertexCount,
+                   uint32_t cacheSize = 16);
+
+// merge bitwise equal vertices. returns the unique vertex count.
+// remap[old] = new. vertices are compacted in place.
+uint32_t
+WeldVertices(std::vector<uint8_t>& vertices,
+             uint32_t stride,
+             std::vector<uint32_t>& remap);
+
+// Tom Forsyth, linear-speed vertex cache optimisation.
+// reorders triangles in place.
+void
+OptimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount);
+
+// Sander et al, fast triangle reordering for vertex locality and reduced
+// overdraw. splits the cache optimized order into clusters where the cache
+// is cold, and sorts them outside first. threshold is the acceptable ACMR
+// increase. call after OptimizeVertexCache.
+void
+OptimizeOverdraw(std::span<uint32_t> indices,
+                 const uint8_t* positions,
+                 uint32_t stride,
+                 uint32_t vertexCount,
+                 float threshold = 1.05f);
+
+// renumber vertices in the order of the first use and drop unused ones.
+// returns the new vertex count.
+uint32_t
+OptimizeVertexFetch(std::span<uint32_t> indices,
+                    std::vector<uint8_t>& vertices,
+                    uint32_t stride);
+
+struct OptimizeSettings
+{
+  bool Weld = true;
+  bool VertexCache = true;
+  bool Overdraw = true;
+  float OverdrawThreshold = 1.05f;
+  bool VertexFetch = true;
+  // u16 indices if the vertex count fits
+  bool NarrowIndices = true;
+  // the float3 attribute used for the overdraw order
+  uint32_t PositionLocation = 0;
+};
+
+// indexed triangle list with the same layouts.
+// nullptr if the mesh has no float3 position in PositionLocation, or has
+// Streams. optimize before SplitPositionStream.
+std::shared_ptr<Mesh>
+Optimize(const Mesh& mesh, const OptimizeSettings& settings = {});
+
+// move the attribute in positionLocation to a tightly packed slot 0 and
+// interleave the others in slot 1. indices are shared.
+// nullptr if the mesh has no such attribute or already has Streams.
+std::shared_ptr<Mesh>
+SplitPositionStream(const Mesh& mesh, uint32_t positionLocation = 0);
+
+}
+}
@@ -0,0 +1,205 @@
+#include "meshquantizer.h"
+#include "half.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace grapho {
+namespace mesh {
+
+int16_t
+QuantizeSnorm16(float value)
+{
+  value = std::clamp(value, -1.0f, 1.0f);
+  return static_cast<int16_t>(lroundf(value * 32767.0f));
+}
+
+static float
+SignNotZero(float v)
+{
+  return v < 0 ? -1.0f : 1.0f;
+}
+
+void
+EncodeOctahedral(const XMFLOAT3& n, int16_t out[2])
+{
+  // project on the octahedron |x| + |y| + |z| = 1, fold the lower half
+  float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  float x = l1 > 0 ? n.x / l1 : 0;
+  float y = l1 > 0 ? n.y / l1 : 0;
+  if (n.z < 0) {
+    float fx = (1.0f - fabsf(y)) * SignNotZero(x);
+    float fy = (1.0f - fabsf(x)) * SignNotZero(y);
+    x = fx;
+    y = fy;
+  }
+  out[0] = QuantizeSnorm16(x);
+  out[1] = QuantizeSnorm16(y);
+}
+
+XMFLOAT3
+DecodeOctahedral(const int16_t in[2])
+{
+  // the same as octDecode in gl3/shaders/octahedral.h
+  float x = std::max(in[0] / 32767.0f, -1.0f);
+  float y = std::max(in[1] / 32767.0f, -1.0f);
+  float z = 1.0f - fabsf(x) - fabsf(y);
+  float t = std::max(-z, 0.0f);
+  x += x >= 0 ? -t : t;
+  y += y >= 0 ? -t : t;
+  float len = sqrtf(x * x + y * y + z * z);
+  return { x / len, y / len, z / len };
+}
+
+static uint32_t
+Snorm(float value, int bits)
+{
+  auto max = (1 << (bits - 1)) - 1;
+  auto i = lroundf(std::clamp(value, -1.0f, 1.0f) * max);
+  return static_cast<uint32_t>(i) & ((1u << bits) - 1);
+}
+
+uint32_t
+PackSnorm2_10_10_10(const XMFLOAT4& value)
+{
+  return Snorm(value.x, 10) | (Snorm(value.y, 10) << 10) |
+         (Snorm(value.z, 10) << 20) | (Snorm(value.w, 2) << 30);
+}
+
+static const VertexLayout*
+FindFloatLayout(const Mesh& mesh, uint32_t location, uint32_t count)
+{
+  for (auto& layout : mesh.Layouts) {
+    if (layout.Id.AttributeLocation == location) {
+      if (layout.Type == ValueType::Float && layout.Count == count &&
+          layout.Id.Slot == 0) {
+        return &layout;
+      }
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<QuantizedMesh>
+Quantize(const Mesh& mesh)
+{
+  if (!mesh.Streams.empty() || mesh.Vertices.Count == 0) {
+    return std::nullopt;
+  }
+  auto position = FindFloatLayout(mesh, 0, 3);
+  auto normal = FindFloatLayout(mesh, 1, 3);
+  auto uv = FindFloatLayout(mesh, 2, 2);
+  auto tangent = FindFloatLayout(mesh, 3, 4);
+  if (!position || !normal || !uv) {
+    return std::nullopt;
+  }
+  auto count = mesh.Vertices.Count;
+  auto srcStride = mesh.Vertices.Stride();
+  auto read = [&mesh, srcStride](uint32_t i, const VertexLayout* layout,
+                                 void* dst, size_t size) {
+    memcpy(dst, mesh.Vertices.Data() + i * srcStride + layout->Offset, size);
+  };
+
+  // bounding box
+  XMFLOAT3 min = { INFINITY, INFINITY, INFINITY };
+  XMFLOAT3 max = { -INFINITY, -INFINITY, -INFINITY };
+  for (uint32_t i = 0; i < count; ++i) {
+    XMFLOAT3 p;
+    read(i, position, &p, sizeof(p));
+    min = { std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+    max = { std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+  }
+  XMFLOAT3 center = {
+    (min.x + max.x) * 0.5f,
+    (min.y + max.y) * 0.5f,
+    (min.z + max.z) * 0.5f,
+  };
+  // half extent. keep a flat axis invertible.
+  XMFLOAT3 scale = {
+    std::max((max.x - min.x) * 0.5f, 1e-20f),
+    std::max((max.y - min.y) * 0.5f, 1e-20f),
+    std::max((max.z - min.z) * 0.5f, 1e-20f),
+  };
+
+  QuantizedMesh quantized{
+    std::make_shared<Mesh>(),
+    {
+      scale.x, 0, 0, 0,
+      0, scale.y, 0, 0,
+      0, 0, scale.z, 0,
+      center.x, center.y, center.z, 1,
+    },
+  };
+  auto& dst = *quantized.Mesh;
+  dst.Mode = mesh.Mode;
+  dst.Indices = mesh.Indices;
+
+  uint32_t stride =
+    tangent ? sizeof(QuantizedTangentVertex) : sizeof(QuantizedVertex);
+  dst.Layouts = {
+    {
+      .Id = { .AttributeLocation = 0, .Slot = 0 },
+      .Type = ValueType::Int16,
+      .Count = 4,
+      .Offset = offsetof(QuantizedVertex, Position),
+      .Stride = stride,
+      .Normalized = true,
+    },
+    {
+      .Id = { .AttributeLocation = 1, .Slot = 0 },
+      .Type = ValueType::Int16,
+      .Count = 2,
+      .Offset = offsetof(QuantizedVertex, Normal),
+      .Stride = stride,
+      .Normalized = true,
+    },
+    {
+      .Id = { .AttributeLocation = 2, .Slot = 0 },
+      .Type = ValueType::Half,
+      .Count = 2,
+      .Offset = offsetof(QuantizedVertex, Uv),
+      .Stride = stride,
+    },
+  };
+  if (tangent) {
+    dst.Layouts.push_back({
+      .Id = { .AttributeLocation = 3, .Slot = 0 },
+      .Type = ValueType::Int2_10_10_10,
+      .Count = 4,
+      .Offset = offsetof(QuantizedTangentVertex, Tangent),
+      .Stride = stride,
+      .Normalized = true,
+    });
+  }
+
+  dst.Vertices.Bytes.resize(count * stride);
+  dst.Vertices.Count = count;
+  for (uint32_t i = 0; i < count; ++i) {
+    XMFLOAT3 p;
+    read(i, position, &p, sizeof(p));
+    XMFLOAT3 n;
+    read(i, normal, &n, sizeof(n));
+    XMFLOAT2 t;
+    read(i, uv, &t, sizeof(t));
+
+    QuantizedTangentVertex v;
+    v.Position[0] = QuantizeSnorm16((p.x - center.x) / scale.x);
+    v.Position[1] = QuantizeSnorm16((p.y - center.y) / scale.y);
+    v.Position[2] = QuantizeSnorm16((p.z - center.z) / scale.z);
+    v.Position[3] = 32767;
+    EncodeOctahedral(n, v.Normal);
+    v.Uv[0] = FloatToHalf(t.x);
+    v.Uv[1] = FloatToHalf(t.y);
+    if (tangent) {
+      XMFLOAT4 tan;
+      read(i, tangent, &tan, sizeof(tan));
+      v.Tangent = PackSnorm2_10_10_10(tan);
+    }
+    memcpy(dst.Vertices.Bytes.data() + i * stride, &v, stride);
+  }
+  return quantized;
+}
+
+}
+}
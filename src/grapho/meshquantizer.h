@@ -0,0 +1,66 @@
+#pragma once
+#include "vertexlayout.h"
+#include <memory>
+#include <optional>
+#include <stdint.h>
+
+namespace grapho {
+namespace mesh {
+
+//
+// packed vertex. 16 bytes, 20 with the tangent. mesh::Vertex is 32.
+//
+// location 0: position. snorm16 x 4 in the bounding box, w = 1.
+//             world = model * Dequantize * position
+// location 1: normal. octahedral snorm16 x 2. decode with
+//             gl3/shaders/octahedral.h
+// location 2: uv. half x 2
+// location 3: tangent. signed 10:10:10:2 normalized, w the bitangent sign.
+//
+struct QuantizedVertex
+{
+  int16_t Position[4];
+  int16_t Normal[2];
+  uint16_t Uv[2];
+};
+static_assert(sizeof(QuantizedVertex) == 16);
+
+struct QuantizedTangentVertex
+{
+  int16_t Position[4];
+  int16_t Normal[2];
+  uint16_t Uv[2];
+  uint32_t Tangent;
+};
+static_assert(sizeof(QuantizedTangentVertex) == 20);
+
+struct QuantizedMesh
+{
+  std::shared_ptr<grapho::Mesh> Mesh;
+  // [-1, 1] to the original bounding box. the same layout as
+  // camera matrices, passed to SetUniform as is.
+  XMFLOAT4X4 Dequantize;
+};
+
+// float to snorm. round to nearest.
+int16_t
+QuantizeSnorm16(float value);
+
+// unit vector to 2 snorm16 on the octahedron
+void
+EncodeOctahedral(const XMFLOAT3& n, int16_t out[2]);
+XMFLOAT3
+DecodeOctahedral(const int16_t in[2]);
+
+// xyz [-1, 1] as snorm10, w as snorm2 (-1, 0, 1)
+uint32_t
+PackSnorm2_10_10_10(const XMFLOAT4& value);
+
+// mesh::Vertex or mesh::TangentVertex. float position, normal and uv in
+// location 0, 1, 2 and an optional float4 tangent in 3.
+// nullopt for other layouts or a mesh with Streams.
+std::optional<QuantizedMesh>
+Quantize(const Mesh& mesh);
+
+}
+}
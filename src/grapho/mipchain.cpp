@@ -0,0 +1,335 @@
+#include "mipchain.h"
+#include "parallel.h"
+#include "simd.h"
+#include <algorithm>
+#include <math.h>
+#include <optional>
+#include <string.h>
+
+namespace grapho {
+
+MipChain
+MipChain::FromImage(const Image& image)
+{
+  MipChain chain;
+  chain.Format = image.Format;
+  chain.ColorSpace = image.ColorSpace;
+  auto size = static_cast<uint32_t>(
+    ImageSize(image.Format, image.Width, image.Height));
+  chain.Pixels.assign(image.Pixels, image.Pixels + size);
+  chain.Levels.push_back({ image.Width, image.Height, 0, size });
+  return chain;
+}
+
+namespace {
+
+struct ChannelLayout
+{
+  uint32_t Channels;
+  bool Float;
+};
+
+std::optional<ChannelLayout>
+GetChannelLayout(PixelFormat format)
+{
+  switch (format) {
+    case PixelFormat::u8_RGBA:
+      return ChannelLayout{ 4, false };
+    case PixelFormat::u8_RGB:
+      return ChannelLayout{ 3, false };
+    case PixelFormat::u8_R:
+      return ChannelLayout{ 1, false };
+    case PixelFormat::f16_RGB:
+    case PixelFormat::f32_RGB:
+      // float pixels. see ImageLoader::LoadHdr
+      return ChannelLayout{ 3, true };
+    case PixelFormat::f16_RG:
+      return ChannelLayout{ 2, true };
+    default:
+      // compressed
+      break;
+  }
+  return std::nullopt;
+}
+
+float
+SrgbToLinear(float c)
+{
+  return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+struct SrgbTable
+{
+  float Decode[256];
+  // linear values halfway between the codes. encode is the number below
+  float Thresholds[255];
+
+  SrgbTable()
+  {
+    for (int i = 0; i < 256; ++i) {
+      Decode[i] = SrgbToLinear(i / 255.0f);
+    }
+    for (int i = 0; i < 255; ++i) {
+      Thresholds[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+    }
+  }
+
+  uint8_t Encode(float linear) const
+  {
+    return std::upper_bound(Thresholds, Thresholds + 255, linear) -
+           Thresholds;
+  }
+};
+
+const SrgbTable&
+Srgb()
+{
+  static SrgbTable s_table;
+  return s_table;
+}
+
+// rgba float, one Float4 per pixel
+struct FloatImage
+{
+  int Width = 0;
+  int Height = 0;
+  std::vector<float> Pixels;
+
+  void Resize(int width, int height)
+  {
+    Width = width;
+    Height = height;
+    Pixels.resize(width * height * 4);
+  }
+  float* Row(int y) { return Pixels.data() + y * Width * 4; }
+  const float* Row(int y) const { return Pixels.data() + y * Width * 4; }
+};
+
+void
+ToFloat(const uint8_t* src,
+        ChannelLayout layout,
+        bool srgb,
+        FloatImage& dst,
+        uint32_t threadCount)
+{
+  auto& table = Srgb();
+  ParallelFor(
+    dst.Height,
+    [&](uint32_t y) {
+      auto out = dst.Row(y);
+      auto count = dst.Width;
+      if (layout.Float) {
+        auto in = reinterpret_cast<const float*>(src) +
+                  y * dst.Width * layout.Channels;
+        for (int x = 0; x < count; ++x, in += layout.Channels, out += 4) {
+          for (uint32_t c = 0; c < 4; ++c) {
+            out[c] = c < layout.Channels ? in[c] : (c == 3 ? 1.0f : 0.0f);
+          }
+        }
+      } else {
+        auto in = src + y * dst.Width * layout.Channels;
+        for (int x = 0; x < count; ++x, in += layout.Channels, out += 4) {
+          for (uint32_t c = 0; c < 4; ++c) {
+            if (c >= layout.Channels) {
+              out[c] = c == 3 ? 1.0f : 0.0f;
+            } else if (srgb && c < 3) {
+              out[c] = table.Decode[in[c]];
+            } else {
+              out[c] = in[c] / 255.0f;
+            }
+          }
+        }
+      }
+    },
+    threadCount);
+}
+
+void
+FromFloat(const FloatImage& src,
+          ChannelLayout layout,
+          bool srgb,
+          uint8_t* dst,
+          uint32_t threadCount)
+{
+  auto& table = Srgb();
+  ParallelFor(
+    src.Height,
+    [&](uint32_t y) {
+      auto in = src.Row(y);
+      auto count = src.Width;
+      if (layout.Float) {
+        auto out =
+          reinterpret_cast<float*>(dst) + y * src.Width * layout.Channels;
+        for (int x = 0; x < count; ++x, in += 4, out += layout.Channels) {
+          memcpy(out, in, layout.Channels * sizeof(float));
+        }
+      } else {
+        auto out = dst + y * src.Width * layout.Channels;
+        for (int x = 0; x < count; ++x, in += 4, out += layout.Channels) {
+          for (uint32_t c = 0; c < layout.Channels; ++c) {
+            auto v = std::clamp(in[c], 0.0f, 1.0f);
+            out[c] = srgb && c < 3
+                       ? table.Encode(v)
+                       : static_cast<uint8_t>(v * 255.0f + 0.5f);
+          }
+        }
+      }
+    },
+    threadCount);
+}
+
+//
+// a 2:1 kernel. dst pixel x reads src x * 2 + First ... + Taps - 1, clamped
+//
+struct Kernel
+{
+  int First;
+  std::vector<float> Weights;
+};
+
+float
+BesselI0(float x)
+{
+  float sum = 1;
+  float term = 1;
+  for (int k = 1; k < 16; ++k) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+Kernel
+MakeKernel(MipFilter filter)
+{
+  if (filter == MipFilter::Box) {
+    return { 0, { 0.5f, 0.5f } };
+  }
+
+  // lowpass at the dst nyquist. t in dst pixels from the dst center
+  const float RADIUS = 1.5f;
+  const float ALPHA = 4.0f;
+  Kernel kernel{ -2, {} };
+  float sum = 0;
+  for (int i = -2; i <= 3; ++i) {
+    auto t = (i + 0.5f - 1.0f) / 2.0f;
+    auto x = static_cast<float>(M_PI) * t;
+    auto sinc = x == 0 ? 1.0f : sinf(x) / x;
+    auto r = t / RADIUS;
+    auto window = BesselI0(ALPHA * sqrtf(std::max(0.0f, 1 - r * r))) /
+                  BesselI0(ALPHA);
+    kernel.Weights.push_back(sinc * window);
+    sum += kernel.Weights.back();
+  }
+  for (auto& w : kernel.Weights) {
+    w /= sum;
+  }
+  return kernel;
+}
+
+// a size of 1 is copied
+void
+DownsampleX(const FloatImage& src,
+            FloatImage& dst,
+            const Kernel& kernel,
+            uint32_t threadCount)
+{
+  ParallelFor(
+    src.Height,
+    [&](uint32_t y) {
+      auto in = src.Row(y);
+      auto out = dst.Row(y);
+      for (int x = 0; x < dst.Width; ++x) {
+        if (src.Width == 1) {
+          simd::Float4::Load(in).Store(out + x * 4);
+          continue;
+        }
+        simd::Float4 sum(0.0f);
+        for (size_t i = 0; i < kernel.Weights.size(); ++i) {
+          auto sx = std::clamp(
+            x * 2 + kernel.First + static_cast<int>(i), 0, src.Width - 1);
+          sum += simd::Float4::Load(in + sx * 4) *
+                 simd::Float4(kernel.Weights[i]);
+        }
+        sum.Store(out + x * 4);
+      }
+    },
+    threadCount);
+}
+
+void
+DownsampleY(const FloatImage& src,
+            FloatImage& dst,
+            const Kernel& kernel,
+            uint32_t threadCount)
+{
+  ParallelFor(
+    dst.Height,
+    [&](uint32_t y) {
+      auto out = dst.Row(y);
+      if (src.Height == 1) {
+        memcpy(out, src.Row(0), src.Width * 4 * sizeof(float));
+        return;
+      }
+      const float* rows[8];
+      for (size_t i = 0; i < kernel.Weights.size(); ++i) {
+        rows[i] = src.Row(std::clamp(
+          static_cast<int>(y * 2 + kernel.First + i), 0, src.Height - 1));
+      }
+      for (int x = 0; x < dst.Width * 4; x += 4) {
+        simd::Float4 sum(0.0f);
+        for (size_t i = 0; i < kernel.Weights.size(); ++i) {
+          sum +=
+            simd::Float4::Load(rows[i] + x) * simd::Float4(kernel.Weights[i]);
+        }
+        sum.Store(out + x);
+      }
+    },
+    threadCount);
+}
+
+} // namespace
+
+bool
+MipChain::Generate(MipFilter filter, uint32_t threadCount)
+{
+  auto layout = GetChannelLayout(Format);
+  if (!layout || Levels.empty()) {
+    return false;
+  }
+  bool srgb = ColorSpace == ColorSpace::sRGB && !layout->Float;
+  auto bytesPerPixel = BytesPerPixel(Format);
+
+  Levels.resize(1);
+  auto width = Levels[0].Width;
+  auto height = Levels[0].Height;
+  uint32_t offset = Levels[0].Size;
+  while (width > 1 || height > 1) {
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+    uint32_t size = width * height * bytesPerPixel;
+    Levels.push_back({ width, height, offset, size });
+    offset += size;
+  }
+  Pixels.resize(offset);
+
+  // each level from the float of the previous one, not from the 8 bit
+  auto kernel = MakeKernel(filter);
+  FloatImage src;
+  src.Resize(Levels[0].Width, Levels[0].Height);
+  ToFloat(Pixels.data(), *layout, srgb, src, threadCount);
+  FloatImage tmp;
+  FloatImage dst;
+  for (size_t i = 1; i < Levels.size(); ++i) {
+    auto& level = Levels[i];
+    tmp.Resize(level.Width, src.Height);
+    DownsampleX(src, tmp, kernel, threadCount);
+    dst.Resize(level.Width, level.Height);
+    DownsampleY(tmp, dst, kernel, threadCount);
+    FromFloat(dst, *layout, srgb, Pixels.data() + level.Offset, threadCount);
+    std::swap(src, dst);
+  }
+  return true;
+}
+
+}
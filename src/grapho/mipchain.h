@@ -0,0 +1,59 @@
+#pragma once
+#include "image.h"
+#include <stdint.h>
+#include <vector>
+
+namespace grapho {
+
+enum class MipFilter
+{
+  // 2x2 average
+  Box,
+  // 6 tap windowed sinc, alpha 4. sharper, keeps fine detail
+  Kaiser,
+};
+
+struct MipLevel
+{
+  int Width;
+  int Height;
+  // in MipChain::Pixels
+  uint32_t Offset;
+  uint32_t Size;
+};
+
+//
+// an image and its mip levels in one allocation, the largest first.
+// levels are tightly packed rows, GL_UNPACK_ALIGNMENT 1.
+//
+struct MipChain
+{
+  PixelFormat Format = PixelFormat::u8_RGBA;
+  grapho::ColorSpace ColorSpace = ColorSpace::Linear;
+  std::vector<uint8_t> Pixels;
+  std::vector<MipLevel> Levels;
+
+  // level 0 only
+  static MipChain FromImage(const Image& image);
+
+  uint32_t LevelCount() const { return Levels.size(); }
+  Image Level(uint32_t level) const
+  {
+    auto& mip = Levels[level];
+    return {
+      .Width = mip.Width,
+      .Height = mip.Height,
+      .Format = Format,
+      .ColorSpace = ColorSpace,
+      .Pixels = Pixels.data() + mip.Offset,
+    };
+  }
+
+  // the levels below level 0 down to 1x1. filtered in linear float, sRGB
+  // color is decoded first and alpha is always linear. threadCount 0 uses
+  // all hardware threads, 1 runs on the calling thread. false for a
+  // compressed format, generate before EncodeBlocks.
+  bool Generate(MipFilter filter = MipFilter::Box, uint32_t threadCount = 0);
+};
+
+}
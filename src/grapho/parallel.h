@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace grapho {
+
+inline uint32_t
+HardwareThreadCount()
+{
+  auto count = std::thread::hardware_concurrency();
+  return count ? count : 1;
+}
+
+// call func(i) for i in [0, count) from threadCount workers.
+// work is handed out one index at a time, so uneven items balance out.
+template<typename F>
+inline void
+ParallelFor(uint32_t count, const F& func, uint32_t threadCount = 0)
+{
+  if (threadCount == 0) {
+    threadCount = HardwareThreadCount();
+  }
+  threadCount = std::min(threadCount, count);
+  if (threadCount <= 1) {
+    for (uint32_t i = 0; i < count; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  std::atomic<uint32_t> next = 0;
+  auto worker = [&]() {
+    for (uint32_t i = next++; i < count; i = next++) {
+      func(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+  for (uint32_t i = 1; i < threadCount; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+// long lived workers for background jobs, e.g. image decode.
+// the destructor drops the jobs not started yet and joins.
+class ThreadPool
+{
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> jobs_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+
+  void Work()
+  {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+        if (stop_) {
+          return;
+        }
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      job();
+    }
+  }
+
+public:
+  ThreadPool(uint32_t threadCount = 0)
+  {
+    if (threadCount == 0) {
+      threadCount = HardwareThreadCount();
+    }
+    for (uint32_t i = 0; i < threadCount; ++i) {
+      threads_.emplace_back([this]() { Work(); });
+    }
+  }
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  uint32_t ThreadCount() const { return threads_.size(); }
+
+  void Push(std::function<void()> job)
+  {
+    {
+      std::lock_guard lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+  }
+};
+
+}
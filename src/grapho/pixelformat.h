@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 
 namespace grapho {
 
@@ -10,6 +11,84 @@ enum class PixelFormat
   u8_R,
   f16_RGB,
   f32_RGB,
+  // 2 channel lut
+  f16_RG,
+  // 4x4 blocks. see bcencoder.h
+  bc1_RGB,
+  // bc1 color and bc4 alpha
+  bc3_RGBA,
+  bc4_R,
+  // normal map xy
+  bc5_RG,
+  bc7_RGBA,
 };
 
+inline bool
+IsCompressed(PixelFormat format)
+{
+  switch (format) {
+    case PixelFormat::bc1_RGB:
+    case PixelFormat::bc3_RGBA:
+    case PixelFormat::bc4_R:
+    case PixelFormat::bc5_RG:
+    case PixelFormat::bc7_RGBA:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// bytes of a pixel. 0 for a compressed format
+inline uint32_t
+BytesPerPixel(PixelFormat format)
+{
+  switch (format) {
+    case PixelFormat::u8_RGBA:
+      return 4;
+    case PixelFormat::u8_RGB:
+      return 3;
+    case PixelFormat::u8_R:
+      return 1;
+    case PixelFormat::f16_RGB:
+    case PixelFormat::f32_RGB:
+      // float pixels. see ImageLoader::LoadHdr
+      return 12;
+    case PixelFormat::f16_RG:
+      return 8;
+    default:
+      break;
+  }
+  return 0;
+}
+
+// bytes of a 4x4 block. 0 for an uncompressed format
+inline uint32_t
+BytesPerBlock(PixelFormat format)
+{
+  switch (format) {
+    case PixelFormat::bc1_RGB:
+    case PixelFormat::bc4_R:
+      return 8;
+    case PixelFormat::bc3_RGBA:
+    case PixelFormat::bc5_RG:
+    case PixelFormat::bc7_RGBA:
+      return 16;
+    default:
+      break;
+  }
+  return 0;
+}
+
+// the partial blocks at the right and bottom edges count as whole. 64 bit,
+// width and height may come from a file
+inline uint64_t
+ImageSize(PixelFormat format, int width, int height)
+{
+  if (IsCompressed(format)) {
+    return ((uint64_t(width) + 3) / 4) * ((uint64_t(height) + 3) / 4) *
+           BytesPerBlock(format);
+  }
+  return uint64_t(width) * uint64_t(height) * BytesPerPixel(format);
+}
+
 }
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <span>
+#include <stdint.h>
+
+namespace grapho {
+
+struct SortKey
+{
+  uint64_t Key;
+  // of the sorted item
+  uint32_t Index;
+};
+
+// lsd radix sort by Key, 8 bits per pass. stable. a pass where every key
+// has the same digit is skipped, so keys that differ only in a few bytes
+// take a few passes. temp is the same size as keys.
+inline void
+RadixSort(std::span<SortKey> keys, std::span<SortKey> temp)
+{
+  if (keys.size() < 2) {
+    return;
+  }
+  auto src = keys.data();
+  auto dst = temp.data();
+  auto count = keys.size();
+
+  uint32_t histograms[8][256] = {};
+  for (size_t i = 0; i < count; ++i) {
+    auto key = src[i].Key;
+    for (int pass = 0; pass < 8; ++pass) {
+      ++histograms[pass][(key >> (pass * 8)) & 0xFF];
+    }
+  }
+
+  for (int pass = 0; pass < 8; ++pass) {
+    auto& histogram = histograms[pass];
+    if (histogram[(src[0].Key >> (pass * 8)) & 0xFF] == count) {
+      continue;
+    }
+    uint32_t offset = 0;
+    for (auto& bucket : histogram) {
+      auto n = bucket;
+      bucket = offset;
+      offset += n;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      dst[histogram[(src[i].Key >> (pass * 8)) & 0xFF]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+
+  if (src != keys.data()) {
+    std::copy(src, src + count, keys.data());
+  }
+}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdint.h>
+
+namespace grapho {
+
+//
+// ranges of [0, capacity) in any unit, e.g. vertices of a shared buffer.
+// best fit from the free blocks, and a freed range merges with its free
+// neighbours.
+//
+class RangeAllocator
+{
+  uint32_t capacity_ = 0;
+  uint32_t free_ = 0;
+  // offset to size
+  std::map<uint32_t, uint32_t> blocks_;
+  // size to offset
+  std::multimap<uint32_t, uint32_t> sizes_;
+
+  void Insert(uint32_t offset, uint32_t size)
+  {
+    blocks_.insert({ offset, size });
+    sizes_.insert({ size, offset });
+  }
+
+  void Erase(std::map<uint32_t, uint32_t>::iterator block)
+  {
+    auto [begin, end] = sizes_.equal_range(block->second);
+    for (auto it = begin; it != end; ++it) {
+      if (it->second == block->first) {
+        sizes_.erase(it);
+        break;
+      }
+    }
+    blocks_.erase(block);
+  }
+
+public:
+  RangeAllocator(uint32_t capacity = 0) { Reset(capacity, 0); }
+
+  uint32_t Capacity() const { return capacity_; }
+  uint32_t FreeSize() const { return free_; }
+  uint32_t FreeBlockCount() const { return blocks_.size(); }
+  uint32_t LargestFreeBlock() const
+  {
+    return sizes_.empty() ? 0 : sizes_.rbegin()->first;
+  }
+
+  // everything free from used. after compacting the allocations to the front
+  void Reset(uint32_t capacity, uint32_t used)
+  {
+    capacity_ = capacity;
+    blocks_.clear();
+    sizes_.clear();
+    free_ = capacity - used;
+    if (free_) {
+      Insert(used, free_);
+    }
+  }
+
+  std::optional<uint32_t> Allocate(uint32_t size)
+  {
+    if (size == 0) {
+      return std::nullopt;
+    }
+    auto found = sizes_.lower_bound(size);
+    if (found == sizes_.end()) {
+      return std::nullopt;
+    }
+    auto offset = found->second;
+    auto block = blocks_.find(offset);
+    auto rest = block->second - size;
+    Erase(block);
+    if (rest) {
+      Insert(offset + size, rest);
+    }
+    free_ -= size;
+    return offset;
+  }
+
+  void Free(uint32_t offset, uint32_t size)
+  {
+    if (size == 0) {
+      return;
+    }
+    free_ += size;
+    auto next = blocks_.lower_bound(offset);
+    if (next != blocks_.end() && offset + size == next->first) {
+      size += next->second;
+      Erase(next);
+    }
+    next = blocks_.lower_bound(offset);
+    if (next != blocks_.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        offset = prev->first;
+        size += prev->second;
+        Erase(prev);
+      }
+    }
+    Insert(offset, size);
+  }
+};
+
+}
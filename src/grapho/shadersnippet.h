@@ -1,5 +1,7 @@
 #pragma once
+#include <assert.h>
 #include <ostream>
+#include <stdint.h>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -26,6 +28,8 @@ struct ShaderVariable
 {
   ShaderTypes Type;
   std::string Name;
+  // Feature bits. declared only if all are enabled
+  uint32_t Features = 0;
 };
 inline std::ostream&
 operator<<(std::ostream& os, const ShaderVariable& var)
@@ -34,27 +38,67 @@ operator<<(std::ostream& os, const ShaderVariable& var)
   return os;
 }
 
+struct ShaderCode
+{
+  std::string Code;
+  // Feature bits. emitted only if all are enabled
+  uint32_t Features = 0;
+};
+inline std::ostream&
+operator<<(std::ostream& os, const ShaderCode& code)
+{
+  os << code.Code;
+  return os;
+}
+
+//
+// a variant of the snippet is selected by a bitmask of Features. the
+// generator emits "#define NAME" for each enabled feature and skips the
+// variables and codes whose Features are not all enabled.
+//
+//   auto NORMAL_MAP = snippet.Feature("NORMAL_MAP");
+//   snippet.Uniform(ShaderTypes::sampler2D, "normalMap", NORMAL_MAP);
+//   GenerateFS(snippet, NORMAL_MAP);
+//
 struct ShaderSnippet
 {
   std::vector<ShaderVariable> Inputs;
   std::vector<ShaderVariable> Outputs;
   std::vector<ShaderVariable> Uniforms;
-  std::vector<std::string> Codes;
-  void In(ShaderTypes type, std::string_view name)
+  std::vector<ShaderCode> Codes;
+  // the name of bit i. up to 32
+  std::vector<std::string> Features;
+  uint32_t Feature(std::string_view name)
+  {
+    for (size_t i = 0; i < Features.size(); ++i) {
+      if (Features[i] == name) {
+        return 1u << i;
+      }
+    }
+    assert(Features.size() < 32);
+    Features.push_back({ name.begin(), name.end() });
+    return 1u << (Features.size() - 1);
+  }
+  // the bits of the defined features
+  uint32_t FeatureMask() const
+  {
+    return Features.size() < 32 ? (1u << Features.size()) - 1 : 0xFFFFFFFF;
+  }
+  void In(ShaderTypes type, std::string_view name, uint32_t features = 0)
   {
-    Inputs.push_back({ type, { name.begin(), name.end() } });
+    Inputs.push_back({ type, { name.begin(), name.end() }, features });
   }
-  void Out(ShaderTypes type, std::string_view name)
+  void Out(ShaderTypes type, std::string_view name, uint32_t features = 0)
   {
-    Outputs.push_back({ type, { name.begin(), name.end() } });
+    Outputs.push_back({ type, { name.begin(), name.end() }, features });
   }
-  void Uniform(ShaderTypes type, std::string_view name)
+  void Uniform(ShaderTypes type, std::string_view name, uint32_t features = 0)
   {
-    Uniforms.push_back({ type, { name.begin(), name.end() } });
+    Uniforms.push_back({ type, { name.begin(), name.end() }, features });
   }
-  void Code(std::string_view code)
+  void Code(std::string_view code, uint32_t features = 0)
   {
-    Codes.push_back({ code.begin(), code.end() });
+    Codes.push_back({ { code.begin(), code.end() }, features });
   }
 };
 
@@ -62,25 +106,48 @@ struct VertexAndFragment
 {
   ShaderSnippet VS;
   ShaderSnippet FS;
-  void Attribute(ShaderTypes type, std::string_view name) { VS.In(type, name); }
-  void VsToFs(ShaderTypes type, std::string_view name)
+  // the same bit in both stages
+  uint32_t Feature(std::string_view name)
+  {
+    auto bit = VS.Feature(name);
+    [[maybe_unused]] auto fs = FS.Feature(name);
+    assert(fs == bit);
+    return bit;
+  }
+  uint32_t FeatureMask() const { return VS.FeatureMask(); }
+  void Attribute(ShaderTypes type,
+                 std::string_view name,
+                 uint32_t features = 0)
+  {
+    VS.In(type, name, features);
+  }
+  void VsToFs(ShaderTypes type, std::string_view name, uint32_t features = 0)
+  {
+    VS.Out(type, name, features);
+    FS.In(type, name, features);
+  }
+  void Out(ShaderTypes type, std::string_view name, uint32_t features = 0)
+  {
+    FS.Out(type, name, features);
+  }
+  void Uniform(ShaderTypes type, std::string_view name, uint32_t features = 0)
+  {
+    VS.Uniform(type, name, features);
+    FS.Uniform(type, name, features);
+  }
+  void Code(std::string_view code, uint32_t features = 0)
   {
-    VS.Out(type, name);
-    FS.In(type, name);
+    VS.Code(code, features);
+    FS.Code(code, features);
   }
-  void Out(ShaderTypes type, std::string_view name) { FS.Out(type, name); }
-  void Uniform(ShaderTypes type, std::string_view name)
+  void VsEntry(std::string_view code, uint32_t features = 0)
   {
-    VS.Uniform(type, name);
-    FS.Uniform(type, name);
+    VS.Code(code, features);
   }
-  void Code(std::string_view code)
+  void FsEntry(std::string_view code, uint32_t features = 0)
   {
-    VS.Code(code);
-    FS.Code(code);
+    FS.Code(code, features);
   }
-  void VsEntry(std::string_view code) { VS.Code(code); }
-  void FsEntry(std::string_view code) { FS.Code(code); }
 };
 
 }
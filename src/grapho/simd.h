@@ -0,0 +1,92 @@
+#pragma once
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRAPHO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace grapho {
+namespace simd {
+
+// 4 lane float. SSE2 when available, scalar otherwise.
+struct Float4
+{
+#ifdef GRAPHO_SSE2
+  __m128 v;
+  Float4() {}
+  Float4(__m128 _v)
+    : v(_v)
+  {
+  }
+  explicit Float4(float s)
+    : v(_mm_set1_ps(s))
+  {
+  }
+  Float4(float x, float y, float z, float w)
+    : v(_mm_setr_ps(x, y, z, w))
+  {
+  }
+  static Float4 Load(const float* p) { return _mm_loadu_ps(p); }
+  void Store(float* p) const { _mm_storeu_ps(p, v); }
+  friend Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+  friend Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+  friend Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+  friend Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+  friend Float4 Min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+  friend Float4 Max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+  friend Float4 Sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+  float operator[](int i) const
+  {
+    alignas(16) float f[4];
+    _mm_store_ps(f, v);
+    return f[i];
+  }
+#else
+  float v[4];
+  Float4() {}
+  explicit Float4(float s)
+    : v{ s, s, s, s }
+  {
+  }
+  Float4(float x, float y, float z, float w)
+    : v{ x, y, z, w }
+  {
+  }
+  static Float4 Load(const float* p) { return { p[0], p[1], p[2], p[3] }; }
+  void Store(float* p) const
+  {
+    for (int i = 0; i < 4; ++i) {
+      p[i] = v[i];
+    }
+  }
+#define GRAPHO_FLOAT4_OP(NAME, EXPR)                                           \
+  friend Float4 NAME(Float4 a, Float4 b)                                       \
+  {                                                                            \
+    Float4 r;                                                                  \
+    for (int i = 0; i < 4; ++i) {                                              \
+      r.v[i] = EXPR;                                                           \
+    }                                                                          \
+    return r;                                                                  \
+  }
+  GRAPHO_FLOAT4_OP(operator+, a.v[i] + b.v[i])
+  GRAPHO_FLOAT4_OP(operator-, a.v[i] - b.v[i])
+  GRAPHO_FLOAT4_OP(operator*, a.v[i] * b.v[i])
+  GRAPHO_FLOAT4_OP(operator/, a.v[i] / b.v[i])
+  GRAPHO_FLOAT4_OP(Min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+  GRAPHO_FLOAT4_OP(Max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef GRAPHO_FLOAT4_OP
+  friend Float4 Sqrt(Float4 a)
+  {
+    return { sqrtf(a.v[0]), sqrtf(a.v[1]), sqrtf(a.v[2]), sqrtf(a.v[3]) };
+  }
+  float operator[](int i) const { return v[i]; }
+#endif
+
+  Float4& operator+=(Float4 b) { return *this = *this + b; }
+  Float4& operator*=(Float4 b) { return *this = *this * b; }
+};
+
+}
+}
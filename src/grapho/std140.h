@@ -0,0 +1,135 @@
+#pragma once
+#include <span>
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <type_traits>
+
+namespace grapho {
+
+//
+// the std140 layout of a C++ struct uploaded to a uniform block, described
+// at compile time so it can be checked against the block of a linked
+// program. see gl3::MatchUniformBlock.
+//
+//   template<>
+//   struct Std140Layout<WorldVars>
+//   {
+//     static constexpr Std140Member Members[] = {
+//       GRAPHO_STD140_MEMBER(WorldVars, projection, Mat4),
+//       ...
+//     };
+//   };
+//   static_assert(IsStd140(Std140Layout<WorldVars>::Members));
+//
+
+// the GLSL type of a member
+enum class Std140Type
+{
+  Float,
+  Int,
+  UInt,
+  Vec2,
+  Vec3,
+  Vec4,
+  IVec4,
+  UVec4,
+  // 3 vec4 columns, 48 bytes. as XMFLOAT3X4, not XMFLOAT3X3
+  Mat3,
+  Mat4,
+};
+
+struct Std140Member
+{
+  std::string_view Name;
+  Std140Type Type;
+  uint32_t Offset;
+  // 0 if not an array
+  uint32_t ArraySize;
+  // sizeof the C++ member
+  uint32_t Size;
+};
+
+template<typename T>
+struct Std140Layout;
+
+// base alignment of a non array member
+constexpr uint32_t
+Std140Alignment(Std140Type type)
+{
+  switch (type) {
+    case Std140Type::Float:
+    case Std140Type::Int:
+    case Std140Type::UInt:
+      return 4;
+    case Std140Type::Vec2:
+      return 8;
+    default:
+      return 16;
+  }
+}
+
+constexpr uint32_t
+Std140Size(Std140Type type)
+{
+  switch (type) {
+    case Std140Type::Float:
+    case Std140Type::Int:
+    case Std140Type::UInt:
+      return 4;
+    case Std140Type::Vec2:
+      return 8;
+    case Std140Type::Vec3:
+      return 12;
+    case Std140Type::Mat3:
+      return 48;
+    case Std140Type::Mat4:
+      return 64;
+    default:
+      return 16;
+  }
+}
+
+// an array element is rounded up to a vec4
+constexpr uint32_t
+Std140Stride(Std140Type type)
+{
+  return (Std140Size(type) + 15) & ~15u;
+}
+
+constexpr bool
+IsStd140(const Std140Member& member)
+{
+  if (member.ArraySize) {
+    return member.Offset % 16 == 0 &&
+           member.Size == Std140Stride(member.Type) * member.ArraySize;
+  }
+  return member.Offset % Std140Alignment(member.Type) == 0 &&
+         member.Size == Std140Size(member.Type);
+}
+
+// every member aligned, sized and in order without overlap
+constexpr bool
+IsStd140(std::span<const Std140Member> members)
+{
+  uint32_t end = 0;
+  for (auto& member : members) {
+    if (!IsStd140(member) || member.Offset < end) {
+      return false;
+    }
+    end = member.Offset + member.Size;
+  }
+  return true;
+}
+
+}
+
+// a Std140Layout entry. offset, array size and size from the member
+#define GRAPHO_STD140_MEMBER(T, MEMBER, TYPE)                                  \
+  grapho::Std140Member                                                         \
+  {                                                                            \
+    .Name = #MEMBER, .Type = grapho::Std140Type::TYPE,                         \
+    .Offset = offsetof(T, MEMBER),                                             \
+    .ArraySize = std::extent_v<decltype(T::MEMBER)>,                           \
+    .Size = sizeof(T::MEMBER),                                                 \
+  }
@@ -0,0 +1,212 @@
+#include "texturefile.h"
+#include <algorithm>
+#include <fstream>
+#include <stdio.h>
+
+namespace grapho {
+
+static uint64_t
+Align16(uint64_t offset)
+{
+  return (offset + 15) & ~15ull;
+}
+
+static bool
+IsSameLevels(const MipChain& lhs, const MipChain& rhs)
+{
+  if (lhs.Format != rhs.Format || lhs.ColorSpace != rhs.ColorSpace ||
+      lhs.Levels.size() != rhs.Levels.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.Levels.size(); ++i) {
+    if (lhs.Levels[i].Width != rhs.Levels[i].Width ||
+        lhs.Levels[i].Height != rhs.Levels[i].Height) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+WriteTextureFile(const std::string& path, std::span<const MipChain> faces)
+{
+  if (faces.size() != 1 && faces.size() != 6) {
+    return false;
+  }
+  auto& first = faces[0];
+  if (first.Levels.empty()) {
+    return false;
+  }
+  for (auto& face : faces) {
+    if (!IsSameLevels(face, first)) {
+      return false;
+    }
+  }
+
+  std::vector<TextureFileLevel> entries;
+  std::vector<const uint8_t*> pixels;
+  for (uint32_t i = 0; i < first.LevelCount(); ++i) {
+    for (auto& face : faces) {
+      auto& level = face.Levels[i];
+      entries.push_back({
+        .Width = static_cast<uint32_t>(level.Width),
+        .Height = static_cast<uint32_t>(level.Height),
+        .Size = level.Size,
+      });
+      pixels.push_back(face.Pixels.data() + level.Offset);
+    }
+  }
+
+  auto offset = Align16(sizeof(TextureFileHeader) +
+                        sizeof(TextureFileLevel) * entries.size());
+  for (auto& entry : entries) {
+    entry.Offset = offset;
+    offset = Align16(offset + entry.Size);
+  }
+
+  // write to a temporary and rename, so a reader never maps a partial file
+  auto tmp = path + ".tmp";
+  {
+    std::ofstream os(tmp, std::ios::binary);
+    if (!os) {
+      return false;
+    }
+    TextureFileHeader header{
+      .Magic = TEXTURE_FILE_MAGIC,
+      .Version = TEXTURE_FILE_VERSION,
+      .Format = first.Format,
+      .ColorSpace = first.ColorSpace,
+      .Width = static_cast<uint32_t>(first.Levels[0].Width),
+      .Height = static_cast<uint32_t>(first.Levels[0].Height),
+      .LevelCount = first.LevelCount(),
+      .FaceCount = static_cast<uint32_t>(faces.size()),
+    };
+    os.write((const char*)&header, sizeof(header));
+    os.write((const char*)entries.data(),
+             sizeof(TextureFileLevel) * entries.size());
+    uint64_t pos = sizeof(header) + sizeof(TextureFileLevel) * entries.size();
+    const char zero[16] = {};
+    for (size_t i = 0; i < entries.size(); ++i) {
+      os.write(zero, entries[i].Offset - pos);
+      os.write((const char*)pixels[i], entries[i].Size);
+      pos = entries[i].Offset + entries[i].Size;
+    }
+    if (!os) {
+      return false;
+    }
+  }
+  remove(path.c_str());
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+std::vector<Image>
+TextureFileView::Images() const
+{
+  std::vector<Image> images;
+  for (uint32_t i = 0; i < Header->LevelCount; ++i) {
+    for (uint32_t face = 0; face < Header->FaceCount; ++face) {
+      images.push_back(ToImage(i, face));
+    }
+  }
+  return images;
+}
+
+MipChain
+TextureFileView::ToMipChain(uint32_t face) const
+{
+  MipChain chain;
+  chain.Format = Header->Format;
+  chain.ColorSpace = Header->ColorSpace;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < Header->LevelCount; ++i) {
+    auto& entry = Level(i, face);
+    chain.Levels.push_back({
+      static_cast<int>(entry.Width),
+      static_cast<int>(entry.Height),
+      offset,
+      static_cast<uint32_t>(entry.Size),
+    });
+    offset += entry.Size;
+  }
+  chain.Pixels.resize(offset);
+  for (uint32_t i = 0; i < Header->LevelCount; ++i) {
+    auto& entry = Level(i, face);
+    std::copy(File->Data() + entry.Offset,
+              File->Data() + entry.Offset + entry.Size,
+              chain.Pixels.data() + chain.Levels[i].Offset);
+  }
+  return chain;
+}
+
+static bool
+IsKnownFormat(PixelFormat format)
+{
+  return IsCompressed(format) || BytesPerPixel(format) > 0;
+}
+
+static bool
+IsKnownColorSpace(ColorSpace colorspace)
+{
+  return colorspace == ColorSpace::Linear || colorspace == ColorSpace::sRGB;
+}
+
+static uint32_t
+FullLevelCount(uint32_t width, uint32_t height)
+{
+  uint32_t levels = 1;
+  while ((std::max(width, height) >> levels) > 0) {
+    ++levels;
+  }
+  return levels;
+}
+
+std::optional<TextureFileView>
+OpenTextureFile(const std::string& path)
+{
+  auto file = MappedFile::Open(path);
+  if (!file || file->Size() < sizeof(TextureFileHeader)) {
+    return std::nullopt;
+  }
+  auto header = (const TextureFileHeader*)file->Data();
+  if (header->Magic != TEXTURE_FILE_MAGIC ||
+      header->Version != TEXTURE_FILE_VERSION ||
+      !IsKnownFormat(header->Format) ||
+      !IsKnownColorSpace(header->ColorSpace) || header->Width == 0 ||
+      header->Height == 0 || header->Width > TEXTURE_FILE_MAX_SIZE ||
+      header->Height > TEXTURE_FILE_MAX_SIZE || header->LevelCount == 0 ||
+      header->LevelCount > FullLevelCount(header->Width, header->Height) ||
+      (header->FaceCount != 1 && header->FaceCount != 6)) {
+    return std::nullopt;
+  }
+  uint64_t count = uint64_t(header->LevelCount) * header->FaceCount;
+  if (sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * count >
+      file->Size()) {
+    return std::nullopt;
+  }
+  std::span<const TextureFileLevel> levels{
+    (const TextureFileLevel*)(file->Data() + sizeof(TextureFileHeader)),
+    static_cast<size_t>(count),
+  };
+  // a MipChain of a face has 32 bit offsets
+  std::vector<uint64_t> faceSizes(header->FaceCount);
+  for (size_t i = 0; i < levels.size(); ++i) {
+    auto& level = levels[i];
+    auto mip = i / header->FaceCount;
+    if (level.Width != std::max(header->Width >> mip, 1u) ||
+        level.Height != std::max(header->Height >> mip, 1u) ||
+        level.Size !=
+          ImageSize(header->Format, level.Width, level.Height) ||
+        level.Offset > file->Size() ||
+        level.Size > file->Size() - level.Offset) {
+      return std::nullopt;
+    }
+    auto& faceSize = faceSizes[i % header->FaceCount];
+    faceSize += level.Size;
+    if (faceSize > UINT32_MAX) {
+      return std::nullopt;
+    }
+  }
+  return TextureFileView{ file, header, levels };
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "mappedfile.h"
+#include "mipchain.h"
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace grapho {
+
+// file layout
+//
+// TextureFileHeader
+// TextureFileLevel[LevelCount * FaceCount]. level 0 of every face first
+// pixels. each level 16 byte aligned at Offset from the file head.
+//
+// pixels are tightly packed rows, or 4x4 blocks of a compressed format. can
+// be passed to glTexImage2D or glCompressedTexImage2D as is.
+
+const uint32_t TEXTURE_FILE_MAGIC = 0x58545247; // "GRTX"
+const uint32_t TEXTURE_FILE_VERSION = 1;
+// width and height. gl3::Texture::Upload also checks GL_MAX_TEXTURE_SIZE
+const uint32_t TEXTURE_FILE_MAX_SIZE = 32768;
+
+struct TextureFileHeader
+{
+  uint32_t Magic;
+  uint32_t Version;
+  PixelFormat Format;
+  grapho::ColorSpace ColorSpace;
+  uint32_t Width;
+  uint32_t Height;
+  uint32_t LevelCount;
+  // 1, or 6 for a cubemap. +x, -x, +y, -y, +z, -z
+  uint32_t FaceCount;
+};
+static_assert(sizeof(TextureFileHeader) == 32);
+
+struct TextureFileLevel
+{
+  uint32_t Width;
+  uint32_t Height;
+  uint64_t Offset;
+  uint64_t Size;
+};
+static_assert(sizeof(TextureFileLevel) == 24);
+
+// a chain per face. the faces must have the same format and levels
+bool
+WriteTextureFile(const std::string& path, std::span<const MipChain> faces);
+
+inline bool
+WriteTextureFile(const std::string& path, const MipChain& chain)
+{
+  return WriteTextureFile(path, { &chain, 1 });
+}
+
+struct TextureFileView
+{
+  std::shared_ptr<MappedFile> File;
+  const TextureFileHeader* Header;
+  std::span<const TextureFileLevel> Levels;
+
+  bool IsCubemap() const { return Header->FaceCount == 6; }
+
+  const TextureFileLevel& Level(uint32_t level, uint32_t face = 0) const
+  {
+    return Levels[level * Header->FaceCount + face];
+  }
+
+  // points into the map
+  Image ToImage(uint32_t level, uint32_t face = 0) const
+  {
+    auto& entry = Level(level, face);
+    return {
+      static_cast<int>(entry.Width),
+      static_cast<int>(entry.Height),
+      Header->Format,
+      Header->ColorSpace,
+      File->Data() + entry.Offset,
+    };
+  }
+
+  // every level in file order, for gl3::Texture::Create and
+  // gl3::Cubemap::Create without a copy. valid while File is
+  std::vector<Image> Images() const;
+
+  // a copy of a face, e.g. for a TextureStreamer decoder
+  MipChain ToMipChain(uint32_t face = 0) const;
+};
+
+// nullopt if missing or broken. the header, every level size and range are
+// checked, so the levels can be uploaded as they are
+std::optional<TextureFileView>
+OpenTextureFile(const std::string& path);
+
+}
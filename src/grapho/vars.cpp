@@ -1,6 +1,7 @@
 #include <DirectXMath.h>
 
 #include "vars.h"
+#include <stddef.h>
 
 namespace grapho {
 
@@ -37,4 +38,29 @@ LocalVars::CalcNormalMatrix()
   // return mat3;
 }
 
+std::vector<VertexLayout>
+LocalVarsInstanceLayouts(uint32_t location)
+{
+  std::vector<VertexLayout> layouts;
+  auto push = [&layouts, &location](uint32_t offset) {
+    layouts.push_back({
+      .Id = { .AttributeLocation = location++, .Slot = 0 },
+      .Type = ValueType::Float,
+      .Count = 4,
+      .Offset = offset,
+      .Stride = sizeof(LocalVars),
+      .Divisor = 1,
+    });
+  };
+  for (uint32_t row = 0; row < 4; ++row) {
+    push(offsetof(LocalVars, model) + row * 16);
+  }
+  push(offsetof(LocalVars, color));
+  push(offsetof(LocalVars, cutoff));
+  for (uint32_t row = 0; row < 4; ++row) {
+    push(offsetof(LocalVars, normalMatrix) + row * 16);
+  }
+  return layouts;
+}
+
 } // namespace
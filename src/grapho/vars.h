@@ -1,15 +1,21 @@
 #pragma once
+#include "std140.h"
 #include "vertexlayout.h"
+#include <vector>
 
 namespace grapho {
 
+// uniform block EnvVars of the pbr shaders
 struct WorldVars
 {
+  XMFLOAT4X4 projection;
+  XMFLOAT4X4 view;
   XMFLOAT4 lightPositions[4];
   XMFLOAT4 lightColors[4];
   XMFLOAT4 camPos;
 };
 
+// uniform block ModelVars of the pbr shaders. emissiveColor is not used
 struct LocalVars
 {
   XMFLOAT4X4 model;
@@ -22,4 +28,36 @@ struct LocalVars
   void CalcNormalMatrix();
 };
 
+template<>
+struct Std140Layout<WorldVars>
+{
+  static constexpr Std140Member Members[] = {
+    GRAPHO_STD140_MEMBER(WorldVars, projection, Mat4),
+    GRAPHO_STD140_MEMBER(WorldVars, view, Mat4),
+    GRAPHO_STD140_MEMBER(WorldVars, lightPositions, Vec4),
+    GRAPHO_STD140_MEMBER(WorldVars, lightColors, Vec4),
+    GRAPHO_STD140_MEMBER(WorldVars, camPos, Vec4),
+  };
+};
+static_assert(IsStd140(Std140Layout<WorldVars>::Members));
+
+template<>
+struct Std140Layout<LocalVars>
+{
+  static constexpr Std140Member Members[] = {
+    GRAPHO_STD140_MEMBER(LocalVars, model, Mat4),
+    GRAPHO_STD140_MEMBER(LocalVars, color, Vec4),
+    GRAPHO_STD140_MEMBER(LocalVars, cutoff, Vec4),
+    GRAPHO_STD140_MEMBER(LocalVars, normalMatrix, Mat4),
+    GRAPHO_STD140_MEMBER(LocalVars, emissiveColor, Vec3),
+  };
+};
+static_assert(IsStd140(Std140Layout<LocalVars>::Members));
+
+// LocalVars as per instance attributes. Divisor 1, Slot 0.
+// model in location .. location + 3, color + 4, cutoff + 5,
+// normalMatrix + 6 .. + 9. emissiveColor is not included.
+std::vector<VertexLayout>
+LocalVarsInstanceLayouts(uint32_t location = 4);
+
 }
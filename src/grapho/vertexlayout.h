@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <string>
 #include <vector>
 
@@ -50,8 +51,38 @@ enum class ValueType
   UInt8,
   UInt16,
   UInt32,
+  // binary16
+  Half,
+  // one 32 bit word for 4 components. x in the lowest 10 bits, w the top 2.
+  Int2_10_10_10,
+  UInt2_10_10_10,
 };
 
+// bytes of count components
+inline uint32_t
+ValueSize(ValueType type, uint32_t count)
+{
+  switch (type) {
+    case ValueType::Double:
+      return 8 * count;
+    case ValueType::Float:
+    case ValueType::Int32:
+    case ValueType::UInt32:
+      return 4 * count;
+    case ValueType::Int16:
+    case ValueType::UInt16:
+    case ValueType::Half:
+      return 2 * count;
+    case ValueType::Int8:
+    case ValueType::UInt8:
+      return count;
+    case ValueType::Int2_10_10_10:
+    case ValueType::UInt2_10_10_10:
+      return 4;
+  }
+  return 0;
+}
+
 struct VertexId
 {
   uint32_t AttributeLocation;
@@ -68,6 +99,8 @@ struct VertexLayout
   uint32_t Offset;
   uint32_t Stride;
   uint32_t Divisor = 0;
+  // integer types are read as [0, 1] or [-1, 1]
+  bool Normalized = false;
 };
 
 enum class DrawMode
@@ -102,12 +135,26 @@ struct Mesh
 {
   DrawMode Mode = DrawMode::Triangles;
   std::vector<grapho::VertexLayout> Layouts;
+  // VertexLayout::Id.Slot 0
   VertexBuffer Vertices;
+  // Slot 1, 2... same vertex count as Vertices.
+  // e.g. positions in Vertices and the other attributes in Streams[0], so a
+  // depth pass fetches only the positions.
+  std::vector<VertexBuffer> Streams;
   VertexBuffer Indices;
   uint32_t DrawCount() const
   {
     return Indices.Size() ? Indices.Count : Vertices.Count;
   }
+  uint32_t SlotCount() const { return 1 + Streams.size(); }
+  const VertexBuffer& Slot(uint32_t slot) const
+  {
+    return slot == 0 ? Vertices : Streams[slot - 1];
+  }
+  VertexBuffer& Slot(uint32_t slot)
+  {
+    return slot == 0 ? Vertices : Streams[slot - 1];
+  }
 };
 
 template<typename T>
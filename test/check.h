@@ -0,0 +1,9 @@
+#pragma once
+#include <stdio.h>
+
+// prints the failed expression and returns 1 from main
+#define CHECK(EXPR)                                                            \
+  if (!(EXPR)) {                                                               \
+    printf("%s:%d: %s\n", __FILE__, __LINE__, #EXPR);                          \
+    return 1;                                                                  \
+  }
@@ -0,0 +1,58 @@
+#include "check.h"
+#include <grapho/gl3/commandqueue.h>
+
+using namespace grapho::gl3;
+
+static void
+Push(CommandQueue& queue, const DrawItem& item)
+{
+  // Program and Vao are not used by the key. dense ids 0
+  queue.Push(MakeSortKey(item, 0, 0), { .Material = item.Material });
+}
+
+int
+main()
+{
+  CommandQueue queue;
+  auto near = queue.AddMaterial({});
+  auto far = queue.AddMaterial({});
+
+  {
+    // transparent. back to front across materials
+    Push(queue,
+         { .Layer = 1, .Depth = 0.2f, .BackToFront = true, .Material = near });
+    Push(queue,
+         { .Layer = 1, .Depth = 0.8f, .BackToFront = true, .Material = far });
+    queue.Sort();
+    CHECK(queue.Size() == 2);
+    CHECK(queue.Command(0).Material == far);
+    CHECK(queue.Command(1).Material == near);
+    queue.Clear();
+  }
+
+  {
+    // opaque. by state, then front to back
+    Push(queue, { .Layer = 0, .Depth = 0.2f, .Material = far });
+    Push(queue, { .Layer = 0, .Depth = 0.8f, .Material = near });
+    Push(queue, { .Layer = 0, .Depth = 0.1f, .Material = near });
+    queue.Sort();
+    CHECK(queue.Command(0).Material == near);
+    CHECK(queue.Command(1).Material == near);
+    CHECK(queue.Command(2).Material == far);
+    CHECK(queue.Key(0) < queue.Key(1));
+    queue.Clear();
+  }
+
+  {
+    // the layer first
+    Push(queue,
+         { .Layer = 1, .Depth = 0.9f, .BackToFront = true, .Material = far });
+    Push(queue, { .Layer = 0, .Depth = 0.5f, .Material = near });
+    queue.Sort();
+    CHECK(queue.Command(0).Material == near);
+    CHECK(queue.Command(1).Material == far);
+    queue.Clear();
+  }
+
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include "check.h"
+#include <grapho/meshoptimizer.h>
+
+using namespace grapho::mesh;
+
+int
+main()
+{
+  {
+    // less than a triangle
+    uint32_t indices[] = { 0, 1 };
+    for (size_t count = 0; count <= 2; ++count) {
+      auto stats =
+        AnalyzeVertexCache(std::span<const uint32_t>(indices, count), 3);
+      CHECK(stats.VerticesTransformed == 0);
+      CHECK(stats.Acmr == 0);
+      CHECK(stats.Atvr == 0);
+    }
+  }
+
+  {
+    // two triangles sharing an edge
+    uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+    auto stats = AnalyzeVertexCache(indices, 4);
+    CHECK(stats.VerticesTransformed == 4);
+    CHECK(stats.Acmr == 2.0f);
+    CHECK(stats.Atvr == 1.0f);
+  }
+
+  {
+    // a cache of one vertex transforms every index
+    uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+    auto stats = AnalyzeVertexCache(indices, 4, 1);
+    CHECK(stats.VerticesTransformed == 5);
+    CHECK(stats.Acmr == 2.5f);
+    CHECK(stats.Atvr == 1.25f);
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <GL/glew.h>
+
+#include "check.h"
+#include <grapho/gl3/error_check.h>
+#include <grapho/gl3/uniformblock.h>
+
+struct Vec4
+{
+  float Values[4];
+};
+
+struct Mat4
+{
+  float Values[16];
+};
+
+struct TestVars
+{
+  Mat4 view;
+  Vec4 colors[4];
+  float scale;
+  float padding[3];
+};
+
+template<>
+struct grapho::Std140Layout<TestVars>
+{
+  static constexpr Std140Member Members[] = {
+    GRAPHO_STD140_MEMBER(TestVars, view, Mat4),
+    GRAPHO_STD140_MEMBER(TestVars, colors, Vec4),
+    GRAPHO_STD140_MEMBER(TestVars, scale, Float),
+  };
+};
+static_assert(grapho::IsStd140(grapho::Std140Layout<TestVars>::Members));
+
+// as reflected from a std140 "TestVars" block
+static grapho::gl3::UniformBlock
+Std140Block()
+{
+  return {
+    .Name = "TestVars",
+    .DataSize = 144,
+    .Members = {
+      {
+        .Name = "view",
+        .Type = GL_FLOAT_MAT4,
+        .Offset = 0,
+        .ArraySize = 1,
+        .ArrayStride = 0,
+        .MatrixStride = 16,
+        .IsRowMajor = false,
+      },
+      {
+        .Name = "colors",
+        .Type = GL_FLOAT_VEC4,
+        .Offset = 64,
+        .ArraySize = 4,
+        .ArrayStride = 16,
+        .MatrixStride = 0,
+        .IsRowMajor = false,
+      },
+      {
+        .Name = "scale",
+        .Type = GL_FLOAT,
+        .Offset = 128,
+        .ArraySize = 1,
+        .ArrayStride = 0,
+        .MatrixStride = 0,
+        .IsRowMajor = false,
+      },
+    },
+  };
+}
+
+static bool
+Match(const grapho::gl3::UniformBlock& block)
+{
+  return grapho::gl3::MatchUniformBlock(
+    block, grapho::Std140Layout<TestVars>::Members, sizeof(TestVars));
+}
+
+int
+main()
+{
+  CHECK(Match(Std140Block()));
+
+  {
+    // a shared block with the same first offsets
+    auto block = Std140Block();
+    block.Members[1].ArrayStride = 32;
+    CHECK(!Match(block));
+    CHECK(grapho::GetErrorString() ==
+          "TestVars.colors: array stride 32, std140 16");
+  }
+
+  {
+    auto block = Std140Block();
+    block.Members[0].IsRowMajor = true;
+    CHECK(!Match(block));
+  }
+
+  {
+    auto block = Std140Block();
+    block.Members[0].MatrixStride = 32;
+    CHECK(!Match(block));
+  }
+
+  {
+    auto block = Std140Block();
+    block.Members[2].Offset = 132;
+    CHECK(!Match(block));
+  }
+
+  return 0;
+}